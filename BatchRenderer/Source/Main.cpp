@@ -0,0 +1,469 @@
+/*
+  ==============================================================================
+
+    Main.cpp
+
+    Offline batch renderer for DistortionEffectProjectAudioProcessor.
+
+    Runs every audio file in a directory (and its subdirectories) through the
+    plugin and writes the results to another directory with the same layout,
+    without a DAW. Each worker thread has a processor of its own and renders
+    whole files, one after the other.
+
+    WAV and AIFF inputs are memory mapped, everything else is streamed, and
+    both are read in large blocks. Outputs are written block by block as they
+    are rendered, so no file is ever held in memory as a whole. The plugin's
+    latency is compensated, so every output lines up with its input and has
+    the same length.
+
+    The output doesn't depend on the number of threads: every file starts
+    from a freshly prepared processor with exactly the same settings, and
+    nothing in the signal path depends on timing when running offline.
+
+    Options:
+        --input=<dir>           the files to render
+        --output=<dir>          where to write them (created if needed)
+        --state=<file>          settings saved from the plugin (getStateInformation)
+        --preset=<name|index>   a factory or user preset, applied on top of --state
+        --<parameter>=<value>   any parameter by id, in its own units, applied last,
+                                e.g. --drive=18 --threshold=-3 --oversampling=2
+        --threads=<n>           worker threads (default: one per core)
+        --check-threads         render everything again on a single thread and check
+                                that every file comes out byte for byte the same
+        --block=<n>             samples per block (default 16384)
+        --list                  print the parameter ids and presets and exit
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "../../Source/PluginProcessor.h"
+
+#include <chrono>
+#include <iostream>
+
+namespace
+{
+
+//==============================================================================
+void printLine (const String& text)
+{
+    static CriticalSection lock;
+    const ScopedLock sl (lock);
+    std::cout << text << std::endl;
+}
+
+/** Sets up a processor from the command line and returns its state, which every worker then loads. */
+bool createSettings (const ArgumentList& args, MemoryBlock& settings)
+{
+    DistortionEffectProjectAudioProcessor processor;
+
+    if (args.containsOption ("--state"))
+    {
+        MemoryBlock state;
+
+        if (! args.getExistingFileForOption ("--state").loadFileAsData (state))
+        {
+            std::cerr << "Couldn't read " << args.getValueForOption ("--state") << std::endl;
+            return false;
+        }
+
+        processor.setStateInformation (state.getData(), (int) state.getSize());
+    }
+
+    if (args.containsOption ("--preset"))
+    {
+        auto preset = args.getValueForOption ("--preset");
+        int index = -1;
+
+        for (int i = 0; i < processor.getNumPrograms() && index < 0; ++i)
+            if (processor.getProgramName (i).equalsIgnoreCase (preset))
+                index = i;
+
+        if (index < 0 && preset.containsOnly ("0123456789"))
+            index = preset.getIntValue();
+
+        if (index < 0 || index >= processor.getNumPrograms())
+        {
+            std::cerr << "No preset " << preset << std::endl;
+            return false;
+        }
+
+        processor.setCurrentProgram (index);
+    }
+
+    for (auto* parameter : processor.getParameters())
+    {
+        auto* ranged = dynamic_cast<RangedAudioParameter*> (parameter);
+        auto option = "--" + (ranged != nullptr ? ranged->getParameterID() : String());
+
+        if (ranged != nullptr && args.containsOption (option))
+            ranged->setValueNotifyingHost (ranged->convertTo0to1 (args.getValueForOption (option).getFloatValue()));
+    }
+
+    processor.getStateInformation (settings);
+    return true;
+}
+
+void listSettings()
+{
+    DistortionEffectProjectAudioProcessor processor;
+
+    std::cout << "Parameters:" << std::endl;
+
+    for (auto* parameter : processor.getParameters())
+        if (auto* ranged = dynamic_cast<RangedAudioParameter*> (parameter))
+            std::cout << "    --" << ranged->getParameterID() << "    " << ranged->getName (100)
+                      << " (" << ranged->getNormalisableRange().start << " to " << ranged->getNormalisableRange().end
+                      << ", default " << ranged->convertFrom0to1 (ranged->getDefaultValue()) << ")" << std::endl;
+
+    std::cout << "Presets:" << std::endl;
+
+    for (int i = 0; i < processor.getNumPrograms(); ++i)
+        std::cout << "    " << i << "    " << processor.getProgramName (i) << std::endl;
+}
+
+//==============================================================================
+struct RenderJob
+{
+    File input, output;
+};
+
+/** Renders files off a shared list until there are none left. */
+class RenderWorker  : public Thread
+{
+public:
+    RenderWorker (const Array<RenderJob>& jobsToRender, std::atomic<int>& nextJobIndex,
+                  const MemoryBlock& settingsToUse, int samplesPerBlock)
+        : Thread ("Render worker"), jobs (jobsToRender), nextJob (nextJobIndex),
+          settings (settingsToUse), blockSize (samplesPerBlock)
+    {
+        // Created here on the main thread, the value tree state doesn't like being built anywhere else
+        processor = std::make_unique<DistortionEffectProjectAudioProcessor>();
+        processor->setStateInformation (settings.getData(), (int) settings.getSize());
+        processor->setNonRealtime (true);
+        formats.registerBasicFormats();
+    }
+
+    ~RenderWorker() override
+    {
+        stopThread (-1);
+    }
+
+    void run() override
+    {
+        for (;;)
+        {
+            auto index = nextJob.fetch_add (1);
+
+            if (index >= jobs.size() || threadShouldExit())
+                break;
+
+            auto& job = jobs.getReference (index);
+            auto startTime = std::chrono::steady_clock::now();
+            String error;
+            auto seconds = render (job, error);
+            auto elapsed = std::chrono::duration<double> (std::chrono::steady_clock::now() - startTime).count();
+
+            if (error.isNotEmpty())
+            {
+                printLine ("FAILED " + job.input.getFullPathName() + ": " + error);
+                ++numFailed;
+                continue;
+            }
+
+            printLine (job.output.getFullPathName() + "  " + String (seconds, 1) + " s of audio, "
+                         + String (seconds / jmax (1.0e-9, elapsed), 1) + "x real time");
+            audioSeconds += seconds;
+        }
+    }
+
+    double audioSeconds = 0.0;
+    int numFailed = 0;
+
+private:
+    std::unique_ptr<AudioFormatReader> openReader (const File& file)
+    {
+        // WAV and AIFF can be memory mapped: the file is paged in as it's read
+        // rather than copied through a buffer of our own
+        if (auto* format = formats.findFormatForFileExtension (file.getFileExtension()))
+        {
+            std::unique_ptr<MemoryMappedAudioFormatReader> mapped (format->createMemoryMappedReader (file));
+
+            if (mapped != nullptr && mapped->mapEntireFile())
+                return mapped;
+        }
+
+        return std::unique_ptr<AudioFormatReader> (formats.createReaderFor (file));
+    }
+
+    std::unique_ptr<AudioFormatWriter> openWriter (const File& file, const AudioFormatReader& reader)
+    {
+        // The same format as the input if it can be written, WAV otherwise
+        auto* format = formats.findFormatForFileExtension (file.getFileExtension());
+
+        if (format == nullptr || ! format->canDoSampleRate ((int) reader.sampleRate))
+            format = formats.findFormatForFileExtension ("wav");
+
+        auto bitDepths = format->getPossibleBitDepths();
+        auto bits = bitDepths.contains ((int) reader.bitsPerSample) ? (int) reader.bitsPerSample : 24;
+
+        if (file.getParentDirectory().createDirectory().failed() || ! file.deleteFile())
+            return {};
+
+        auto stream = std::make_unique<FileOutputStream> (file);
+
+        if (! stream->openedOk())
+            return {};
+
+        std::unique_ptr<AudioFormatWriter> writer (format->createWriterFor (stream.get(), reader.sampleRate,
+                                                                            (unsigned int) reader.numChannels,
+                                                                            bits, reader.metadataValues, 0));
+        if (writer != nullptr)
+            stream.release();   // the writer owns it now
+
+        return writer;
+    }
+
+    /** Returns the length of the file in seconds, or sets error. */
+    double render (const RenderJob& job, String& error)
+    {
+        auto reader = openReader (job.input);
+
+        if (reader == nullptr)
+        {
+            error = "can't read this file";
+            return 0.0;
+        }
+
+        auto numChannels = (int) reader->numChannels;
+        auto layout = AudioChannelSet::canonicalChannelSet (numChannels);
+
+        if (layout.isDisabled())
+            layout = AudioChannelSet::discreteChannels (numChannels);
+
+        AudioProcessor::BusesLayout buses;
+        buses.inputBuses.add (layout);
+        buses.outputBuses.add (layout);
+
+        if (! processor->setBusesLayout (buses))
+        {
+            error = String (numChannels) + " channels aren't supported";
+            return 0.0;
+        }
+
+        auto writer = openWriter (job.output, *reader);
+
+        if (writer == nullptr)
+        {
+            error = "can't write " + job.output.getFullPathName();
+            return 0.0;
+        }
+
+        // Preparing resets everything that carries over from the previous file
+        processor->setRateAndBufferSizeDetails (reader->sampleRate, blockSize);
+        processor->prepareToPlay (reader->sampleRate, blockSize);
+
+        buffer.setSize (numChannels, blockSize, false, false, true);
+
+        auto length = reader->lengthInSamples;
+        auto latency = (int64) processor->getLatencySamples();
+        int64 readPosition = 0, written = 0;
+
+        // The first `latency` samples out are the filters filling up, and that many
+        // extra samples of silence push the end of the file out
+        while (written < length)
+        {
+            auto numToRead = (int) jmin ((int64) blockSize, jmax ((int64) 0, length - readPosition));
+
+            buffer.clear();
+
+            if (numToRead > 0 && ! reader->read (buffer.getArrayOfWritePointers(), numChannels, readPosition, numToRead))
+            {
+                error = "read error";
+                break;
+            }
+
+            processor->processBlock (buffer, midi);
+
+            auto skip = (int) jlimit ((int64) 0, (int64) blockSize, latency - readPosition);
+            auto numToWrite = (int) jmin ((int64) (blockSize - skip), length - written);
+
+            if (numToWrite > 0 && ! writer->writeFromAudioSampleBuffer (buffer, skip, numToWrite))
+            {
+                error = "write error";
+                break;
+            }
+
+            readPosition += blockSize;
+            written += jmax (0, numToWrite);
+        }
+
+        processor->releaseResources();
+        return error.isEmpty() ? (double) length / reader->sampleRate : 0.0;
+    }
+
+    const Array<RenderJob>& jobs;
+    std::atomic<int>& nextJob;
+    const MemoryBlock& settings;
+    const int blockSize;
+
+    std::unique_ptr<DistortionEffectProjectAudioProcessor> processor;
+    AudioFormatManager formats;
+    AudioBuffer<float> buffer;
+    MidiBuffer midi;
+
+    JUCE_DECLARE_NON_COPYABLE (RenderWorker)
+};
+
+//==============================================================================
+struct RenderResult
+{
+    double audioSeconds = 0.0, elapsedSeconds = 0.0;
+    int numFailed = 0;
+};
+
+/** Renders every job on numThreads workers, writing to each job's output. */
+RenderResult renderAll (const Array<RenderJob>& jobs, const MemoryBlock& settings, int blockSize, int numThreads)
+{
+    std::atomic<int> nextJob { 0 };
+    OwnedArray<RenderWorker> workers;
+
+    for (int i = 0; i < numThreads; ++i)
+        workers.add (new RenderWorker (jobs, nextJob, settings, blockSize));
+
+    auto startTime = std::chrono::steady_clock::now();
+
+    for (auto* worker : workers)
+        worker->startThread();
+
+    for (auto* worker : workers)
+        worker->waitForThreadToExit (-1);
+
+    RenderResult result;
+    result.elapsedSeconds = std::chrono::duration<double> (std::chrono::steady_clock::now() - startTime).count();
+
+    for (auto* worker : workers)
+    {
+        result.audioSeconds += worker->audioSeconds;
+        result.numFailed += worker->numFailed;
+    }
+
+    return result;
+}
+
+/** Renders the jobs again on one thread, into a temporary directory, and returns how many
+    of them came out different from what's already in their outputs.
+*/
+int checkAgainstSingleThread (const Array<RenderJob>& jobs, const File& outputDirectory,
+                              const MemoryBlock& settings, int blockSize)
+{
+    auto checkDirectory = File::getSpecialLocation (File::tempDirectory).getNonexistentChildFile ("DistortionBatchRenderer", {});
+    Array<RenderJob> checkJobs;
+
+    for (auto& job : jobs)
+        checkJobs.add ({ job.input, checkDirectory.getChildFile (job.output.getRelativePathFrom (outputDirectory)) });
+
+    printLine ("Rendering again on a single thread to " + checkDirectory.getFullPathName());
+    renderAll (checkJobs, settings, blockSize, 1);
+
+    int numDifferent = 0;
+
+    for (int i = 0; i < jobs.size(); ++i)
+    {
+        auto& output = jobs.getReference (i).output;
+
+        if (! output.hasIdenticalContentTo (checkJobs.getReference (i).output))
+        {
+            std::cerr << "DIFFERS " << output.getFullPathName() << std::endl;
+            ++numDifferent;
+        }
+    }
+
+    checkDirectory.deleteRecursively();
+    return numDifferent;
+}
+
+} // namespace
+
+//==============================================================================
+int main (int argc, char* argv[])
+{
+    ScopedJuceInitialiser_GUI juceInitialiser;
+
+    ArgumentList args (argc, argv);
+
+    if (args.containsOption ("--list"))
+    {
+        listSettings();
+        return 0;
+    }
+
+    if (! args.containsOption ("--input") || ! args.containsOption ("--output"))
+    {
+        std::cerr << "Usage: DistortionBatchRenderer --input=<dir> --output=<dir> [--state=<file>] [--preset=<name>]"
+                     " [--<parameter>=<value>...] [--threads=<n>] [--block=<n>] [--check-threads] [--list]" << std::endl;
+        return 1;
+    }
+
+    auto inputDirectory = args.getExistingFolderForOption ("--input");
+    auto outputDirectory = args.getFileForOption ("--output");
+
+    auto numThreads = args.containsOption ("--threads") ? args.getValueForOption ("--threads").getIntValue()
+                                                        : SystemStats::getNumCpus();
+    auto blockSize = args.containsOption ("--block") ? args.getValueForOption ("--block").getIntValue() : 16384;
+    blockSize = jlimit (64, 1 << 20, blockSize);
+
+    MemoryBlock settings;
+
+    if (! createSettings (args, settings))
+        return 1;
+
+    // Every readable audio file, in a fixed order so runs are easy to compare
+    AudioFormatManager formats;
+    formats.registerBasicFormats();
+
+    Array<RenderJob> jobs;
+
+    for (auto& entry : RangedDirectoryIterator (inputDirectory, true, formats.getWildcardForAllFormats(), File::findFiles))
+    {
+        auto input = entry.getFile();
+        jobs.add ({ input, outputDirectory.getChildFile (input.getRelativePathFrom (inputDirectory)) });
+    }
+
+    std::sort (jobs.begin(), jobs.end(), [] (const RenderJob& a, const RenderJob& b)
+    {
+        return a.input.getFullPathName() < b.input.getFullPathName();
+    });
+
+    if (jobs.isEmpty())
+    {
+        std::cerr << "No audio files in " << inputDirectory.getFullPathName() << std::endl;
+        return 1;
+    }
+
+    // More threads than files would only cost the extra processors
+    numThreads = jlimit (1, jobs.size(), numThreads);
+
+    auto result = renderAll (jobs, settings, blockSize, numThreads);
+
+    printLine (String (jobs.size() - result.numFailed) + " files, " + String (result.audioSeconds, 1) + " s of audio in "
+                 + String (result.elapsedSeconds, 1) + " s on " + String (numThreads) + " threads ("
+                 + String (result.audioSeconds / jmax (1.0e-9, result.elapsedSeconds), 1) + "x real time)");
+
+    if (result.numFailed > 0)
+        return 1;
+
+    if (args.containsOption ("--check-threads"))
+    {
+        auto numDifferent = checkAgainstSingleThread (jobs, outputDirectory, settings, blockSize);
+
+        printLine (numDifferent == 0 ? "All files match the single threaded render"
+                                     : String (numDifferent) + " files differ from the single threaded render");
+
+        if (numDifferent > 0)
+            return 1;
+    }
+
+    return 0;
+}
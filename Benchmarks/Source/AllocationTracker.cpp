@@ -0,0 +1,116 @@
+/*
+  ==============================================================================
+
+    AllocationTracker.cpp
+
+  ==============================================================================
+*/
+
+#include "AllocationTracker.h"
+
+#include <cerrno>
+#include <cstdlib>
+#include <new>
+
+namespace
+{
+    // Constant initialised, so reading it never allocates or runs a constructor
+    thread_local int64* currentCount = nullptr;
+
+    inline void countCall() noexcept
+    {
+        if (auto* count = currentCount)
+            ++*count;
+    }
+}
+
+namespace AllocationTracker
+{
+    ScopedCheck::ScopedCheck (bool shouldBeEnabled) noexcept
+        : enabled (shouldBeEnabled)
+    {
+        if (enabled)
+        {
+            previous = currentCount;
+            currentCount = &count;
+        }
+    }
+
+    ScopedCheck::~ScopedCheck() noexcept
+    {
+        if (enabled)
+            currentCount = previous;
+    }
+
+   #if defined (__GLIBC__)
+    bool isCatchingMalloc() noexcept    { return true; }
+   #else
+    bool isCatchingMalloc() noexcept    { return false; }
+   #endif
+}
+
+//==============================================================================
+#if defined (__GLIBC__)
+
+// glibc lets the executable define the malloc family itself and exports its own
+// versions under these names, so everything in the process goes through here.
+// operator new and delete end up in malloc and free.
+extern "C"
+{
+    void* __libc_malloc (size_t);
+    void* __libc_calloc (size_t, size_t);
+    void* __libc_realloc (void*, size_t);
+    void* __libc_memalign (size_t, size_t);
+    void __libc_free (void*);
+
+    void* malloc (size_t size)                      { countCall(); return __libc_malloc (size); }
+    void* calloc (size_t count, size_t size)        { countCall(); return __libc_calloc (count, size); }
+    void* realloc (void* pointer, size_t size)      { countCall(); return __libc_realloc (pointer, size); }
+    void* memalign (size_t alignment, size_t size)  { countCall(); return __libc_memalign (alignment, size); }
+    void* aligned_alloc (size_t alignment, size_t size)     { countCall(); return __libc_memalign (alignment, size); }
+
+    int posix_memalign (void** result, size_t alignment, size_t size)
+    {
+        countCall();
+        *result = __libc_memalign (alignment, size);
+        return *result != nullptr || size == 0 ? 0 : ENOMEM;
+    }
+
+    void free (void* pointer)
+    {
+        if (pointer != nullptr)
+            countCall();
+
+        __libc_free (pointer);
+    }
+}
+
+#else
+
+void* operator new (size_t size)
+{
+    countCall();
+
+    if (auto* pointer = std::malloc (size == 0 ? 1 : size))
+        return pointer;
+
+    throw std::bad_alloc();
+}
+
+void* operator new[] (size_t size)                                  { return operator new (size); }
+void* operator new (size_t size, const std::nothrow_t&) noexcept    { countCall(); return std::malloc (size == 0 ? 1 : size); }
+void* operator new[] (size_t size, const std::nothrow_t&) noexcept  { countCall(); return std::malloc (size == 0 ? 1 : size); }
+
+void operator delete (void* pointer) noexcept
+{
+    if (pointer != nullptr)
+        countCall();
+
+    std::free (pointer);
+}
+
+void operator delete[] (void* pointer) noexcept                     { operator delete (pointer); }
+void operator delete (void* pointer, size_t) noexcept               { operator delete (pointer); }
+void operator delete[] (void* pointer, size_t) noexcept             { operator delete (pointer); }
+
+#endif
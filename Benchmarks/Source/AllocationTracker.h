@@ -0,0 +1,44 @@
+/*
+  ==============================================================================
+
+    AllocationTracker.h
+
+    Counts heap allocations and frees made by one thread during a scope, for
+    the benchmark's --check-allocations mode: every processBlock call is
+    wrapped in a ScopedCheck, and any count above zero fails the run.
+
+    The benchmark replaces the global allocation functions to do this (see
+    AllocationTracker.cpp): with glibc the whole malloc family, which also
+    catches allocations made from C code and inside JUCE, elsewhere operator
+    new and delete. Outside a ScopedCheck they cost one thread local read.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+using namespace juce;
+
+namespace AllocationTracker
+{
+    /** Counts what this thread allocates or frees while it exists, if enabled. */
+    class ScopedCheck
+    {
+    public:
+        explicit ScopedCheck (bool enabled) noexcept;
+        ~ScopedCheck() noexcept;
+
+        int64 getCount() const noexcept     { return count; }
+
+    private:
+        int64 count = 0;
+        int64* previous = nullptr;
+        bool enabled;
+
+        JUCE_DECLARE_NON_COPYABLE (ScopedCheck)
+    };
+
+    /** True if this build catches C allocations as well as operator new. */
+    bool isCatchingMalloc() noexcept;
+}
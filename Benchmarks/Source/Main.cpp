@@ -0,0 +1,1350 @@
+/*
+  ==============================================================================
+
+    Main.cpp
+
+    Benchmark for DistortionEffectProjectAudioProcessor.
+
+    Drives processBlock with a synthetic signal across block sizes, channel
+    counts, sample rates, parameter automation patterns and processing modes,
+    and prints one JSON object per case on stdout:
+
+        ns per sample per channel, p50/p99 block time, real-time headroom
+        (how many times faster than real time the p99 block is)
+
+    The limiter/... cases time the true peak limiter pushed by +12 dB of
+    Output Level, next to the same settings without it, for both curves.
+
+    The cabinet/... cases run a synthetic cabinet IR of 50 ms to 2 s after
+    the distortion, to show how the convolution's cost grows with its length.
+
+    The aliasing/... cases also get a spectrum line with how far the aliasing
+    sits below the harmonics of a hard driven 2.5 kHz sine, for the plain,
+    oversampled and ADAA paths.
+
+    The mix/... lines check that the dry/wet mix doesn't comb filter: with
+    the curve in its straight part, the group delay has to be flat and no
+    more than half a sample beyond the reported latency. Oversampled, the
+    dry path has to follow ADAA's delay to within a hundredth of a sample.
+    If it doesn't, the exit code is 1.
+
+    The bands/.../sum lines check that the crossovers sum flat: with every
+    band at its neutral setting, 2, 3 and 4 bands have to match the single
+    band path to 0.01 dB, and add exactly the group delay of the crossovers'
+    allpasses to within a hundredth of a sample. Otherwise the exit code is 1.
+
+    Then times saving and restoring the plugin state (state/... cases),
+    program changes and the preset bank (presets/... cases), what a hundred
+    instances in one process save by sharing (sharing/... cases), and opens the
+    editor off screen to report how long that takes and what
+    painting it costs (editor/... cases), both in microseconds.
+
+    With --check-allocations every processBlock call is also watched for heap
+    allocations (see AllocationTracker.h), each case reports how many it saw,
+    and an allocations/... sweep runs every combination of the quality, mode,
+    cabinet and limiter parameters with random parameter jumps between blocks,
+    in both precisions. Any allocation at all fails the run.
+
+    Options:
+        --quick                 shorter runs and fewer cases, for CI
+        --seconds=<n>           audio processed per case (default 2)
+        --filter=<text>         only run cases whose name contains <text>
+        --baseline=<file>       compare against an earlier run's output and
+                                exit with 1 if any case got slower than
+        --tolerance=<ratio>     this ratio of its baseline (default 1.15)
+        --check-allocations     exit with 1 if processBlock ever allocates
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "../../Source/PluginProcessor.h"
+#include "../../Source/MeterDisplay.h"
+#include "AllocationTracker.h"
+
+#include <chrono>
+#include <complex>
+#include <iostream>
+#include <map>
+#include <numeric>
+
+namespace
+{
+
+//==============================================================================
+struct BenchmarkCase
+{
+    String name;
+    double sampleRate = 48000.0;
+    int blockSize = 512;
+    int numChannels = 2;
+    String automation = "static";   // "static", "ramp" or "jumps"
+    int accuracy = 1;               // index of the "accuracy" parameter
+    int oversampling = 0;           // index of the "oversampling" parameter
+    int osFilter = 0;               // index of the "osFilter" parameter
+    int bands = 0;                  // index of the "bands" parameter, 0 = off
+    int antialiasing = 0;           // index of the "antialiasing" parameter, 0 = off
+    double cabinetSeconds = 0.0;    // length of the cabinet IR, 0 = no cabinet
+    bool limiter = false;           // the output limiter, with Output Level at +12 dB to keep it busy
+    bool doublePrecision = false;
+    String state = "active";        // "active", "metered" (editor open), "silent" (zero input), "dryOnly" (wet = 0) or "bypassed"
+};
+
+struct BenchmarkResult
+{
+    double nsPerSample = 0.0;
+    double p50Micros = 0.0;
+    double p99Micros = 0.0;
+    double headroom = 0.0;
+    double realtimeFactor = 0.0;
+    int64 allocations = -1;         // made by processBlock, -1 = not checked
+};
+
+//==============================================================================
+void setParameter (DistortionEffectProjectAudioProcessor& processor, const String& id, float value)
+{
+    if (auto* parameter = processor.treeState.getParameter (id))
+        parameter->setValueNotifyingHost (parameter->convertTo0to1 (value));
+}
+
+void applyAutomation (DistortionEffectProjectAudioProcessor& processor, const String& automation,
+                      double timeInSeconds, Random& random)
+{
+    if (automation == "ramp")
+    {
+        // A slow sweep, like a drawn automation curve
+        auto phase = (float) std::sin (MathConstants<double>::twoPi * timeInSeconds * 0.5);
+        setParameter (processor, "drive", 15.0f + 15.0f * phase);
+        setParameter (processor, "threshold", -8.5f + 11.5f * phase);
+    }
+    else if (automation == "jumps")
+    {
+        // New values on every block, so the ramps never settle
+        setParameter (processor, "drive", random.nextFloat() * 30.0f);
+        setParameter (processor, "threshold", -20.0f + random.nextFloat() * 23.0f);
+        setParameter (processor, "wet", random.nextFloat() * 100.0f);
+    }
+}
+
+/** A mix of a sine sweep and noise at about -6 dBFS, different on every channel. */
+template <typename SampleType>
+AudioBuffer<SampleType> createTestSignal (int numChannels, double sampleRate)
+{
+    auto numSamples = (int) sampleRate;
+    AudioBuffer<SampleType> signal (numChannels, numSamples);
+    Random random (1234);
+
+    for (int channel = 0; channel < numChannels; ++channel)
+    {
+        auto* data = signal.getWritePointer (channel);
+        double phase = 0.0;
+
+        for (int i = 0; i < numSamples; ++i)
+        {
+            auto frequency = 50.0 * std::pow (200.0, (double) i / numSamples) * (1.0 + 0.01 * channel);
+            phase += MathConstants<double>::twoPi * frequency / sampleRate;
+            data[i] = (SampleType) (0.4 * std::sin (phase) + 0.1 * (random.nextDouble() * 2.0 - 1.0));
+        }
+    }
+
+    return signal;
+}
+
+/** Writes an exponentially decaying noise burst, about what a cabinet IR looks like. */
+bool writeImpulseResponse (const File& file, double lengthInSeconds, double sampleRate)
+{
+    auto numSamples = jmax (1, (int) (lengthInSeconds * sampleRate));
+    AudioBuffer<float> impulseResponse (2, numSamples);
+    Random random (99);
+
+    for (int channel = 0; channel < 2; ++channel)
+        for (int i = 0; i < numSamples; ++i)
+            impulseResponse.setSample (channel, i, (random.nextFloat() * 2.0f - 1.0f)
+                                                     * std::exp (-6.9f * (float) i / (float) numSamples));
+
+    WavAudioFormat format;
+    std::unique_ptr<AudioFormatWriter> writer (format.createWriterFor (new FileOutputStream (file), sampleRate,
+                                                                       2, 24, {}, 0));
+
+    return writer != nullptr && writer->writeFromAudioSampleBuffer (impulseResponse, 0, numSamples);
+}
+
+//==============================================================================
+template <typename SampleType>
+BenchmarkResult runCase (const BenchmarkCase& c, double secondsOfAudio, bool checkAllocations)
+{
+    DistortionEffectProjectAudioProcessor processor;
+
+    AudioProcessor::BusesLayout layout;
+    auto channelSet = AudioChannelSet::canonicalChannelSet (c.numChannels);
+
+    if (channelSet.isDisabled())
+        channelSet = AudioChannelSet::discreteChannels (c.numChannels);
+
+    layout.inputBuses.add (channelSet);
+    layout.outputBuses.add (channelSet);
+
+    if (! processor.setBusesLayout (layout))
+        return {};
+
+    setParameter (processor, "drive", 18.0f);
+    setParameter (processor, "threshold", -3.0f);
+    setParameter (processor, "accuracy", (float) c.accuracy);
+    setParameter (processor, "oversampling", (float) c.oversampling);
+    setParameter (processor, "osFilter", (float) c.osFilter);
+    setParameter (processor, "bands", (float) c.bands);
+    setParameter (processor, "antialiasing", (float) c.antialiasing);
+    setParameter (processor, "autoQuality", 0.0f);     // each case times the settings it names
+
+    if (c.state == "dryOnly")
+        setParameter (processor, "wet", 0.0f);
+
+    if (c.limiter)
+    {
+        setParameter (processor, "outputLvl", 12.0f);
+        setParameter (processor, "limiter", 1.0f);
+    }
+
+    // As if an editor were open. Nobody reads the meter FIFO here, so once it's
+    // full the frames are dropped - which is what happens with a stalled editor.
+    processor.getMeterSource().setEnabled (c.state == "metered");
+
+    // Through a file, like a user's IR. prepareToPlay loads it before the first block.
+    TemporaryFile impulseResponse (".wav");
+
+    if (c.cabinetSeconds > 0.0)
+    {
+        if (! writeImpulseResponse (impulseResponse.getFile(), c.cabinetSeconds, c.sampleRate))
+            return {};
+
+        processor.loadCabinet (impulseResponse.getFile());
+    }
+
+    processor.setProcessingPrecision (std::is_same_v<SampleType, double> ? AudioProcessor::doublePrecision
+                                                                         : AudioProcessor::singlePrecision);
+    processor.setRateAndBufferSizeDetails (c.sampleRate, c.blockSize);
+    processor.prepareToPlay (c.sampleRate, c.blockSize);
+
+    auto signal = createTestSignal<SampleType> (c.numChannels, c.sampleRate);
+
+    if (c.state == "silent")
+        signal.clear();
+    AudioBuffer<SampleType> buffer (c.numChannels, c.blockSize);
+    MidiBuffer midi;
+    Random random (42);
+
+    auto numBlocks = jmax (50, (int) (secondsOfAudio * c.sampleRate) / c.blockSize);
+    auto numWarmupBlocks = jmax (5, numBlocks / 10);
+
+    std::vector<double> blockTimes;
+    blockTimes.reserve ((size_t) numBlocks);
+
+    int position = 0;
+    int64 allocations = 0;
+
+    for (int block = 0; block < numWarmupBlocks + numBlocks; ++block)
+    {
+        for (int channel = 0; channel < c.numChannels; ++channel)
+        {
+            for (int i = 0; i < c.blockSize; ++i)
+                buffer.setSample (channel, i, signal.getSample (channel, (position + i) % signal.getNumSamples()));
+        }
+
+        position = (position + c.blockSize) % signal.getNumSamples();
+        applyAutomation (processor, c.automation, block * c.blockSize / c.sampleRate, random);
+
+        // The warm-up blocks count too: the first block mustn't allocate either
+        AllocationTracker::ScopedCheck check (checkAllocations);
+
+        auto startTime = std::chrono::steady_clock::now();
+        if (c.state == "bypassed")
+            processor.processBlockBypassed (buffer, midi);
+        else
+            processor.processBlock (buffer, midi);
+
+        auto endTime = std::chrono::steady_clock::now();
+        allocations += check.getCount();
+
+        if (block >= numWarmupBlocks)
+            blockTimes.push_back (std::chrono::duration<double, std::micro> (endTime - startTime).count());
+    }
+
+    processor.releaseResources();
+
+    auto totalMicros = std::accumulate (blockTimes.begin(), blockTimes.end(), 0.0);
+    std::sort (blockTimes.begin(), blockTimes.end());
+
+    auto percentile = [&] (double p) { return blockTimes[(size_t) (p * (double) (blockTimes.size() - 1))]; };
+    auto blockDurationMicros = 1.0e6 * c.blockSize / c.sampleRate;
+    auto numSamplesProcessed = (double) numBlocks * c.blockSize * c.numChannels;
+
+    BenchmarkResult result;
+    result.nsPerSample    = 1000.0 * totalMicros / numSamplesProcessed;
+    result.p50Micros      = percentile (0.5);
+    result.p99Micros      = percentile (0.99);
+    result.headroom       = blockDurationMicros / jmax (1.0e-9, result.p99Micros);
+    result.realtimeFactor = blockDurationMicros * numBlocks / jmax (1.0e-9, totalMicros);
+    result.allocations    = checkAllocations ? allocations : -1;
+    return result;
+}
+
+BenchmarkResult runCase (const BenchmarkCase& c, double secondsOfAudio, bool checkAllocations = false)
+{
+    return c.doublePrecision ? runCase<double> (c, secondsOfAudio, checkAllocations)
+                             : runCase<float>  (c, secondsOfAudio, checkAllocations);
+}
+
+String toJson (const BenchmarkCase& c, const BenchmarkResult& r)
+{
+    auto* object = new DynamicObject();
+    object->setProperty ("case", c.name);
+    object->setProperty ("sampleRate", c.sampleRate);
+    object->setProperty ("blockSize", c.blockSize);
+    object->setProperty ("channels", c.numChannels);
+    object->setProperty ("automation", c.automation);
+    object->setProperty ("accuracy", c.accuracy);
+    object->setProperty ("oversampling", 1 << c.oversampling);
+    object->setProperty ("osFilter", c.osFilter == 0 ? "iir" : "fir");
+    object->setProperty ("bands", c.bands == 0 ? 1 : c.bands + 1);
+    object->setProperty ("antialiasing", c.antialiasing == 0 ? "off" : "adaa" + String (c.antialiasing));
+    object->setProperty ("cabinetSeconds", c.cabinetSeconds);
+    object->setProperty ("limiter", c.limiter);
+    object->setProperty ("precision", c.doublePrecision ? "double" : "float");
+    object->setProperty ("state", c.state);
+    object->setProperty ("instructionSet", WaveshaperKernel::getName (WaveshaperKernel::getInstructionSet()));
+    object->setProperty ("nsPerSample", r.nsPerSample);
+    object->setProperty ("p50BlockMicros", r.p50Micros);
+    object->setProperty ("p99BlockMicros", r.p99Micros);
+    object->setProperty ("headroom", r.headroom);
+    object->setProperty ("realtimeFactor", r.realtimeFactor);
+
+    if (r.allocations >= 0)
+        object->setProperty ("allocations", r.allocations);
+
+    return JSON::toString (var (object), true, 4);
+}
+
+//==============================================================================
+/** Every way of keeping the aliasing down: none, oversampling, ADAA and both. */
+Array<BenchmarkCase> createAliasingCases()
+{
+    Array<BenchmarkCase> cases;
+
+    auto add = [&] (int antialiasing, int oversampling)
+    {
+        BenchmarkCase c;
+        c.accuracy = 0;
+        c.antialiasing = antialiasing;
+        c.oversampling = oversampling;
+        c.name = "aliasing/" + (antialiasing == 0 ? String ("plain") : "adaa" + String (antialiasing))
+                   + "/os" + String (1 << oversampling);
+        cases.add (c);
+    };
+
+    for (int oversampling = 0; oversampling <= OversamplingOptions::maxFactorIndex; ++oversampling)
+        add (0, oversampling);
+
+    for (int antialiasing = 1; antialiasing <= 2; ++antialiasing)
+        for (int oversampling : { 0, 1 })
+            add (antialiasing, oversampling);
+
+    return cases;
+}
+
+/** Drives a 2.5 kHz sine hard and returns everything in the output that isn't one of its
+    harmonics - i.e. what folded back from above Nyquist - relative to the harmonics, in dB.
+    The sine repeats exactly every FFT frame, so every harmonic lands on a single bin and
+    no window is needed.
+*/
+double measureAliasing (const BenchmarkCase& c)
+{
+    constexpr int fftOrder = 16;
+    constexpr int fftSize = 1 << fftOrder;
+    constexpr int cycles = 3413;        // odd, so no harmonic or alias ever shares a bin
+    constexpr int blockSize = 512;
+    constexpr int settleSamples = 16384;
+
+    DistortionEffectProjectAudioProcessor processor;
+
+    AudioProcessor::BusesLayout layout;
+    layout.inputBuses.add (AudioChannelSet::mono());
+    layout.outputBuses.add (AudioChannelSet::mono());
+    processor.setBusesLayout (layout);
+    processor.setRateAndBufferSizeDetails (c.sampleRate, blockSize);
+
+    setParameter (processor, "drive", 24.0f);
+    setParameter (processor, "threshold", -6.0f);
+    setParameter (processor, "wet", 100.0f);
+    setParameter (processor, "dry", 0.0f);
+    setParameter (processor, "accuracy", (float) c.accuracy);
+    setParameter (processor, "oversampling", (float) c.oversampling);
+    setParameter (processor, "osFilter", (float) c.osFilter);
+    setParameter (processor, "antialiasing", (float) c.antialiasing);
+    setParameter (processor, "autoQuality", 0.0f);
+    processor.prepareToPlay (c.sampleRate, blockSize);
+
+    std::vector<float> output ((size_t) fftSize * 2, 0.0f);
+    AudioBuffer<float> buffer (1, blockSize);
+    MidiBuffer midi;
+
+    for (int position = 0; position < settleSamples + fftSize; position += blockSize)
+    {
+        for (int i = 0; i < blockSize; ++i)
+            buffer.setSample (0, i, 0.5f * (float) std::sin (MathConstants<double>::twoPi * cycles * (position + i) / fftSize));
+
+        processor.processBlock (buffer, midi);
+
+        for (int i = 0; i < blockSize; ++i)
+            if (position + i >= settleSamples)
+                output[(size_t) (position + i - settleSamples)] = buffer.getSample (0, i);
+    }
+
+    processor.releaseResources();
+
+    dsp::FFT fft (fftOrder);
+    fft.performFrequencyOnlyForwardTransform (output.data(), true);
+
+    double harmonics = 0.0, aliases = 0.0;
+
+    for (int bin = 1; bin < fftSize / 2; ++bin)
+    {
+        auto energy = (double) output[(size_t) bin] * (double) output[(size_t) bin];
+        (bin % cycles == 0 ? harmonics : aliases) += energy;
+    }
+
+    return 10.0 * std::log10 (jmax (1.0e-30, aliases) / jmax (1.0e-30, harmonics));
+}
+
+//==============================================================================
+struct FrequencyResponse
+{
+    int latency = 0;                    // as reported by the plugin
+    std::vector<double> magnitudes;     // as a gain, for a -40 dBFS impulse coming out at -40 dBFS
+    std::vector<double> groupDelays;    // in samples, on top of the latency
+};
+
+/** Sends a -40 dBFS impulse through the plugin, at the default Drive of 0 dB where tanh is
+    a straight line to within a few parts in 100000, and returns the magnitude and group
+    delay at numFrequencies points up to maxOmega (in radians per sample). wet and dry are
+    in percent, oversampling runs with the linear phase filter, bands is the Bands choice
+    (0 = Off) with every band at its neutral default.
+*/
+FrequencyResponse measureFrequencyResponse (int antialiasing, int oversampling, int bands, float wet, float dry,
+                                            double maxOmega, int numFrequencies)
+{
+    constexpr double sampleRate = 48000.0;
+    constexpr int blockSize = 4096;
+    constexpr int impulsePosition = 64;
+
+    DistortionEffectProjectAudioProcessor processor;
+
+    AudioProcessor::BusesLayout layout;
+    layout.inputBuses.add (AudioChannelSet::mono());
+    layout.outputBuses.add (AudioChannelSet::mono());
+    processor.setBusesLayout (layout);
+    processor.setRateAndBufferSizeDetails (sampleRate, blockSize);
+
+    setParameter (processor, "accuracy", 0.0f);
+    setParameter (processor, "antialiasing", (float) antialiasing);
+    setParameter (processor, "oversampling", (float) oversampling);
+    setParameter (processor, "osFilter", 1.0f);
+    setParameter (processor, "wet", wet);
+    setParameter (processor, "dry", dry);
+    setParameter (processor, "bands", (float) bands);
+    setParameter (processor, "autoQuality", 0.0f);
+    processor.prepareToPlay (sampleRate, blockSize);
+
+    AudioBuffer<float> buffer (1, blockSize);
+    MidiBuffer midi;
+    buffer.clear();
+    buffer.setSample (0, impulsePosition, 0.01f);
+    processor.processBlock (buffer, midi);
+
+    FrequencyResponse result;
+    result.latency = processor.getLatencySamples();
+    processor.releaseResources();
+
+    // The group delay is the real part of the transform of n h[n] over the transform of h[n]
+    for (int k = 1; k <= numFrequencies; ++k)
+    {
+        auto omega = maxOmega * k / numFrequencies;
+        std::complex<double> response, weighted;
+
+        for (int i = 0; i < blockSize; ++i)
+        {
+            auto n = (double) (i - impulsePosition - result.latency);
+            auto term = (double) buffer.getSample (0, i) * std::polar (1.0, -omega * n);
+            response += term;
+            weighted += n * term;
+        }
+
+        result.magnitudes.push_back (std::abs (response) / 0.01);
+        result.groupDelays.push_back ((weighted / response).real());
+    }
+
+    return result;
+}
+
+struct MixResponse
+{
+    int latency = 0;                // as reported by the plugin
+    double groupDelay = 0.0;        // on top of the latency, averaged over the band
+    double spread = 0.0;            // how far the group delay strays across the band
+};
+
+/** At the default 50 % wet and dry the mix should come out as one signal with a flat group
+    delay. A dry path that isn't delayed as much as the wet one adds up with it a fraction of
+    a sample apart, and the group delay then wanders across the band - the sign of a comb
+    filter. Measured at the host rate up to 90 % of Nyquist.
+*/
+MixResponse measureMixResponse (int antialiasing)
+{
+    auto response = measureFrequencyResponse (antialiasing, 0, 0, 50.0f, 50.0f, 0.9 * MathConstants<double>::pi, 450);
+    auto& delays = response.groupDelays;
+
+    MixResponse result;
+    result.latency = response.latency;
+
+    auto range = Range<double>::findMinAndMax (delays.data(), (int) delays.size());
+    result.groupDelay = std::accumulate (delays.begin(), delays.end(), 0.0) / (double) delays.size();
+    result.spread = range.getLength();
+    return result;
+}
+
+/** Oversampled, the filters' own phase is only matched by the dry delay to within a fraction
+    of a sample, so a mix isn't flat even without ADAA. What ADAA adds has to show up in the
+    dry path as well, though: returns how far the wet path's lead over the dry one moves when
+    ADAA is switched on, at most, up to an eighth of the sample rate.
+*/
+double measureOversampledDryMismatch (int antialiasing, int oversampling)
+{
+    constexpr int numFrequencies = 100;
+    const auto maxOmega = 0.25 * MathConstants<double>::pi;
+
+    auto wet = measureFrequencyResponse (antialiasing, oversampling, 0, 50.0f, 0.0f, maxOmega, numFrequencies).groupDelays;
+    auto dry = measureFrequencyResponse (antialiasing, oversampling, 0, 0.0f, 50.0f, maxOmega, numFrequencies).groupDelays;
+    auto plainWet = measureFrequencyResponse (0, oversampling, 0, 50.0f, 0.0f, maxOmega, numFrequencies).groupDelays;
+    auto plainDry = measureFrequencyResponse (0, oversampling, 0, 0.0f, 50.0f, maxOmega, numFrequencies).groupDelays;
+
+    auto mismatch = 0.0;
+
+    for (int k = 0; k < numFrequencies; ++k)
+        mismatch = jmax (mismatch, std::abs ((wet[(size_t) k] - dry[(size_t) k]) - (plainWet[(size_t) k] - plainDry[(size_t) k])));
+
+    return mismatch;
+}
+
+/** What the bands should add up to: a 4th order Linkwitz-Riley pair sums to the 2nd order
+    Butterworth allpass at its crossover, and the allpass copies give every band all of them.
+    The filters are the bilinear transform with the cutoff prewarped, so this is exact.
+    Returns the group delay in samples at omega.
+*/
+double getCrossoverGroupDelay (const Array<double>& crossovers, double sampleRate, double omega)
+{
+    auto delay = 0.0;
+
+    for (auto frequency : crossovers)
+    {
+        // An allpass's numerator is its denominator backwards, so it delays by
+        // the order minus twice what the denominator on its own would
+        auto k = std::tan (MathConstants<double>::pi * frequency / sampleRate);
+        const double denominator[] { 1.0 + MathConstants<double>::sqrt2 * k + k * k,
+                                     2.0 * (k * k - 1.0),
+                                     1.0 - MathConstants<double>::sqrt2 * k + k * k };
+        std::complex<double> response, weighted;
+
+        for (int n = 0; n < 3; ++n)
+        {
+            auto term = denominator[n] * std::polar (1.0, -omega * n);
+            response += term;
+            weighted += (double) n * term;
+        }
+
+        delay += 2.0 - 2.0 * (weighted / response).real();
+    }
+
+    return delay;
+}
+
+struct CrossoverSum
+{
+    double magnitudeError = 0.0;    // in dB, the most the bands' sum strays from the single band path
+    double delayError = 0.0;        // in samples, the most its group delay strays from the allpasses'
+};
+
+/** With every band at its neutral setting and the curve in its straight part, the bands have
+    to sum back to the input through the crossovers' allpasses: a flat magnitude, and the
+    group delay of the allpasses on top of the single band path's. Compared against that
+    path at the same settings, up to 90 % of Nyquist at the default crossover frequencies.
+*/
+CrossoverSum measureCrossoverSum (int bands)
+{
+    constexpr double sampleRate = 48000.0;
+    constexpr int numFrequencies = 450;
+    const auto maxOmega = 0.9 * MathConstants<double>::pi;
+
+    auto split = measureFrequencyResponse (0, 0, bands, 50.0f, 50.0f, maxOmega, numFrequencies);
+    auto single = measureFrequencyResponse (0, 0, 0, 50.0f, 50.0f, maxOmega, numFrequencies);
+
+    Array<double> crossovers;
+
+    for (int i = 0; i < bands; ++i)
+        crossovers.add (200.0 * std::pow (5.0, i));
+
+    CrossoverSum result;
+
+    for (int k = 0; k < numFrequencies; ++k)
+    {
+        auto omega = maxOmega * (k + 1) / numFrequencies;
+        auto magnitude = Decibels::gainToDecibels (split.magnitudes[(size_t) k] / single.magnitudes[(size_t) k], -300.0);
+        auto delay = split.groupDelays[(size_t) k] - single.groupDelays[(size_t) k];
+
+        result.magnitudeError = jmax (result.magnitudeError, std::abs (magnitude));
+        result.delayError = jmax (result.delayError, std::abs (delay - getCrossoverGroupDelay (crossovers, sampleRate, omega)));
+    }
+
+    return result;
+}
+
+//==============================================================================
+Array<BenchmarkCase> createCases (bool quick)
+{
+    Array<BenchmarkCase> cases;
+
+    Array<int> blockSizes { 1, 16, 64, 256, 1024, 4096 };
+    Array<double> sampleRates { 44100.0, 96000.0, 192000.0 };
+    StringArray automations { "static", "ramp", "jumps" };
+
+    if (quick)
+    {
+        blockSizes = { 1, 64, 1024 };
+        sampleRates = { 48000.0 };
+    }
+
+    // The plain signal path at its default settings
+    for (auto sampleRate : sampleRates)
+        for (auto blockSize : blockSizes)
+            for (int numChannels = 1; numChannels <= 2; ++numChannels)
+                for (auto& automation : automations)
+                {
+                    BenchmarkCase c;
+                    c.sampleRate = sampleRate;
+                    c.blockSize = blockSize;
+                    c.numChannels = numChannels;
+                    c.automation = automation;
+                    c.name = "io/" + String (roundToInt (sampleRate)) + "/" + String (blockSize)
+                               + "/" + String (numChannels) + "ch/" + automation;
+                    cases.add (c);
+                }
+
+    // Every processing mode at a typical session setting
+    StringArray accuracyNames { "exact", "fast", "table" };
+
+    for (int accuracy = 0; accuracy < accuracyNames.size(); ++accuracy)
+        for (int oversampling = 0; oversampling <= OversamplingOptions::maxFactorIndex; ++oversampling)
+            for (int osFilter = 0; osFilter < (oversampling == 0 ? 1 : 2); ++osFilter)
+            {
+                BenchmarkCase c;
+                c.sampleRate = 96000.0;
+                c.accuracy = accuracy;
+                c.oversampling = oversampling;
+                c.osFilter = osFilter;
+                c.name = "mode/" + accuracyNames[accuracy] + "/os" + String (1 << oversampling)
+                           + (oversampling == 0 ? String() : (osFilter == 0 ? "/iir" : "/fir"));
+                cases.add (c);
+            }
+
+    // Surround and ambisonic stems. nsPerSample is per channel, so if a single
+    // instance scales linearly these should all come out about the same.
+    for (auto numChannels : { 1, 2, 6, 12, 16 })
+        for (auto& automation : { "static", "jumps" })
+        {
+            BenchmarkCase c;
+            c.sampleRate = 48000.0;
+            c.blockSize = 512;
+            c.numChannels = numChannels;
+            c.automation = automation;
+            c.name = "layout/" + String (numChannels) + "ch/" + automation;
+            cases.add (c);
+        }
+
+    // The shortcuts for silence, wet = 0 and host bypass, with and without latency
+    for (auto& state : { "active", "metered", "silent", "dryOnly", "bypassed" })
+        for (int oversampling : { 0, 2 })
+        {
+            BenchmarkCase c;
+            c.oversampling = oversampling;
+            c.state = state;
+            c.name = "state/" + c.state + "/os" + String (1 << oversampling);
+            cases.add (c);
+        }
+
+    // Multiband mode: the crossovers plus all bands shaped together in one pass,
+    // next to the single band path at the same settings
+    for (int bands = 0; bands <= 3; ++bands)
+        for (int oversampling : { 0, 2 })
+        {
+            BenchmarkCase c;
+            c.sampleRate = 96000.0;
+            c.bands = bands;
+            c.oversampling = oversampling;
+            c.name = "bands/" + String (bands + 1) + "/os" + String (1 << oversampling);
+            cases.add (c);
+        }
+
+    // The cabinet IR at a few lengths and block sizes. With the partitioned convolution
+    // a 40 times longer IR should cost nowhere near 40 times as much.
+    for (auto cabinetSeconds : { 0.05, 0.5, 2.0 })
+        for (auto blockSize : { 64, 512 })
+        {
+            BenchmarkCase c;
+            c.blockSize = blockSize;
+            c.cabinetSeconds = cabinetSeconds;
+            c.name = "cabinet/" + String (roundToInt (cabinetSeconds * 1000.0)) + "ms/" + String (blockSize);
+            cases.add (c);
+        }
+
+    // The limiter next to the same settings without it. The exact curve is the cost
+    // it should stay in the region of.
+    for (int accuracy = 0; accuracy < 2; ++accuracy)
+        for (auto limiter : { false, true })
+            for (auto blockSize : { 64, 512 })
+            {
+                BenchmarkCase c;
+                c.blockSize = blockSize;
+                c.accuracy = accuracy;
+                c.limiter = limiter;
+                c.name = String ("limiter/") + (limiter ? "on/" : "off/") + accuracyNames[accuracy] + "/" + String (blockSize);
+                cases.add (c);
+            }
+
+    // ADAA next to plain oversampling: the same cases run through measureAliasing()
+    for (auto& c : createAliasingCases())
+        cases.add (c);
+
+    // The native 64-bit path, for hosts that mix in double precision
+    for (int accuracy = 0; accuracy < accuracyNames.size(); ++accuracy)
+    {
+        BenchmarkCase c;
+        c.sampleRate = 96000.0;
+        c.accuracy = accuracy;
+        c.doublePrecision = true;
+        c.name = "double/" + accuracyNames[accuracy];
+        cases.add (c);
+    }
+
+    return cases;
+}
+
+//==============================================================================
+template <typename Function>
+double timeMicros (int iterations, Function&& function)
+{
+    auto startTime = std::chrono::steady_clock::now();
+
+    for (int i = 0; i < iterations; ++i)
+        function();
+
+    auto endTime = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::micro> (endTime - startTime).count() / iterations;
+}
+
+void printTimingResult (const String& name, double micros, int iterations, int64 bytes = -1)
+{
+    auto* object = new DynamicObject();
+    object->setProperty ("case", name);
+    object->setProperty ("micros", micros);
+    object->setProperty ("iterations", iterations);
+
+    if (bytes >= 0)
+        object->setProperty ("bytes", bytes);
+
+    std::cout << JSON::toString (var (object), true, 4) << std::endl;
+}
+
+/** The kernel on its own, for each kind of block it has a specialised variant for,
+    against the variant with everything in that every block used to run.
+*/
+void runVariantBenchmarks (bool quick)
+{
+    ScopedNoDenormals noDenormals;
+
+    DistortionParameters everything { 8.0f, 0.7f, 0.6f, 0.4f, 0.7f };
+    auto noClamp = everything;      noClamp.threshold = 1.0f;
+    auto noDry = everything;        noDry.dry = 0.0f;
+    auto unityOutput = everything;  unityOutput.outputLvl = 1.0f;
+    DistortionParameters bare { 8.0f, 1.0f, 1.0f, 0.0f, 1.0f };
+
+    const std::pair<const char*, DistortionParameters> variants[] =
+    {
+        { "everything", everything }, { "noClamp", noClamp }, { "noDry", noDry },
+        { "unityOutput", unityOutput }, { "bare", bare }
+    };
+
+    const int blockSize = 512;
+    const int iterations = quick ? 2000 : 20000;
+
+    for (auto& [name, start] : variants)
+    {
+        for (auto ramped : { false, true })
+        {
+            // Only drive and wet move, so the block still needs the same features
+            auto end = start;
+
+            if (ramped)
+            {
+                end.drive *= 1.5f;
+                end.wet *= 0.8f;
+            }
+
+            for (auto numChannels : { 1, 2, 6 })
+            {
+                AudioBuffer<float> buffer (numChannels, blockSize);
+
+                auto nsPerSample = [&] (bool variantsEnabled)
+                {
+                    WaveshaperKernel::setVariantsEnabled (variantsEnabled);
+
+                    for (int channel = 0; channel < numChannels; ++channel)
+                        FloatVectorOperations::fill (buffer.getWritePointer (channel), 0.3f, blockSize);
+
+                    auto micros = timeMicros (iterations, [&]
+                    {
+                        WaveshaperKernel::process (buffer.getArrayOfWritePointers(), numChannels, blockSize,
+                                                   start, end, WaveshaperKernel::Accuracy::fast);
+                    });
+
+                    return 1000.0 * micros / (blockSize * numChannels);
+                };
+
+                auto baseline = nsPerSample (false);
+                auto specialised = nsPerSample (true);
+
+                auto* object = new DynamicObject();
+                object->setProperty ("case", "variants/" + String (name) + (ramped ? "/ramp/" : "/static/")
+                                               + String (numChannels) + "ch");
+                object->setProperty ("instructionSet", WaveshaperKernel::getName (WaveshaperKernel::getInstructionSet()));
+                object->setProperty ("nsPerSample", specialised);
+                object->setProperty ("allFeaturesNsPerSample", baseline);
+                object->setProperty ("speedup", baseline / jmax (1.0e-9, specialised));
+                std::cout << JSON::toString (var (object), true, 4) << std::endl;
+            }
+        }
+    }
+
+    WaveshaperKernel::setVariantsEnabled (true);
+}
+
+/** Opens editors the way a host does and paints them into an image. */
+void runEditorBenchmarks (bool quick)
+{
+    DistortionEffectProjectAudioProcessor processor;
+    processor.setRateAndBufferSizeDetails (48000.0, 512);
+    processor.prepareToPlay (48000.0, 512);
+
+    auto iterations = quick ? 20 : 100;
+
+    // The first editor pays for everything the editors share, later ones shouldn't
+    std::unique_ptr<AudioProcessorEditor> editor;
+    printTimingResult ("editor/open/first", timeMicros (1, [&] { editor.reset (processor.createEditorIfNeeded()); }), 1);
+
+    // Every further instance gets its own processor, like separate plugins in a session
+    OwnedArray<DistortionEffectProjectAudioProcessor> otherProcessors;
+    OwnedArray<AudioProcessorEditor> otherEditors;
+
+    for (int i = 0; i < iterations; ++i)
+        otherProcessors.add (new DistortionEffectProjectAudioProcessor());
+
+    printTimingResult ("editor/open/another", timeMicros (iterations, [&]
+    {
+        otherEditors.add (otherProcessors[otherEditors.size()]->createEditorIfNeeded());
+    }), iterations);
+
+    otherEditors.clear();
+    otherProcessors.clear();
+
+    // A full repaint, e.g. when the window is first shown...
+    auto bounds = editor->getLocalBounds();
+    printTimingResult ("editor/paint/full", timeMicros (iterations, [&] { editor->createComponentSnapshot (bounds); }), iterations);
+
+    // ...and the small repaints that happen while the plugin is in use
+    Rectangle<int> sliderBounds, meterBounds;
+
+    for (auto* child : editor->getChildren())
+    {
+        if (sliderBounds.isEmpty() && dynamic_cast<Slider*> (child) != nullptr)
+            sliderBounds = child->getBounds();
+
+        if (dynamic_cast<LevelMeter*> (child) != nullptr || dynamic_cast<WaveformDisplay*> (child) != nullptr
+             || dynamic_cast<TransferCurveDisplay*> (child) != nullptr)
+            meterBounds = meterBounds.isEmpty() ? child->getBounds() : meterBounds.getUnion (child->getBounds());
+    }
+
+    printTimingResult ("editor/paint/slider", timeMicros (iterations, [&] { editor->createComponentSnapshot (sliderBounds); }), iterations);
+    printTimingResult ("editor/paint/meters", timeMicros (iterations, [&] { editor->createComponentSnapshot (meterBounds); }), iterations);
+
+    editor.reset();
+    processor.releaseResources();
+}
+
+/** Saves and restores the plugin state the way a host does when a session is
+    saved, loaded or a preset is recalled.
+*/
+void runStateBenchmarks (bool quick)
+{
+    DistortionEffectProjectAudioProcessor processor;
+    processor.setRateAndBufferSizeDetails (48000.0, 512);
+    processor.prepareToPlay (48000.0, 512);
+
+    auto iterations = quick ? 200 : 2000;
+
+    MemoryBlock binary;
+    printTimingResult ("state/save", timeMicros (iterations, [&]
+    {
+        binary.reset();
+        processor.getStateInformation (binary);
+    }), iterations, (int64) binary.getSize());
+
+    printTimingResult ("state/load/binary", timeMicros (iterations, [&]
+    {
+        processor.setStateInformation (binary.getData(), (int) binary.getSize());
+    }), iterations, (int64) binary.getSize());
+
+    // Sessions saved by earlier versions hold the value tree state as XML
+    MemoryBlock xml;
+
+    if (auto element = processor.treeState.copyState().createXml())
+        AudioProcessor::copyXmlToBinary (*element, xml);
+
+    printTimingResult ("state/load/xml", timeMicros (iterations, [&]
+    {
+        processor.setStateInformation (xml.getData(), (int) xml.getSize());
+    }), iterations, (int64) xml.getSize());
+
+    processor.releaseResources();
+}
+
+/** Program changes, and a user bank with a few hundred presets in it. */
+void runPresetBenchmarks (bool quick)
+{
+    DistortionEffectProjectAudioProcessor processor;
+    processor.setRateAndBufferSizeDetails (48000.0, 512);
+    processor.prepareToPlay (48000.0, 512);
+
+    auto iterations = quick ? 200 : 2000;
+    auto numFactory = PresetBank::getNumFactoryPresets();
+    int program = 0;
+
+    printTimingResult ("presets/switch", timeMicros (iterations, [&]
+    {
+        processor.setCurrentProgram (program);
+        program = (program + 1) % numFactory;
+    }), iterations);
+
+    processor.releaseResources();
+
+    // A bank of its own in a temporary file, so the user's presets are left alone
+    TemporaryFile bankFile (".bin");
+    const int numUserPresets = 500;
+
+    {
+        PresetBank bank (bankFile.getFile());
+
+        for (int i = 0; i < numUserPresets; ++i)
+        {
+            PlainParameters values;
+            values.drive = (float) (i % 30);
+            bank.addUserPreset ("Preset " + String (i), values);
+        }
+    }
+
+    std::unique_ptr<PresetBank> bank;
+    printTimingResult ("presets/open", timeMicros (1, [&]
+    {
+        bank = std::make_unique<PresetBank> (bankFile.getFile());
+        bank->getNumPresets();
+    }), 1, bankFile.getFile().getSize());
+
+    Random random (1);
+    PlainParameters values;
+
+    printTimingResult ("presets/recall", timeMicros (iterations, [&]
+    {
+        auto index = numFactory + random.nextInt (numUserPresets);
+        bank->getValues (index, values);
+        bank->getName (index);
+    }), iterations);
+}
+
+/** A big session: many instances in one process. The first instance measures
+    its filters and builds its tables, the others should find them in the
+    shared caches.
+*/
+void runSharingBenchmarks (bool quick)
+{
+    const int numInstances = quick ? 20 : 100;
+    OwnedArray<DistortionEffectProjectAudioProcessor> processors;
+
+    auto addInstance = [&]
+    {
+        auto* processor = processors.add (new DistortionEffectProjectAudioProcessor());
+        setParameter (*processor, "accuracy", 2.0f);
+        processor->setRateAndBufferSizeDetails (48000.0, 512);
+        processor->prepareToPlay (48000.0, 512);
+    };
+
+    printTimingResult ("sharing/prepare/first", timeMicros (1, addInstance), 1);
+    printTimingResult ("sharing/prepare/another", timeMicros (numInstances - 1, addInstance), numInstances - 1);
+
+    // All of them in table mode at the same settings, like copies of one preset.
+    // Tables are built in the background, so give the builder a moment.
+    auto signal = createTestSignal<float> (2, 48000.0);
+    AudioBuffer<float> buffer (2, 512);
+    MidiBuffer midi;
+
+    for (int round = 0; round < 25; ++round)
+    {
+        for (auto* processor : processors)
+        {
+            buffer.copyFrom (0, 0, signal, 0, 0, 512);
+            buffer.copyFrom (1, 0, signal, 1, 0, 512);
+            processor->processBlock (buffer, midi);
+        }
+
+        Thread::sleep (20);
+    }
+
+    using TableCache = SharedCache<std::pair<float, float>, TransferTable>;
+    auto& tables = TableCache::getInstance();
+    auto tableBytes = (int64) sizeof (TransferTable);
+
+    auto* object = new DynamicObject();
+    object->setProperty ("case", "sharing/tables");
+    object->setProperty ("instances", numInstances);
+    object->setProperty ("tables", tables.getNumEntries());
+    object->setProperty ("bytes", tables.getNumEntries() * tableBytes);
+    object->setProperty ("unsharedBytes", numInstances * 2 * tableBytes);   // two per instance without sharing
+    object->setProperty ("builds", tables.getNumMisses());
+    object->setProperty ("reused", tables.getNumHits());
+    std::cout << JSON::toString (var (object), true, 4) << std::endl;
+
+    for (auto* processor : processors)
+        processor->releaseResources();
+}
+
+/** Runs every combination of the quality, mode, cabinet and limiter parameters on one instance,
+    with random jumps of all the continuous parameters, random block sizes and the odd
+    bypassed block in between, and counts what processBlock allocates. Returns the
+    total, after printing it and an ALLOCATION line for each combination that did.
+*/
+template <typename SampleType>
+int64 runAllocationSweep (bool quick)
+{
+    const double sampleRate = 48000.0;
+    const int maxBlockSize = 512;
+    const int blocksPerCombination = quick ? 4 : 16;
+    const String caseName = String ("allocations/") + (std::is_same_v<SampleType, double> ? "double" : "float");
+
+    TemporaryFile impulseResponse (".wav");
+
+    if (! writeImpulseResponse (impulseResponse.getFile(), 0.2, sampleRate))
+        return 0;
+
+    auto signal = createTestSignal<SampleType> (2, sampleRate);
+    AudioBuffer<SampleType> buffer (2, 2 * maxBlockSize);
+    MidiBuffer midi;
+    Random random (7);
+
+    int64 total = 0;
+    int numCombinations = 0, numBlocks = 0, position = 0;
+
+    for (auto nonRealtime : { false, true })
+    {
+        DistortionEffectProjectAudioProcessor processor;
+        processor.loadCabinet (impulseResponse.getFile());
+        processor.setNonRealtime (nonRealtime);
+        processor.setProcessingPrecision (std::is_same_v<SampleType, double> ? AudioProcessor::doublePrecision
+                                                                             : AudioProcessor::singlePrecision);
+        processor.setRateAndBufferSizeDetails (sampleRate, maxBlockSize);
+        processor.prepareToPlay (sampleRate, maxBlockSize);
+
+        for (int accuracy = 0; accuracy < 3; ++accuracy)
+        for (int oversampling = 0; oversampling <= OversamplingOptions::maxFactorIndex; ++oversampling)
+        for (int osFilter = 0; osFilter < 2; ++osFilter)
+        for (int bands = 0; bands < MultibandStage<float>::maxBands; ++bands)
+        for (int antialiasing = 0; antialiasing < 3; ++antialiasing)
+        for (int autoQuality = 0; autoQuality < 2; ++autoQuality)
+        for (int cabinet = 0; cabinet < 2; ++cabinet)
+        for (int limiter = 0; limiter < 2; ++limiter)
+        {
+            setParameter (processor, "accuracy", (float) accuracy);
+            setParameter (processor, "oversampling", (float) oversampling);
+            setParameter (processor, "osFilter", (float) osFilter);
+            setParameter (processor, "bands", (float) bands);
+            setParameter (processor, "antialiasing", (float) antialiasing);
+            setParameter (processor, "autoQuality", (float) autoQuality);
+            setParameter (processor, "cabinet", (float) cabinet);
+            setParameter (processor, "limiter", (float) limiter);
+
+            // Offline, Table accuracy builds its tables on the audio thread, which allocates
+            auto buildsTables = nonRealtime && accuracy == 2 && antialiasing == 0 && autoQuality == 0;
+            int64 allocations = 0;
+
+            for (int block = 0; block < blocksPerCombination; ++block)
+            {
+                // Everything continuous jumps, as with automation or a preset change
+                for (auto* parameter : processor.getParameters())
+                    if (dynamic_cast<AudioParameterFloat*> (parameter) != nullptr)
+                        parameter->setValueNotifyingHost (random.nextFloat());
+
+                // Now and then more than prepareToPlay promised, as some hosts do
+                auto numSamples = 1 + random.nextInt (random.nextInt (8) == 0 ? 2 * maxBlockSize : maxBlockSize);
+                AudioBuffer<SampleType> chunk (buffer.getArrayOfWritePointers(), 2, numSamples);
+
+                for (int channel = 0; channel < 2; ++channel)
+                    for (int i = 0; i < numSamples; ++i)
+                        chunk.setSample (channel, i, signal.getSample (channel, (position + i) % signal.getNumSamples()));
+
+                position = (position + numSamples) % signal.getNumSamples();
+
+                AllocationTracker::ScopedCheck check (! buildsTables);
+
+                if (block == blocksPerCombination - 1)
+                    processor.processBlockBypassed (chunk, midi);
+                else
+                    processor.processBlock (chunk, midi);
+
+                allocations += check.getCount();
+                ++numBlocks;
+            }
+
+            if (allocations > 0)
+                std::cerr << "ALLOCATION " << caseName << ": " << allocations << " with accuracy=" << accuracy
+                          << " oversampling=" << oversampling << " osFilter=" << osFilter << " bands=" << bands
+                          << " antialiasing=" << antialiasing << " autoQuality=" << autoQuality
+                          << " cabinet=" << cabinet << " limiter=" << limiter << " nonRealtime=" << (int) nonRealtime << std::endl;
+
+            total += allocations;
+            ++numCombinations;
+        }
+
+        processor.releaseResources();
+    }
+
+    auto* object = new DynamicObject();
+    object->setProperty ("case", caseName);
+    object->setProperty ("combinations", numCombinations);
+    object->setProperty ("blocks", numBlocks);
+    object->setProperty ("allocations", total);
+    object->setProperty ("catchesMalloc", AllocationTracker::isCatchingMalloc());
+    std::cout << JSON::toString (var (object), true, 4) << std::endl;
+
+    return total;
+}
+
+/** Reads an earlier run's output back in as case name -> ns/sample. */
+std::map<String, double> loadBaseline (const File& file)
+{
+    std::map<String, double> baseline;
+    StringArray lines;
+    file.readLines (lines);
+
+    for (auto& line : lines)
+    {
+        auto parsed = JSON::parse (line);
+
+        if (parsed.hasProperty ("case"))
+            baseline[parsed["case"].toString()] = (double) parsed["nsPerSample"];
+    }
+
+    return baseline;
+}
+
+} // namespace
+
+//==============================================================================
+int main (int argc, char* argv[])
+{
+    ScopedJuceInitialiser_GUI juceInitialiser;
+
+    ArgumentList args (argc, argv);
+    auto quick = args.containsOption ("--quick");
+    auto seconds = args.containsOption ("--seconds") ? args.getValueForOption ("--seconds").getDoubleValue()
+                                                     : (quick ? 0.5 : 2.0);
+    auto filter = args.getValueForOption ("--filter");
+    auto tolerance = args.containsOption ("--tolerance") ? args.getValueForOption ("--tolerance").getDoubleValue() : 1.15;
+    auto checkAllocations = args.containsOption ("--check-allocations");
+
+    std::map<String, double> baseline;
+
+    if (args.containsOption ("--baseline"))
+        baseline = loadBaseline (args.getExistingFileForOption ("--baseline"));
+
+    int numRegressions = 0, numAllocatingCases = 0;
+
+    auto checkResult = [&] (const BenchmarkCase& c, const BenchmarkResult& result)
+    {
+        if (result.allocations > 0)
+        {
+            std::cerr << "ALLOCATION " << c.name << ": " << result.allocations << " in processBlock" << std::endl;
+            ++numAllocatingCases;
+        }
+    };
+
+    for (auto& c : createCases (quick))
+    {
+        if (filter.isNotEmpty() && ! c.name.contains (filter))
+            continue;
+
+        auto result = runCase (c, seconds, checkAllocations);
+        std::cout << toJson (c, result) << std::endl;
+        checkResult (c, result);
+
+        auto previous = baseline.find (c.name);
+
+        if (previous != baseline.end() && result.nsPerSample > previous->second * tolerance)
+        {
+            std::cerr << "REGRESSION " << c.name << ": " << result.nsPerSample << " ns/sample, baseline "
+                      << previous->second << std::endl;
+            ++numRegressions;
+        }
+    }
+
+    // Kernel-only figures for every instruction set this machine supports
+    using WaveshaperKernel::InstructionSet;
+    auto bestSet = WaveshaperKernel::getInstructionSet();
+
+    for (auto set : { InstructionSet::scalar, InstructionSet::sse2, InstructionSet::avx2, InstructionSet::avx512, InstructionSet::neon })
+    {
+        if (! WaveshaperKernel::setInstructionSet (set))
+            continue;
+
+        for (int accuracy = 0; accuracy < 2; ++accuracy)
+        {
+            BenchmarkCase c;
+            c.sampleRate = 96000.0;
+            c.accuracy = accuracy;
+            c.name = String ("kernel/") + WaveshaperKernel::getName (set) + (accuracy == 0 ? "/exact" : "/fast");
+
+            if (filter.isEmpty() || c.name.contains (filter))
+            {
+                auto result = runCase (c, seconds, checkAllocations);
+                std::cout << toJson (c, result) << std::endl;
+                checkResult (c, result);
+            }
+        }
+    }
+
+    WaveshaperKernel::setInstructionSet (bestSet);
+
+    if (filter.isEmpty() || filter.startsWith ("variants"))
+        runVariantBenchmarks (quick);
+
+    for (auto& c : createAliasingCases())
+    {
+        if (filter.isNotEmpty() && ! c.name.contains (filter))
+            continue;
+
+        auto* object = new DynamicObject();
+        object->setProperty ("case", c.name + "/spectrum");
+        object->setProperty ("aliasingDb", measureAliasing (c));
+        std::cout << JSON::toString (var (object), true, 4) << std::endl;
+    }
+
+    // Not a timing: the dry/wet mix has to line up with the curve's own delay. ADAA's half
+    // sample can't be reported as latency, anything beyond that must have been.
+    int numMisalignedMixes = 0;
+
+    if (filter.isEmpty() || filter.startsWith ("mix"))
+    {
+        for (int antialiasing = 0; antialiasing < 3; ++antialiasing)
+        {
+            auto name = "mix/" + (antialiasing == 0 ? String ("plain") : "adaa" + String (antialiasing));
+            auto response = measureMixResponse (antialiasing);
+
+            auto* object = new DynamicObject();
+            object->setProperty ("case", name);
+            object->setProperty ("latency", response.latency);
+            object->setProperty ("groupDelay", response.groupDelay);
+            object->setProperty ("groupDelaySpread", response.spread);
+            std::cout << JSON::toString (var (object), true, 4) << std::endl;
+
+            if (response.spread > 0.01 || response.groupDelay < -0.01 || response.groupDelay > 0.51)
+            {
+                std::cerr << "MIX " << name << ": group delay " << response.groupDelay << " +- " << 0.5 * response.spread
+                          << " samples beyond the latency" << std::endl;
+                ++numMisalignedMixes;
+            }
+        }
+
+        for (int oversampling = 1; oversampling <= OversamplingOptions::maxFactorIndex; ++oversampling)
+        {
+            for (int antialiasing = 1; antialiasing < 3; ++antialiasing)
+            {
+                auto name = "mix/os" + String (1 << oversampling) + "/adaa" + String (antialiasing);
+                auto mismatch = measureOversampledDryMismatch (antialiasing, oversampling);
+
+                auto* object = new DynamicObject();
+                object->setProperty ("case", name);
+                object->setProperty ("dryMismatch", mismatch);
+                std::cout << JSON::toString (var (object), true, 4) << std::endl;
+
+                if (mismatch > 0.01)
+                {
+                    std::cerr << "MIX " << name << ": the dry path is up to " << mismatch
+                              << " samples off the wet one's ADAA delay" << std::endl;
+                    ++numMisalignedMixes;
+                }
+            }
+        }
+    }
+
+    // Not a timing either: with every band set the same, splitting into bands must only
+    // add the crossovers' allpass phase
+    int numUnevenCrossovers = 0;
+
+    if (filter.isEmpty() || filter.startsWith ("bands"))
+    {
+        for (int bands = 1; bands <= 3; ++bands)
+        {
+            auto name = "bands/" + String (bands + 1) + "/sum";
+            auto sum = measureCrossoverSum (bands);
+
+            auto* object = new DynamicObject();
+            object->setProperty ("case", name);
+            object->setProperty ("magnitudeErrorDb", sum.magnitudeError);
+            object->setProperty ("groupDelayError", sum.delayError);
+            std::cout << JSON::toString (var (object), true, 4) << std::endl;
+
+            if (sum.magnitudeError > 0.01 || sum.delayError > 0.01)
+            {
+                std::cerr << "CROSSOVER " << name << ": the bands sum to within " << sum.magnitudeError
+                          << " dB of flat and " << sum.delayError << " samples of the allpasses' group delay" << std::endl;
+                ++numUnevenCrossovers;
+            }
+        }
+    }
+
+    if (checkAllocations && (filter.isEmpty() || filter.startsWith ("allocations")))
+    {
+        if (runAllocationSweep<float> (quick) > 0)
+            ++numAllocatingCases;
+
+        if (runAllocationSweep<double> (quick) > 0)
+            ++numAllocatingCases;
+    }
+
+    if (filter.isEmpty() || filter.startsWith ("state"))
+        runStateBenchmarks (quick);
+
+    if (filter.isEmpty() || filter.startsWith ("presets"))
+        runPresetBenchmarks (quick);
+
+    if (filter.isEmpty() || filter.startsWith ("sharing"))
+        runSharingBenchmarks (quick);
+
+    if (filter.isEmpty() || filter.startsWith ("editor"))
+        runEditorBenchmarks (quick);
+
+    return numRegressions > 0 || numAllocatingCases > 0 || numMisalignedMixes > 0 || numUnevenCrossovers > 0 ? 1 : 0;
+}
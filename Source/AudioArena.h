@@ -0,0 +1,96 @@
+/*
+  ==============================================================================
+
+    AudioArena.h
+
+    All of an instance's working buffers in one allocation: made in
+    prepareToPlay, freed in releaseResources, and never touched by the heap
+    in between, so nothing the audio thread does can end up in the allocator.
+
+    The stages take their buffers in two passes over the same code. The first
+    runs while the arena is measuring, hands out nothing and only adds up the
+    sizes, then the arena allocates that much and the second pass gets the
+    real pointers. So the size can't drift away from what's actually used.
+
+    Every buffer starts on a cache line (which also suits AVX-512 loads) and
+    is zeroed. Only for plain sample data and pointers: nothing in here is
+    ever constructed or destroyed.
+
+    What lives inside JUCE's own classes (the oversampling filters, delay
+    lines and convolution engines) is allocated by their prepare() and isn't
+    in the arena, but it's equally never allocated while processing.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+using namespace juce;
+
+//==============================================================================
+class AudioArena
+{
+public:
+    static constexpr size_t alignment = 64;
+
+    AudioArena() = default;
+
+    /** Starts the measuring pass. Anything handed out earlier is gone from here on. */
+    void beginMeasuring() noexcept
+    {
+        release();
+        measuring = true;
+    }
+
+    /** Allocates everything the measuring pass asked for and starts handing it out. */
+    void allocateMeasured()
+    {
+        jassert (measuring);
+
+        capacity = used;
+        storage.allocate (capacity + alignment, true);
+        base = reinterpret_cast<char*> ((reinterpret_cast<pointer_sized_uint> (storage.get()) + alignment - 1)
+                                          & ~(pointer_sized_uint) (alignment - 1));
+        used = 0;
+        measuring = false;
+    }
+
+    /** Frees the memory. Until the next measuring pass allocate() returns nullptr. */
+    void release() noexcept
+    {
+        storage.free();
+        base = nullptr;
+        capacity = used = 0;
+        measuring = false;
+    }
+
+    /** numElements of T, zeroed, or nullptr while measuring or released. */
+    template <typename T>
+    T* allocate (size_t numElements) noexcept
+    {
+        static_assert (std::is_trivial_v<T>, "The arena never constructs anything");
+
+        auto offset = (used + alignment - 1) & ~(alignment - 1);
+        used = offset + numElements * sizeof (T);
+
+        if (base == nullptr)
+            return nullptr;
+
+        // The second pass asked for more than the first, i.e. something's size
+        // changed in between - a stage must only depend on what prepare() set
+        jassert (used <= capacity);
+        return used <= capacity ? reinterpret_cast<T*> (base + offset) : nullptr;
+    }
+
+    bool isAllocated() const noexcept           { return base != nullptr; }
+    size_t getSizeInBytes() const noexcept      { return capacity; }
+
+private:
+    HeapBlock<char> storage;
+    char* base = nullptr;
+    size_t capacity = 0, used = 0;
+    bool measuring = false;
+
+    JUCE_DECLARE_NON_COPYABLE (AudioArena)
+};
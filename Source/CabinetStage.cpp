@@ -0,0 +1,127 @@
+/*
+  ==============================================================================
+
+    CabinetStage.cpp
+
+  ==============================================================================
+*/
+
+#include "CabinetStage.h"
+
+//==============================================================================
+CabinetStage::CabinetStage()
+    : convolution (dsp::Convolution::NonUniform { headSize }, *loader)
+{
+}
+
+void CabinetStage::prepare (double sampleRate, int newNumChannels, int maxBlockSize, bool doublePrecision)
+{
+    numChannels = newNumChannels;
+
+    // A mono layout still gets a stereo IR's left channel
+    convolution.prepare ({ sampleRate, (uint32) maxBlockSize, (uint32) jlimit (1, maxChannels, numChannels) });
+
+    conversionSize = doublePrecision ? maxBlockSize : 0;
+    reset();
+}
+
+void CabinetStage::takeWorkingMemory (AudioArena& arena) noexcept
+{
+    for (auto*& channel : conversionChannels)
+        channel = conversionSize > 0 ? arena.allocate<float> ((size_t) conversionSize) : nullptr;
+}
+
+void CabinetStage::reset() noexcept
+{
+    convolution.reset();
+}
+
+//==============================================================================
+bool CabinetStage::loadImpulseResponse (const File& newFile)
+{
+    // The loader gives up without a word on a file it has no reader for, so the same
+    // check is made here first. It only reads the header, the samples are read later.
+    AudioFormatManager formats;
+    formats.registerBasicFormats();
+    std::unique_ptr<AudioFormatReader> reader (formats.createReaderFor (newFile));
+
+    if (reader == nullptr || reader->lengthInSamples <= 0)
+    {
+        clearImpulseResponse();
+        return false;
+    }
+
+    // Normalised, so swapping cabinets doesn't jump the level by 20 dB, and trimmed,
+    // since silence at either end would only cost partitions
+    convolution.loadImpulseResponse (newFile, dsp::Convolution::Stereo::yes, dsp::Convolution::Trim::yes, 0,
+                                     dsp::Convolution::Normalise::yes);
+    file = newFile;
+    loaded.store (true, std::memory_order_release);
+    return true;
+}
+
+void CabinetStage::clearImpulseResponse()
+{
+    file = File();
+    loaded.store (false, std::memory_order_release);
+}
+
+File CabinetStage::getImpulseResponseFile() const
+{
+    return file;
+}
+
+void CabinetStage::setEnabled (bool shouldBeEnabled) noexcept
+{
+    auto wasActive = isActive();
+    enabled = shouldBeEnabled;
+
+    if (isActive() && ! wasActive)
+        reset();
+
+    tailLength.store (isActive() ? convolution.getCurrentIRSize() : 0, std::memory_order_relaxed);
+}
+
+//==============================================================================
+template <typename SampleType>
+void CabinetStage::process (const dsp::AudioBlock<SampleType>& block) noexcept
+{
+    if (! isActive())
+        return;
+
+    if constexpr (std::is_same_v<SampleType, float>)
+    {
+        auto channels = block;
+        convolution.process (dsp::ProcessContextReplacing<float> (channels));
+    }
+    else
+    {
+        auto numSamples = block.getNumSamples();
+        jassert (conversionChannels[0] != nullptr && (int) numSamples <= conversionSize);
+        auto converted = dsp::AudioBlock<float> (conversionChannels, block.getNumChannels(), numSamples);
+
+        for (size_t channel = 0; channel < block.getNumChannels(); ++channel)
+        {
+            auto* source = block.getChannelPointer (channel);
+            auto* dest = converted.getChannelPointer (channel);
+
+            for (size_t i = 0; i < numSamples; ++i)
+                dest[i] = (float) source[i];
+        }
+
+        convolution.process (dsp::ProcessContextReplacing<float> (converted));
+
+        for (size_t channel = 0; channel < block.getNumChannels(); ++channel)
+        {
+            auto* source = converted.getChannelPointer (channel);
+            auto* dest = block.getChannelPointer (channel);
+
+            for (size_t i = 0; i < numSamples; ++i)
+                dest[i] = (SampleType) source[i];
+        }
+    }
+}
+
+//==============================================================================
+template void CabinetStage::process (const dsp::AudioBlock<float>&) noexcept;
+template void CabinetStage::process (const dsp::AudioBlock<double>&) noexcept;
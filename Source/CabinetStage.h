@@ -0,0 +1,100 @@
+/*
+  ==============================================================================
+
+    CabinetStage.h
+
+    An optional speaker cabinet after the distortion: the output is convolved
+    with an impulse response loaded from an audio file, so the plugin can
+    stand in for a separate convolution plugin behind it.
+
+    The convolution is non-uniformly partitioned. The first headSize samples
+    of the IR run in a short partition with no latency, the rest in longer
+    FFT partitions, so a long IR costs a few more multiply-adds per block
+    rather than a longer FFT per sample, and the plugin's latency doesn't
+    change when the cabinet is switched on.
+
+    Loading the file, resampling it to the rate given to prepare() and setting
+    up the FFTs happen on a background thread shared by every instance. The
+    audio thread picks up the finished IR at the start of a block and
+    crossfades to it, so it never waits and never allocates. prepare() loads
+    whatever is pending straight away, so an offline render set up before
+    prepareToPlay always starts with its IR in place.
+
+    Mono and stereo IRs are supported, and the stage only runs on mono and
+    stereo layouts - a cabinet on every channel of a surround stem isn't
+    what anyone wants from an amp sim.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "AudioArena.h"
+using namespace juce;
+
+//==============================================================================
+class CabinetStage
+{
+public:
+    /** The zero latency partition at the start of the IR, in samples. */
+    static constexpr int headSize = 256;
+
+    static constexpr int maxChannels = 2;
+
+    CabinetStage();
+
+    /** Call from prepareToPlay. The conversion buffer is only needed for the double
+        precision path, the convolution itself runs in float.
+    */
+    void prepare (double sampleRate, int numChannels, int maxBlockSize, bool doublePrecision);
+
+    /** Takes the conversion buffer, if prepare() said it's needed, see AudioArena. */
+    void takeWorkingMemory (AudioArena& arena) noexcept;
+    void reset() noexcept;
+
+    /** Message thread: loads an IR in the background and crossfades to it once it's ready.
+        Returns false, and leaves the stage without an IR, if the file can't be read.
+    */
+    bool loadImpulseResponse (const File& file);
+
+    /** Message thread: forgets the IR, the stage stops processing. */
+    void clearImpulseResponse();
+
+    /** Message thread: the file last loaded, for the state and the editor. */
+    File getImpulseResponseFile() const;
+    bool hasImpulseResponse() const noexcept        { return loaded.load (std::memory_order_acquire); }
+
+    /** Audio thread, once per block. Switching on starts from silence rather than
+        from whatever the convolution held when it was switched off.
+    */
+    void setEnabled (bool shouldBeEnabled) noexcept;
+
+    /** Audio thread. */
+    bool isActive() const noexcept          { return enabled && numChannels <= maxChannels && hasImpulseResponse(); }
+
+    /** How long the IR rings after the input stops as of the last setEnabled(), 0 while
+        the stage is off. Safe to call from any thread.
+    */
+    int getTailLengthInSamples() const noexcept     { return tailLength.load (std::memory_order_relaxed); }
+
+    /** Convolves the channels in place. Does nothing unless isActive(). */
+    template <typename SampleType>
+    void process (const dsp::AudioBlock<SampleType>& block) noexcept;
+
+private:
+    // One loader thread for every instance in the process rather than one each
+    SharedResourcePointer<dsp::ConvolutionMessageQueue> loader;
+    dsp::Convolution convolution;
+
+    float* conversionChannels[maxChannels] = {};   // the double path goes through here, from the arena
+    int conversionSize = 0;
+
+    File file;                              // message thread only
+    std::atomic<bool> loaded { false };
+    std::atomic<int> tailLength { 0 };
+    int numChannels = 0;
+    bool enabled = false;
+
+    JUCE_DECLARE_NON_COPYABLE (CabinetStage)
+};
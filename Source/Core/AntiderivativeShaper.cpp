@@ -0,0 +1,256 @@
+/*
+  ==============================================================================
+
+    AntiderivativeShaper.cpp
+
+  ==============================================================================
+*/
+
+#include "AntiderivativeShaper.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+    constexpr double ln2 = 0.69314718055994530942;
+    constexpr double piSquaredOver12 = 0.82246703342411321824;
+
+    /** log (cosh (y)) for y >= 0, without overflowing for large y. */
+    inline double logCosh (double y) noexcept
+    {
+        return y + std::log1p (std::exp (-2.0 * y)) - ln2;
+    }
+
+    /** The integral of log (cosh (u)) from 0 to y, for y >= 0.
+
+        log cosh u = u - ln 2 + log (1 + e^-2u), and the last term integrates to
+        (Li2 (-e^-2y) + pi^2 / 12) / 2. With w = e^-2y / (1 + e^-2y) and
+        v = log (1 + e^-2y), Li2 (-e^-2y) = -Li2 (w) - v^2 / 2, and Li2 (w) is a
+        quickly converging series in v (v <= ln 2) with Bernoulli number
+        coefficients - good to double precision with these terms.
+    */
+    inline double integralOfLogCosh (double y) noexcept
+    {
+        auto v = std::log1p (std::exp (-2.0 * y));
+        auto v2 = v * v;
+
+        auto li2w = v * (1.0 + v * (-0.25 + v * (0.027777777777777778
+                      + v2 * (-2.7777777777777778e-4 + v2 * (4.7241118669690098e-6
+                      + v2 * (-9.1857730746619641e-8 + v2 * (1.8978869988971000e-9
+                      + v2 * (-4.0647616451442256e-11 + v2 * (8.9216910204564520e-13
+                      + v2 * -1.9939295860721074e-14)))))))));
+
+        auto li2 = -li2w - 0.5 * v2;
+        return 0.5 * y * y - ln2 * y + 0.5 * (li2 + piSquaredOver12);
+    }
+}
+
+//==============================================================================
+void AntiderivativeShaper::Curve::set (float newDrive, float newThreshold) noexcept
+{
+    drive = std::max (1.0e-6, (double) newDrive);
+    threshold = (double) newThreshold;
+
+    // tanh never reaches 1, so a threshold from there up never clips
+    if (threshold < 1.0)
+    {
+        clipPoint = std::atanh (std::max (0.0, threshold)) / drive;
+        clipF1 = logCosh (drive * clipPoint) / drive;
+        clipF2 = integralOfLogCosh (drive * clipPoint) / (drive * drive);
+    }
+    else
+    {
+        clipPoint = std::numeric_limits<double>::infinity();
+        clipF1 = clipF2 = 0.0;
+    }
+}
+
+double AntiderivativeShaper::Curve::evaluate (double x) const noexcept
+{
+    auto y = std::tanh (x * drive);
+    return y > threshold ? threshold : (y < -threshold ? -threshold : y);
+}
+
+double AntiderivativeShaper::Curve::firstAntiderivative (double x) const noexcept
+{
+    // Even, so only |x| matters
+    auto a = std::abs (x);
+
+    if (a <= clipPoint)
+        return logCosh (drive * a) / drive;
+
+    return clipF1 + threshold * (a - clipPoint);
+}
+
+double AntiderivativeShaper::Curve::secondAntiderivative (double x) const noexcept
+{
+    // Odd, so work with |x| and put the sign back
+    auto a = std::abs (x);
+    double result;
+
+    if (a <= clipPoint)
+    {
+        result = integralOfLogCosh (drive * a) / (drive * drive);
+    }
+    else
+    {
+        auto past = a - clipPoint;
+        result = clipF2 + clipF1 * past + 0.5 * threshold * past * past;
+    }
+
+    return x < 0.0 ? -result : result;
+}
+
+//==============================================================================
+void AntiderivativeShaper::setOrder (int newOrder) noexcept
+{
+    newOrder = newOrder >= 2 ? 2 : 1;
+
+    if (newOrder != order)
+    {
+        order = newOrder;
+        reset();
+    }
+}
+
+void AntiderivativeShaper::reset() noexcept
+{
+    for (auto& state : states)
+        state.primed = false;
+}
+
+template <typename SampleType>
+void AntiderivativeShaper::process (SampleType* const* channels, int numChannels, int numSamples,
+                                    const DistortionParameters& start, const DistortionParameters& end) noexcept
+{
+    numChannels = std::min (numChannels, maxChannels);
+
+    for (int channel = 0; channel < numChannels; ++channel)
+    {
+        if (order == 2)
+            processChannel<2> (states[channel], channels[channel], numSamples, start, end);
+        else
+            processChannel<1> (states[channel], channels[channel], numSamples, start, end);
+    }
+}
+
+template <int adaaOrder>
+void AntiderivativeShaper::refreshHistory (ChannelState& state, const Curve& curve) const noexcept
+{
+    if constexpr (adaaOrder == 1)
+    {
+        state.f1 = curve.firstAntiderivative (state.x1);
+    }
+    else
+    {
+        state.f1 = curve.secondAntiderivative (state.x1);
+        auto dx = state.x1 - state.x2;
+
+        state.d12 = std::abs (dx) < tolerance ? curve.firstAntiderivative (0.5 * (state.x1 + state.x2))
+                                              : (state.f1 - curve.secondAntiderivative (state.x2)) / dx;
+    }
+}
+
+template <int adaaOrder, typename SampleType>
+void AntiderivativeShaper::processChannel (ChannelState& state, SampleType* data, int numSamples,
+                                           const DistortionParameters& start, const DistortionParameters& end) noexcept
+{
+    if (numSamples <= 0)
+        return;
+
+    // While drive or threshold move the curve is updated every few samples, which is
+    // close enough to a per sample ramp and keeps its setup cost out of the inner loop.
+    const bool curveMoving = start.drive != end.drive || start.threshold != end.threshold;
+    const int rampStep = curveMoving ? 16 : numSamples;
+    const auto step = 1.0f / (float) numSamples;
+
+    Curve curve;
+    curve.set (start.drive, start.threshold);
+
+    if (! state.primed)
+    {
+        state.x1 = state.x2 = (double) data[0];
+        state.primed = true;
+    }
+
+    refreshHistory<adaaOrder> (state, curve);
+
+    for (int offset = 0; offset < numSamples; offset += rampStep)
+    {
+        auto length = std::min (rampStep, numSamples - offset);
+
+        if (curveMoving)
+        {
+            auto alpha = (float) (offset + length) * step;
+            curve.set (start.drive + (end.drive - start.drive) * alpha,
+                       start.threshold + (end.threshold - start.threshold) * alpha);
+            refreshHistory<adaaOrder> (state, curve);
+        }
+
+        for (int i = offset; i < offset + length; ++i)
+        {
+            auto x0 = (double) data[i];
+            double y, delayed;
+
+            if constexpr (adaaOrder == 1)
+            {
+                // Half a sample back, as the wet signal is
+                delayed = 0.5 * (x0 + state.x1);
+
+                auto f0 = curve.firstAntiderivative (x0);
+                auto dx = x0 - state.x1;
+
+                y = std::abs (dx) < tolerance ? curve.evaluate (0.5 * (x0 + state.x1))
+                                              : (f0 - state.f1) / dx;
+                state.x1 = x0;
+                state.f1 = f0;
+            }
+            else
+            {
+                delayed = state.x1;
+
+                auto f0 = curve.secondAntiderivative (x0);
+                auto dx = x0 - state.x1;
+
+                auto d01 = std::abs (dx) < tolerance ? curve.firstAntiderivative (0.5 * (x0 + state.x1))
+                                                     : (f0 - state.f1) / dx;
+                auto span = x0 - state.x2;
+
+                if (std::abs (span) >= tolerance)
+                {
+                    y = 2.0 * (d01 - state.d12) / span;
+                }
+                else
+                {
+                    // x[n] and x[n-2] are about the same point: average over the
+                    // segment from their midpoint to x[n-1] and back instead
+                    auto middle = 0.5 * (x0 + state.x2);
+                    auto delta = middle - state.x1;
+
+                    y = std::abs (delta) < tolerance
+                            ? curve.evaluate (0.5 * (middle + state.x1))
+                            : 2.0 / delta * (curve.firstAntiderivative (middle)
+                                              + (state.f1 - curve.secondAntiderivative (middle)) / delta);
+                }
+
+                state.x2 = state.x1;
+                state.x1 = x0;
+                state.f1 = f0;
+                state.d12 = d01;
+            }
+
+            // The same mix and output level as the other evaluation methods
+            auto alpha = (float) (i + 1) * step;
+            auto wet = start.wet + (end.wet - start.wet) * alpha;
+            auto dry = start.dry + (end.dry - start.dry) * alpha;
+            auto outputLvl = start.outputLvl + (end.outputLvl - start.outputLvl) * alpha;
+
+            data[i] = (SampleType) (((double) dry * delayed + (double) wet * y) * (double) outputLvl);
+        }
+    }
+}
+
+//==============================================================================
+template void AntiderivativeShaper::process (float* const*,  int, int, const DistortionParameters&, const DistortionParameters&) noexcept;
+template void AntiderivativeShaper::process (double* const*, int, int, const DistortionParameters&, const DistortionParameters&) noexcept;
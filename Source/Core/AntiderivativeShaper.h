@@ -0,0 +1,106 @@
+/*
+  ==============================================================================
+
+    AntiderivativeShaper.h
+
+    The distortion curve with antiderivative anti-aliasing (ADAA). Instead of
+    f (x[n]), first order ADAA outputs the average of f over the straight line
+    from x[n-1] to x[n]:
+
+        y[n] = (F1 (x[n]) - F1 (x[n-1])) / (x[n] - x[n-1])
+
+    and second order does the same once more with the second antiderivative
+    F2. Averaging over the segment removes most of what would alias, at the
+    base sample rate, for the price of half a sample (first order) or one
+    sample (second order) of delay on the distorted signal and a gentle roll
+    off towards Nyquist.
+
+    The dry signal is delayed to match, or the mix would comb filter: first
+    order mixes in the average of x[n] and x[n-1], which is exactly what the
+    curve gives for a straight line, and second order mixes in x[n-1]. The
+    whole output is then a sample late with second order, which is reported
+    by getLatencyInSamples(). First order's half sample is too little to
+    report.
+
+    clamp (tanh (x * drive), +-threshold) has closed form antiderivatives: log
+    cosh up to the clip point and a straight line past it for F1, and for F2 an
+    integral of log cosh that comes down to a dilogarithm. They're evaluated in
+    double whatever the sample type, since the divided differences cancel most
+    of their digits. When consecutive inputs are closer than a small tolerance
+    the differences fall back to evaluating the curve at the midpoint.
+
+    No JUCE in here, like the other DSP building blocks.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <limits>
+#include "DistortionParameters.h"
+
+//==============================================================================
+class AntiderivativeShaper
+{
+public:
+    static constexpr int maxChannels = 16;
+
+    /** Inputs closer together than this use the midpoint fallback. */
+    static constexpr double tolerance = 1.0e-4;
+
+    AntiderivativeShaper() = default;
+
+    /** 1 or 2. Changing it clears the history. */
+    void setOrder (int newOrder) noexcept;
+    int getOrder() const noexcept       { return order; }
+
+    /** How many samples of input the output still depends on once the input stops. */
+    int getTailLengthInSamples() const noexcept     { return order; }
+
+    /** The whole samples the output (wet and dry) is late by: 1 for second order, else 0. */
+    int getLatencyInSamples() const noexcept        { return order - 1; }
+
+    /** Forgets the previous samples. The next sample seen on each channel starts its history. */
+    void reset() noexcept;
+
+    /** Distorts the channels in place, including the dry/wet mix and output level, the
+        same as the waveshaper kernel. Each channel keeps its own history.
+    */
+    template <typename SampleType>
+    void process (SampleType* const* channels, int numChannels, int numSamples,
+                  const DistortionParameters& start, const DistortionParameters& end) noexcept;
+
+    //==============================================================================
+    /** The curve and its first two antiderivatives, for one drive and threshold. */
+    struct Curve
+    {
+        void set (float newDrive, float newThreshold) noexcept;
+
+        double evaluate (double x) const noexcept;
+        double firstAntiderivative (double x) const noexcept;
+        double secondAntiderivative (double x) const noexcept;
+
+        double drive = 1.0, threshold = 1.0;
+        double clipPoint = std::numeric_limits<double>::infinity();     // input where the clamp starts
+        double clipF1 = 0.0, clipF2 = 0.0;                                // F1 and F2 at clipPoint
+    };
+
+private:
+    struct ChannelState
+    {
+        double x1 = 0.0, x2 = 0.0;      // the previous two inputs
+        double f1 = 0.0;                // the antiderivative of this order at x1
+        double d12 = 0.0;               // second order: the divided difference between x1 and x2
+        bool primed = false;
+    };
+
+    template <int adaaOrder, typename SampleType>
+    void processChannel (ChannelState& state, SampleType* data, int numSamples,
+                         const DistortionParameters& start, const DistortionParameters& end) noexcept;
+
+    template <int adaaOrder>
+    void refreshHistory (ChannelState& state, const Curve& curve) const noexcept;
+
+    ChannelState states[maxChannels];
+    int order = 1;
+};
@@ -0,0 +1,121 @@
+/*
+  ==============================================================================
+
+    DistortionCore.cpp
+
+  ==============================================================================
+*/
+
+#include "DistortionCore.h"
+
+#include <algorithm>
+
+//==============================================================================
+DistortionCore::DistortionCore()
+{
+    adaaSecond.setOrder (2);
+}
+
+void DistortionCore::prepare (double sampleRate, double rampLengthSeconds) noexcept
+{
+    ramp.prepare (sampleRate, targets, rampLengthSeconds);
+    reset();
+}
+
+void DistortionCore::reset() noexcept
+{
+    adaaFirst.reset();
+    adaaSecond.reset();
+}
+
+void DistortionCore::reset (Curve curveToReset) noexcept
+{
+    if (curveToReset == Curve::adaaFirstOrder)
+        adaaFirst.reset();
+    else if (curveToReset == Curve::adaaSecondOrder)
+        adaaSecond.reset();
+}
+
+void DistortionCore::setCurve (Curve newCurve) noexcept
+{
+    // Whatever history the shaper has is from the last time it ran
+    if (newCurve != curve)
+        reset (newCurve);
+
+    curve = newCurve;
+}
+
+int DistortionCore::getTailLengthInSamples (Curve curveToCheck) const noexcept
+{
+    if (curveToCheck == Curve::adaaSecondOrder)
+        return adaaSecond.getTailLengthInSamples();
+
+    return curveToCheck == Curve::adaaFirstOrder ? adaaFirst.getTailLengthInSamples() : 0;
+}
+
+int DistortionCore::getLatencyInSamples (Curve curveToCheck) const noexcept
+{
+    if (curveToCheck == Curve::adaaSecondOrder)
+        return adaaSecond.getLatencyInSamples();
+
+    return curveToCheck == Curve::adaaFirstOrder ? adaaFirst.getLatencyInSamples() : 0;
+}
+
+//==============================================================================
+void DistortionCore::process (float* const* channels, int numChannels, int numSamples) noexcept
+{
+    processSamples (channels, numChannels, numSamples);
+}
+
+void DistortionCore::process (double* const* channels, int numChannels, int numSamples) noexcept
+{
+    processSamples (channels, numChannels, numSamples);
+}
+
+template <typename SampleType>
+void DistortionCore::processSamples (SampleType* const* channels, int numChannels, int numSamples) noexcept
+{
+    numChannels = std::min (numChannels, maxChannels);
+    SampleType* chunk[maxChannels];
+
+    for (int offset = 0; offset < numSamples; offset += maxRampBlock)
+    {
+        auto length = std::min (maxRampBlock, numSamples - offset);
+
+        for (int channel = 0; channel < numChannels; ++channel)
+            chunk[channel] = channels[channel] + offset;
+
+        DistortionParameters start, end;
+        ramp.update (length, targets, start, end);
+        shape (curve, chunk, numChannels, length, start, end);
+    }
+}
+
+template <typename SampleType>
+void DistortionCore::shape (Curve curveToUse, SampleType* const* channels, int numChannels, int numSamples,
+                            const DistortionParameters& start, const DistortionParameters& end) noexcept
+{
+    switch (curveToUse)
+    {
+        case Curve::adaaFirstOrder:
+            adaaFirst.process (channels, numChannels, numSamples, start, end);
+            break;
+
+        case Curve::adaaSecondOrder:
+            adaaSecond.process (channels, numChannels, numSamples, start, end);
+            break;
+
+        case Curve::exact:
+            WaveshaperKernel::process (channels, numChannels, numSamples, start, end, WaveshaperKernel::Accuracy::exact);
+            break;
+
+        case Curve::fast:
+        default:
+            WaveshaperKernel::process (channels, numChannels, numSamples, start, end, WaveshaperKernel::Accuracy::fast);
+            break;
+    }
+}
+
+//==============================================================================
+template void DistortionCore::shape (Curve, float* const*,  int, int, const DistortionParameters&, const DistortionParameters&) noexcept;
+template void DistortionCore::shape (Curve, double* const*, int, int, const DistortionParameters&, const DistortionParameters&) noexcept;
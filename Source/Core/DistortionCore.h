@@ -0,0 +1,114 @@
+/*
+  ==============================================================================
+
+    DistortionCore.h
+
+    The distortion on its own, over raw float or double channel pointers, for
+    embedding in an audio engine that isn't a plugin host. Parameters are set
+    in the units the plugin shows them in and ramped the same way, and the
+    curve runs through the same SIMD kernels and ADAA as in the plugin, so
+    both sound identical at the base sample rate.
+
+    Everything in this directory depends on the standard library only. To
+    use it elsewhere, compile the .cpp files here (the AVX2 and AVX-512 ones
+    switch their instruction set on themselves, no extra flags needed) and
+    include this header.
+
+    The plugin is a wrapper around the same code: Waveshaper calls shape()
+    for every evaluation method except the tables, and ParameterSnapshot uses
+    ParameterRamp. What does need JUCE stays in the wrapper - the parameters
+    and state, the tables built on a background thread, oversampling and the
+    multiband crossovers.
+
+    Not thread safe: set parameters from the thread that calls process(), in
+    between calls. Nothing here allocates or locks.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "AntiderivativeShaper.h"
+#include "DistortionParameters.h"
+#include "ParameterRamp.h"
+#include "WaveshaperKernel.h"
+
+//==============================================================================
+class DistortionCore
+{
+public:
+    /** How the curve is evaluated. */
+    enum class Curve
+    {
+        exact,              // std::tanh
+        fast,               // Pade approximant, see WaveshaperKernel::Accuracy
+        adaaFirstOrder,     // std::tanh with antiderivative anti-aliasing, see AntiderivativeShaper
+        adaaSecondOrder
+    };
+
+    static constexpr int maxChannels = AntiderivativeShaper::maxChannels;
+
+    /** The longest stretch process() ramps the parameters across in one go. Longer calls
+        are split up, so the ramps don't slow down with the block size.
+    */
+    static constexpr int maxRampBlock = 512;
+
+    DistortionCore();
+
+    /** Sets how long parameter changes take to ramp in, jumps to the current
+        parameters and clears the history.
+    */
+    void prepare (double sampleRate, double rampLengthSeconds = 0.05) noexcept;
+
+    /** Clears the ADAA history, e.g. after a gap in the input. */
+    void reset() noexcept;
+
+    /** Drive, output level and threshold in dB, the two mixes in percent. */
+    void setParameters (const PlainParameters& newParameters) noexcept     { targets = newParameters.toGains(); }
+
+    void setCurve (Curve newCurve) noexcept;
+    Curve getCurve() const noexcept         { return curve; }
+
+    /** The input samples the output still depends on once the input stops. */
+    int getTailLengthInSamples() const noexcept     { return getTailLengthInSamples (curve); }
+
+    /** How late the output is, in whole samples: 1 with second order ADAA, else 0.
+        Report it to the host or line other signals up with it.
+    */
+    int getLatencyInSamples() const noexcept        { return getLatencyInSamples (curve); }
+
+    /** Distorts numSamples samples of numChannels channels in place, with the dry/wet
+        mix and output level. Parameters set since the last call ramp in from here.
+        Denormals aren't flushed here, that's up to the caller.
+    */
+    void process (float* const* channels, int numChannels, int numSamples) noexcept;
+    void process (double* const* channels, int numChannels, int numSamples) noexcept;
+
+    //==============================================================================
+    /** The curve alone, with the parameters at the start and end of the span given
+        rather than ramped here: for callers that ramp, crossfade or oversample around
+        it, like the plugin. Each ADAA order keeps its own history.
+    */
+    template <typename SampleType>
+    void shape (Curve curveToUse, SampleType* const* channels, int numChannels, int numSamples,
+                const DistortionParameters& start, const DistortionParameters& end) noexcept;
+
+    /** Clears the history of one curve only. */
+    void reset (Curve curveToReset) noexcept;
+
+    int getTailLengthInSamples (Curve curveToCheck) const noexcept;
+    int getLatencyInSamples (Curve curveToCheck) const noexcept;
+
+private:
+    template <typename SampleType>
+    void processSamples (SampleType* const* channels, int numChannels, int numSamples) noexcept;
+
+    ParameterRamp ramp;
+    DistortionParameters targets;
+    Curve curve = Curve::fast;
+
+    AntiderivativeShaper adaaFirst, adaaSecond;     // separate, so a caller can crossfade between them
+
+    DistortionCore (const DistortionCore&) = delete;
+    DistortionCore& operator= (const DistortionCore&) = delete;
+};
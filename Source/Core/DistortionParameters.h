@@ -0,0 +1,74 @@
+/*
+  ==============================================================================
+
+    DistortionParameters.h
+
+    The values the distortion runs with, already converted to linear gains.
+    Part of the core (see DistortionCore.h), so no JUCE in here.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <cmath>
+
+//==============================================================================
+/** The five distortion parameters, already converted to linear gains. */
+struct DistortionParameters
+{
+    float drive     = 1.0f;
+    float outputLvl = 1.0f;
+    float wet       = 0.5f;
+    float dry       = 0.5f;
+    float threshold = 1.0f;
+
+    bool operator== (const DistortionParameters& other) const noexcept
+    {
+        return drive == other.drive && outputLvl == other.outputLvl && wet == other.wet
+            && dry == other.dry && threshold == other.threshold;
+    }
+
+    bool operator!= (const DistortionParameters& other) const noexcept    { return ! operator== (other); }
+};
+
+//==============================================================================
+/** The same five values in the units the user sets them in: dB for drive, output
+    level and threshold, percent for the two mixes. Presets are stored like this,
+    and morphing between two sets happens in these units so that a sweep sounds
+    even rather than bunching up at one end.
+*/
+struct PlainParameters
+{
+    float drive     = 0.0f;
+    float outputLvl = 0.0f;
+    float wet       = 50.0f;
+    float dry       = 50.0f;
+    float threshold = 1.0f;
+
+    /** amount = 0 gives these values, 1 gives other, anything between is a straight line. */
+    PlainParameters interpolatedTowards (const PlainParameters& other, float amount) const noexcept
+    {
+        auto lerp = [amount] (float a, float b) { return a + (b - a) * amount; };
+
+        return { lerp (drive, other.drive), lerp (outputLvl, other.outputLvl), lerp (wet, other.wet),
+                 lerp (dry, other.dry), lerp (threshold, other.threshold) };
+    }
+
+    /** Converts to the linear gains the DSP runs with. Anything at or below -100 dB is
+        silence, the same as juce::Decibels::decibelsToGain().
+    */
+    DistortionParameters toGains() const noexcept
+    {
+        auto gain = [] (float decibels) { return decibels > -100.0f ? std::pow (10.0f, decibels * 0.05f) : 0.0f; };
+
+        DistortionParameters p;
+        p.drive     = gain (drive);
+        p.outputLvl = gain (outputLvl);
+        p.wet       = wet / 100.0f;
+        p.dry       = dry / 100.0f;
+        p.threshold = gain (threshold);
+
+        return p;
+    }
+};
@@ -0,0 +1,140 @@
+/*
+  ==============================================================================
+
+    ParameterRamp.h
+
+    Linear ramps for the five distortion parameters, advanced a whole block at
+    a time. Each value moves exactly as juce::SmoothedValue with linear
+    smoothing would (same step size, same rounding), so the plugin and
+    anything else built on the core respond to parameter changes alike.
+
+    No JUCE in here.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <cmath>
+#include "DistortionParameters.h"
+
+//==============================================================================
+/** One linearly ramped value. */
+class LinearRamp
+{
+public:
+    LinearRamp() = default;
+
+    /** Sets how many samples a ramp takes and jumps to the current target. */
+    void reset (double sampleRate, double rampLengthSeconds) noexcept
+    {
+        stepsToTarget = (int) std::floor (rampLengthSeconds * sampleRate);
+        setCurrentAndTarget (target);
+    }
+
+    void setCurrentAndTarget (float newValue) noexcept
+    {
+        current = target = newValue;
+        countdown = 0;
+    }
+
+    /** Starts a new ramp from wherever the value is now. */
+    void setTarget (float newTarget) noexcept
+    {
+        if (newTarget == target)
+            return;
+
+        if (stepsToTarget <= 0)
+        {
+            setCurrentAndTarget (newTarget);
+            return;
+        }
+
+        target = newTarget;
+        countdown = stepsToTarget;
+        step = (target - current) / (float) countdown;
+    }
+
+    float getCurrent() const noexcept       { return current; }
+    bool isRamping() const noexcept         { return countdown > 0; }
+
+    /** Moves numSamples along the ramp and returns the value it got to. */
+    float skip (int numSamples) noexcept
+    {
+        if (numSamples >= countdown)
+        {
+            setCurrentAndTarget (target);
+            return target;
+        }
+
+        current += step * (float) numSamples;
+        countdown -= numSamples;
+        return current;
+    }
+
+private:
+    float current = 0.0f, target = 0.0f, step = 0.0f;
+    int countdown = 0, stepsToTarget = 0;
+};
+
+//==============================================================================
+/**
+    Ramps all five parameters. Call update() once per block with the values the
+    block should head for: it gives back the values at the start and at the end
+    of the block. If they're equal nothing is moving and the whole block can
+    run with constants, otherwise the DSP ramps linearly from start to end
+    across the block, which is what the ramps would have produced sample by
+    sample.
+*/
+class ParameterRamp
+{
+public:
+    ParameterRamp() = default;
+
+    /** Sets the ramp length and jumps straight to the given values. */
+    void prepare (double sampleRate, const DistortionParameters& initial, double rampLengthSeconds = 0.05) noexcept
+    {
+        drive    .reset (sampleRate, rampLengthSeconds);
+        outputLvl.reset (sampleRate, rampLengthSeconds);
+        wet      .reset (sampleRate, rampLengthSeconds);
+        dry      .reset (sampleRate, rampLengthSeconds);
+        threshold.reset (sampleRate, rampLengthSeconds);
+
+        drive    .setCurrentAndTarget (initial.drive);
+        outputLvl.setCurrentAndTarget (initial.outputLvl);
+        wet      .setCurrentAndTarget (initial.wet);
+        dry      .setCurrentAndTarget (initial.dry);
+        threshold.setCurrentAndTarget (initial.threshold);
+    }
+
+    /** Heads for targets and advances the ramps by numSamples.
+        Returns true if any value moves during this block.
+    */
+    bool update (int numSamples, const DistortionParameters& targets,
+                 DistortionParameters& start, DistortionParameters& end) noexcept
+    {
+        drive    .setTarget (targets.drive);
+        outputLvl.setTarget (targets.outputLvl);
+        wet      .setTarget (targets.wet);
+        dry      .setTarget (targets.dry);
+        threshold.setTarget (targets.threshold);
+
+        start.drive     = advance (drive,     numSamples, end.drive);
+        start.outputLvl = advance (outputLvl, numSamples, end.outputLvl);
+        start.wet       = advance (wet,       numSamples, end.wet);
+        start.dry       = advance (dry,       numSamples, end.dry);
+        start.threshold = advance (threshold, numSamples, end.threshold);
+
+        return start != end;
+    }
+
+private:
+    static float advance (LinearRamp& value, int numSamples, float& endValue) noexcept
+    {
+        auto startValue = value.getCurrent();
+        endValue = value.isRamping() ? value.skip (numSamples) : startValue;
+        return startValue;
+    }
+
+    LinearRamp drive, outputLvl, wet, dry, threshold;
+};
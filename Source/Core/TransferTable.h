@@ -0,0 +1,121 @@
+/*
+  ==============================================================================
+
+    TransferTable.h
+
+    The whole nonlinearity, clamp (tanh (x * drive), +-threshold), baked into a
+    table so that the per-sample work is a cubic interpolation instead of a
+    transcendental function. A table is only valid for the drive and threshold
+    it was built with; Waveshaper takes care of rebuilding it off the audio
+    thread when those change.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <array>
+#include <cmath>
+#include "DistortionParameters.h"
+
+//==============================================================================
+class TransferTable
+{
+public:
+    static constexpr int numPoints = 1024;
+
+    /** Fills the table for the given drive and threshold (both linear gains).
+        This calls std::tanh a thousand times, so keep it off the audio thread.
+    */
+    void build (float newDrive, float newThreshold) noexcept
+    {
+        drive = newDrive;
+        threshold = newThreshold;
+
+        // Past the point where the curve hits the threshold (or where tanh has
+        // reached 1 to within float precision) the output is constant, so the
+        // table only has to cover the part of the input range that bends.
+        auto saturation = threshold < 1.0f ? std::atanh (threshold) : 9.0f;
+        range = saturation / drive;
+        scale = (float) (numPoints - 1) / (2.0f * range);
+
+        // points[k + 1] holds input sample k, with one guard point in front and two behind
+        for (int k = -1; k <= numPoints + 1; ++k)
+            points[(size_t) (k + 1)] = curve (-range + (float) k / scale);
+    }
+
+    bool matches (float otherDrive, float otherThreshold) const noexcept
+    {
+        return drive == otherDrive && threshold == otherThreshold;
+    }
+
+    /** The curve the table approximates, evaluated exactly. */
+    float curve (float x) const noexcept
+    {
+        auto y = std::tanh (x * drive);
+        return y > threshold ? threshold : (y < -threshold ? -threshold : y);
+    }
+
+    /** Catmull-Rom interpolation between the four points around x. */
+    float evaluate (float x) const noexcept
+    {
+        auto position = (x + range) * scale;
+        position = position < 0.0f ? 0.0f : (position > (float) (numPoints - 1) ? (float) (numPoints - 1) : position);
+
+        auto index = (int) position;
+        auto t = position - (float) index;
+
+        auto p0 = points[(size_t) index];
+        auto p1 = points[(size_t) index + 1];
+        auto p2 = points[(size_t) index + 2];
+        auto p3 = points[(size_t) index + 3];
+
+        auto a = p1;
+        auto b = 0.5f * (p2 - p0);
+        auto c = p0 - 2.5f * p1 + 2.0f * p2 - 0.5f * p3;
+        auto d = 0.5f * (p3 - p0) + 1.5f * (p1 - p2);
+
+        return a + t * (b + t * (c + t * d));
+    }
+
+    /** The same dry/wet mix and output level as the waveshaper kernel, using the table.
+        With doubles, only the table lookup itself runs in single precision.
+    */
+    template <typename SampleType>
+    void process (SampleType* data, int numSamples, float wet, float dry, float outputLvl) const noexcept
+    {
+        for (int i = 0; i < numSamples; ++i)
+            data[i] = ((SampleType) dry * data[i] + (SampleType) wet * (SampleType) evaluate ((float) data[i]))
+                        * (SampleType) outputLvl;
+    }
+
+    /** The same, with the mix and output level ramping across the block as the kernel
+        ramps them. Drive and threshold are the table's own, so only those have to hold.
+    */
+    template <typename SampleType>
+    void process (SampleType* data, int numSamples, const DistortionParameters& start, const DistortionParameters& end) const noexcept
+    {
+        if (start.wet == end.wet && start.dry == end.dry && start.outputLvl == end.outputLvl)
+        {
+            process (data, numSamples, start.wet, start.dry, start.outputLvl);
+            return;
+        }
+
+        const auto step = (SampleType) 1 / (SampleType) numSamples;
+
+        for (int i = 0; i < numSamples; ++i)
+        {
+            auto alpha = (SampleType) (i + 1) * step;
+            auto wet = (SampleType) start.wet       + alpha * ((SampleType) end.wet       - (SampleType) start.wet);
+            auto dry = (SampleType) start.dry       + alpha * ((SampleType) end.dry       - (SampleType) start.dry);
+            auto out = (SampleType) start.outputLvl + alpha * ((SampleType) end.outputLvl - (SampleType) start.outputLvl);
+
+            data[i] = (dry * data[i] + wet * (SampleType) evaluate ((float) data[i])) * out;
+        }
+    }
+
+private:
+    float drive = 1.0f, threshold = 1.0f;
+    float range = 1.0f, scale = 1.0f;
+    std::array<float, numPoints + 3> points {};
+};
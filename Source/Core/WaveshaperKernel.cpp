@@ -0,0 +1,367 @@
+/*
+  ==============================================================================
+
+    WaveshaperKernel.cpp
+
+    Runtime dispatch for the waveshaper kernel, plus the variants that need no
+    special compiler flags: plain scalar code, SSE2 (always available on
+    x86-64) and NEON (always available on arm64). The AVX2 and AVX-512
+    variants live in their own translation units.
+
+  ==============================================================================
+*/
+
+#include "WaveshaperKernel.h"
+
+#if HYPERBOLIC_KERNEL_SSE2
+ #include <emmintrin.h>
+#endif
+
+#if HYPERBOLIC_KERNEL_X86
+ #if defined (_MSC_VER)
+  #include <intrin.h>
+ #else
+  #include <cpuid.h>
+ #endif
+#endif
+
+#if HYPERBOLIC_KERNEL_NEON
+ #include <arm_neon.h>
+#endif
+
+#include "WaveshaperKernelImpl.h"
+
+namespace
+{
+
+#if HYPERBOLIC_KERNEL_X86
+/** What the CPU and the OS support, asked once. The AVX flags also need the OS
+    to save the wider registers on a context switch, which XGETBV tells us.
+*/
+struct CpuFeatures
+{
+    CpuFeatures() noexcept
+    {
+        unsigned int leaf0[4], leaf1[4], leaf7[4] = {};
+        cpuid (0, leaf0);
+        cpuid (1, leaf1);
+
+        if (leaf0[0] >= 7)
+            cpuid (7, leaf7);
+
+        const bool osSavesAvx = (leaf1[2] & (1u << 27)) != 0 && (readXcr0() & 0x06) == 0x06;
+        const bool osSavesAvx512 = osSavesAvx && (readXcr0() & 0xe6) == 0xe6;
+
+        sse2    = (leaf1[3] & (1u << 26)) != 0;
+        avx2    = osSavesAvx && (leaf7[1] & (1u << 5)) != 0;
+        fma3    = osSavesAvx && (leaf1[2] & (1u << 12)) != 0;
+        avx512f = osSavesAvx512 && (leaf7[1] & (1u << 16)) != 0;
+    }
+
+    static void cpuid (unsigned int leaf, unsigned int* registers) noexcept
+    {
+       #if defined (_MSC_VER)
+        int result[4];
+        __cpuidex (result, (int) leaf, 0);
+
+        for (int i = 0; i < 4; ++i)
+            registers[i] = (unsigned int) result[i];
+       #else
+        __cpuid_count (leaf, 0, registers[0], registers[1], registers[2], registers[3]);
+       #endif
+    }
+
+    static unsigned long long readXcr0() noexcept
+    {
+       #if defined (_MSC_VER)
+        return _xgetbv (0);
+       #else
+        unsigned int low, high;
+        __asm__ volatile ("xgetbv" : "=a" (low), "=d" (high) : "c" (0));
+        return ((unsigned long long) high << 32) | low;
+       #endif
+    }
+
+    static const CpuFeatures& get() noexcept
+    {
+        static const CpuFeatures features;
+        return features;
+    }
+
+    bool sse2 = false, avx2 = false, fma3 = false, avx512f = false;
+};
+#endif
+
+#if HYPERBOLIC_KERNEL_SSE2
+template <typename SampleType> struct SSE2Vector;
+
+template <>
+struct SSE2Vector<float>
+{
+    using Sample = float;
+    using Type = __m128;
+    static constexpr int width = 4;
+
+    static Type load (const Sample* p) noexcept         { return _mm_loadu_ps (p); }
+    static void store (Sample* p, Type v) noexcept      { _mm_storeu_ps (p, v); }
+    static Type set (Sample v) noexcept                 { return _mm_set1_ps (v); }
+    static Type lanes() noexcept                        { return _mm_setr_ps (0.0f, 1.0f, 2.0f, 3.0f); }
+    static Type add (Type a, Type b) noexcept           { return _mm_add_ps (a, b); }
+    static Type sub (Type a, Type b) noexcept           { return _mm_sub_ps (a, b); }
+    static Type mul (Type a, Type b) noexcept           { return _mm_mul_ps (a, b); }
+    static Type div (Type a, Type b) noexcept           { return _mm_div_ps (a, b); }
+    static Type min (Type a, Type b) noexcept           { return _mm_min_ps (a, b); }
+    static Type max (Type a, Type b) noexcept           { return _mm_max_ps (a, b); }
+};
+
+template <>
+struct SSE2Vector<double>
+{
+    using Sample = double;
+    using Type = __m128d;
+    static constexpr int width = 2;
+
+    static Type load (const Sample* p) noexcept         { return _mm_loadu_pd (p); }
+    static void store (Sample* p, Type v) noexcept      { _mm_storeu_pd (p, v); }
+    static Type set (Sample v) noexcept                 { return _mm_set1_pd (v); }
+    static Type lanes() noexcept                        { return _mm_setr_pd (0.0, 1.0); }
+    static Type add (Type a, Type b) noexcept           { return _mm_add_pd (a, b); }
+    static Type sub (Type a, Type b) noexcept           { return _mm_sub_pd (a, b); }
+    static Type mul (Type a, Type b) noexcept           { return _mm_mul_pd (a, b); }
+    static Type div (Type a, Type b) noexcept           { return _mm_div_pd (a, b); }
+    static Type min (Type a, Type b) noexcept           { return _mm_min_pd (a, b); }
+    static Type max (Type a, Type b) noexcept           { return _mm_max_pd (a, b); }
+};
+#endif
+
+#if HYPERBOLIC_KERNEL_NEON
+template <typename SampleType> struct NeonVector;
+
+template <>
+struct NeonVector<float>
+{
+    using Sample = float;
+    using Type = float32x4_t;
+    static constexpr int width = 4;
+
+    static Type load (const Sample* p) noexcept         { return vld1q_f32 (p); }
+    static void store (Sample* p, Type v) noexcept      { vst1q_f32 (p, v); }
+    static Type set (Sample v) noexcept                 { return vdupq_n_f32 (v); }
+    static Type lanes() noexcept                        { const float l[] = { 0.0f, 1.0f, 2.0f, 3.0f }; return vld1q_f32 (l); }
+    static Type add (Type a, Type b) noexcept           { return vaddq_f32 (a, b); }
+    static Type sub (Type a, Type b) noexcept           { return vsubq_f32 (a, b); }
+    static Type mul (Type a, Type b) noexcept           { return vmulq_f32 (a, b); }
+    static Type div (Type a, Type b) noexcept           { return vdivq_f32 (a, b); }
+    static Type min (Type a, Type b) noexcept           { return vminq_f32 (a, b); }
+    static Type max (Type a, Type b) noexcept           { return vmaxq_f32 (a, b); }
+};
+
+template <>
+struct NeonVector<double>
+{
+    using Sample = double;
+    using Type = float64x2_t;
+    static constexpr int width = 2;
+
+    static Type load (const Sample* p) noexcept         { return vld1q_f64 (p); }
+    static void store (Sample* p, Type v) noexcept      { vst1q_f64 (p, v); }
+    static Type set (Sample v) noexcept                 { return vdupq_n_f64 (v); }
+    static Type lanes() noexcept                        { const double l[] = { 0.0, 1.0 }; return vld1q_f64 (l); }
+    static Type add (Type a, Type b) noexcept           { return vaddq_f64 (a, b); }
+    static Type sub (Type a, Type b) noexcept           { return vsubq_f64 (a, b); }
+    static Type mul (Type a, Type b) noexcept           { return vmulq_f64 (a, b); }
+    static Type div (Type a, Type b) noexcept           { return vdivq_f64 (a, b); }
+    static Type min (Type a, Type b) noexcept           { return vminq_f64 (a, b); }
+    static Type max (Type a, Type b) noexcept           { return vmaxq_f64 (a, b); }
+};
+#endif
+
+} // namespace
+
+namespace WaveshaperKernel
+{
+
+namespace detail
+{
+    template <typename SampleType>
+    using ProcessFunction = void (*) (SampleType* const*, int, int, const DistortionParameters&, const DistortionParameters&, int) noexcept;
+
+    template <typename SampleType>
+    using BandFunction = void (*) (const SampleType*, SampleType*, int, const DistortionParameters*, bool) noexcept;
+
+   #if HYPERBOLIC_KERNEL_X86
+    // Defined in WaveshaperKernelAVX2.cpp and WaveshaperKernelAVX512.cpp
+    void processAVX2   (float* const*,  int, int, const DistortionParameters&, const DistortionParameters&, int) noexcept;
+    void processAVX2   (double* const*, int, int, const DistortionParameters&, const DistortionParameters&, int) noexcept;
+    void processAVX512 (float* const*,  int, int, const DistortionParameters&, const DistortionParameters&, int) noexcept;
+    void processAVX512 (double* const*, int, int, const DistortionParameters&, const DistortionParameters&, int) noexcept;
+
+    void processBandsAVX2   (const float*,  float*,  int, const DistortionParameters*, bool) noexcept;
+    void processBandsAVX2   (const double*, double*, int, const DistortionParameters*, bool) noexcept;
+    void processBandsAVX512 (const float*,  float*,  int, const DistortionParameters*, bool) noexcept;
+    void processBandsAVX512 (const double*, double*, int, const DistortionParameters*, bool) noexcept;
+   #endif
+}
+
+namespace
+{
+    template <typename SampleType>
+    detail::ProcessFunction<SampleType> getFunction (InstructionSet set) noexcept
+    {
+        switch (set)
+        {
+           #if HYPERBOLIC_KERNEL_SSE2
+            case InstructionSet::sse2:      return WaveshaperImpl<SSE2Vector<SampleType>>::process;
+           #endif
+           #if HYPERBOLIC_KERNEL_X86
+            case InstructionSet::avx2:      return detail::processAVX2;
+            case InstructionSet::avx512:    return detail::processAVX512;
+           #endif
+           #if HYPERBOLIC_KERNEL_NEON
+            case InstructionSet::neon:      return WaveshaperImpl<NeonVector<SampleType>>::process;
+           #endif
+            default:                        break;
+        }
+
+        return WaveshaperImpl<ScalarVector<SampleType>>::process;
+    }
+
+    template <typename SampleType>
+    detail::BandFunction<SampleType> getBandFunction (InstructionSet set) noexcept
+    {
+        switch (set)
+        {
+           #if HYPERBOLIC_KERNEL_SSE2
+            case InstructionSet::sse2:      return WaveshaperImpl<SSE2Vector<SampleType>>::processBands;
+           #endif
+           #if HYPERBOLIC_KERNEL_X86
+            case InstructionSet::avx2:      return detail::processBandsAVX2;
+            case InstructionSet::avx512:    return detail::processBandsAVX512;
+           #endif
+           #if HYPERBOLIC_KERNEL_NEON
+            case InstructionSet::neon:      return WaveshaperImpl<NeonVector<SampleType>>::processBands;
+           #endif
+            default:                        break;
+        }
+
+        return WaveshaperImpl<ScalarVector<SampleType>>::processBands;
+    }
+
+    InstructionSet findBestInstructionSet() noexcept
+    {
+        const InstructionSet preferred[] = { InstructionSet::avx512, InstructionSet::avx2,
+                                             InstructionSet::sse2, InstructionSet::neon };
+
+        for (auto set : preferred)
+            if (isSupported (set))
+                return set;
+
+        return InstructionSet::scalar;
+    }
+
+    // Picked once, when the plugin binary is loaded
+    InstructionSet activeInstructionSet = findBestInstructionSet();
+    detail::ProcessFunction<float>  activeFloatFunction  = getFunction<float>  (activeInstructionSet);
+    detail::ProcessFunction<double> activeDoubleFunction = getFunction<double> (activeInstructionSet);
+    detail::BandFunction<float>     activeFloatBands     = getBandFunction<float>  (activeInstructionSet);
+    detail::BandFunction<double>    activeDoubleBands    = getBandFunction<double> (activeInstructionSet);
+    bool variantsEnabled = true;
+
+    int getFeatures (const DistortionParameters& start, const DistortionParameters& end, Accuracy accuracy) noexcept
+    {
+        using namespace detail;
+
+        if (! variantsEnabled)
+            return (accuracy == Accuracy::exact ? useExactTanh : 0) | useClamp | useDry | useOutputGain | anyChannelCount;
+
+        return detail::getFeatures (start, end, accuracy);
+    }
+}
+
+//==============================================================================
+void process (float* const* channels, int numChannels, int numSamples,
+              const DistortionParameters& start, const DistortionParameters& end,
+              Accuracy accuracy) noexcept
+{
+    activeFloatFunction (channels, numChannels, numSamples, start, end, getFeatures (start, end, accuracy));
+}
+
+void process (double* const* channels, int numChannels, int numSamples,
+              const DistortionParameters& start, const DistortionParameters& end,
+              Accuracy accuracy) noexcept
+{
+    activeDoubleFunction (channels, numChannels, numSamples, start, end, getFeatures (start, end, accuracy));
+}
+
+void processBands (const float* frames, float* output, int numFrames,
+                   const DistortionParameters* bands, Accuracy accuracy) noexcept
+{
+    activeFloatBands (frames, output, numFrames, bands, accuracy == Accuracy::exact);
+}
+
+void processBands (const double* frames, double* output, int numFrames,
+                   const DistortionParameters* bands, Accuracy accuracy) noexcept
+{
+    activeDoubleBands (frames, output, numFrames, bands, accuracy == Accuracy::exact);
+}
+
+void setVariantsEnabled (bool shouldBeEnabled) noexcept
+{
+    variantsEnabled = shouldBeEnabled;
+}
+
+InstructionSet getInstructionSet() noexcept
+{
+    return activeInstructionSet;
+}
+
+bool setInstructionSet (InstructionSet set) noexcept
+{
+    if (! isSupported (set))
+        return false;
+
+    activeInstructionSet = set;
+    activeFloatFunction  = getFunction<float>  (set);
+    activeDoubleFunction = getFunction<double> (set);
+    activeFloatBands     = getBandFunction<float>  (set);
+    activeDoubleBands    = getBandFunction<double> (set);
+    return true;
+}
+
+bool isSupported (InstructionSet set) noexcept
+{
+    switch (set)
+    {
+        case InstructionSet::scalar:    return true;
+       #if HYPERBOLIC_KERNEL_SSE2
+        case InstructionSet::sse2:      return CpuFeatures::get().sse2;
+       #endif
+       #if HYPERBOLIC_KERNEL_X86
+        case InstructionSet::avx2:      return CpuFeatures::get().avx2 && CpuFeatures::get().fma3;
+        case InstructionSet::avx512:    return CpuFeatures::get().avx512f;
+       #endif
+       #if HYPERBOLIC_KERNEL_NEON
+        case InstructionSet::neon:      return true;
+       #endif
+        default:                        break;
+    }
+
+    return false;
+}
+
+const char* getName (InstructionSet set) noexcept
+{
+    switch (set)
+    {
+        case InstructionSet::scalar:    return "scalar";
+        case InstructionSet::sse2:      return "SSE2";
+        case InstructionSet::avx2:      return "AVX2";
+        case InstructionSet::avx512:    return "AVX-512";
+        case InstructionSet::neon:      return "NEON";
+        default:                        break;
+    }
+
+    return "unknown";
+}
+
+} // namespace WaveshaperKernel
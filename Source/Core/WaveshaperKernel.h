@@ -0,0 +1,162 @@
+/*
+  ==============================================================================
+
+    WaveshaperKernel.h
+
+    The drive -> tanh -> threshold clamp -> dry/wet mix -> output level chain,
+    processed a whole SIMD vector at a time. The best instruction set the CPU
+    supports is picked once when the plugin is loaded.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "DistortionParameters.h"
+
+#if defined (__x86_64__) || defined (_M_X64) || defined (__i386__) || defined (_M_IX86)
+ #define HYPERBOLIC_KERNEL_X86 1
+#else
+ #define HYPERBOLIC_KERNEL_X86 0
+#endif
+
+#if defined (__aarch64__) || defined (_M_ARM64)
+ #define HYPERBOLIC_KERNEL_NEON 1
+#else
+ #define HYPERBOLIC_KERNEL_NEON 0
+#endif
+
+#if defined (__SSE2__) || defined (_M_X64) || (defined (_M_IX86_FP) && _M_IX86_FP >= 2)
+ #define HYPERBOLIC_KERNEL_SSE2 1
+#else
+ #define HYPERBOLIC_KERNEL_SSE2 0
+#endif
+
+namespace WaveshaperKernel
+{
+    /** How the tanh is evaluated.
+
+        exact - std::tanh for every sample. Everything else is still vectorised.
+        fast  - a [7/6] Pade approximant clamped at |x| = 4.9718 (where it reaches 1).
+                The maximum absolute error against std::tanh over the whole real line
+                is 9.6e-5 (about -80 dB), at the clamp point.
+    */
+    enum class Accuracy
+    {
+        exact,
+        fast
+    };
+
+    enum class InstructionSet
+    {
+        scalar,
+        sse2,
+        avx2,
+        avx512,
+        neon
+    };
+
+    /** Distorts numSamples samples of each of the numChannels channels in place.
+
+        If start and end differ, every parameter is ramped linearly so that sample i
+        uses start + (end - start) * (i + 1) / numSamples, which matches what a linear
+        SmoothedValue produces when it is advanced one sample at a time. The ramped
+        values are computed once per vector and shared by all the channels, so it's
+        cheaper to pass a whole block than to call this once per channel.
+
+        The double version is the same kernel instantiated for double vectors (half
+        as many lanes), so a 64-bit host never needs a conversion copy.
+    */
+    void process (float* const* channels, int numChannels, int numSamples,
+                  const DistortionParameters& start, const DistortionParameters& end,
+                  Accuracy accuracy) noexcept;
+
+    void process (double* const* channels, int numChannels, int numSamples,
+                  const DistortionParameters& start, const DistortionParameters& end,
+                  Accuracy accuracy) noexcept;
+
+    /** Single channel convenience versions. */
+    inline void process (float* data, int numSamples,
+                         const DistortionParameters& start, const DistortionParameters& end,
+                         Accuracy accuracy) noexcept
+    {
+        process (&data, 1, numSamples, start, end, accuracy);
+    }
+
+    inline void process (double* data, int numSamples,
+                         const DistortionParameters& start, const DistortionParameters& end,
+                         Accuracy accuracy) noexcept
+    {
+        process (&data, 1, numSamples, start, end, accuracy);
+    }
+
+    /** How many bands processBands() takes per sample, one SIMD lane each. */
+    constexpr int bandLanes = 4;
+
+    /** Distorts a band split signal and sums the bands back together.
+
+        frames holds numFrames * bandLanes samples: sample i of band b is at
+        frames[i * bandLanes + b]. Band b is shaped with bands[b] (an array of
+        bandLanes parameter sets, held constant for the call) and output[i] gets
+        the sum of the shaped bands. Fewer bands just leave the spare lanes at zero,
+        which the curve maps to zero. All the bands of a sample share a vector, so
+        four bands cost about as much as one.
+    */
+    void processBands (const float* frames, float* output, int numFrames,
+                       const DistortionParameters* bands, Accuracy accuracy) noexcept;
+
+    void processBands (const double* frames, double* output, int numFrames,
+                       const DistortionParameters* bands, Accuracy accuracy) noexcept;
+
+    /** Turns the kernel variants on or off. Normally every block runs a variant of
+        process() compiled for just what its parameters need (see detail::Features);
+        switched off, every block takes the variant with everything in, which is only
+        useful as a baseline for the benchmark. Not thread safe, like setInstructionSet().
+    */
+    void setVariantsEnabled (bool shouldBeEnabled) noexcept;
+
+    /** The instruction set process() is currently using. */
+    InstructionSet getInstructionSet() noexcept;
+
+    /** Forces a particular instruction set, e.g. to compare them in a benchmark.
+        Returns false (and changes nothing) if this CPU or build doesn't support it.
+        Not thread safe - only call this while no audio is being processed.
+    */
+    bool setInstructionSet (InstructionSet) noexcept;
+
+    /** Returns true if the given instruction set can be used on this machine. */
+    bool isSupported (InstructionSet) noexcept;
+
+    const char* getName (InstructionSet) noexcept;
+
+    namespace detail
+    {
+        /** What a block needs from the kernel, worked out from its parameters once per
+            block. process() is compiled for every combination, so the inner loops have
+            no branches, and no arithmetic, for the features a block leaves out.
+        */
+        enum Features
+        {
+            useExactTanh  = 1,      // std::tanh rather than the Pade approximant
+            useClamp      = 2,      // the threshold is below 1, so the clamp can cut in
+            useDry        = 4,      // some of the dry signal is mixed in
+            useOutputGain = 8,      // the output level isn't unity
+
+            anyChannelCount = 16    // not a variant: skips the mono and stereo versions
+        };
+
+        constexpr int numVariants = 16;
+
+        /** Without the clamp the fast curve can end up a rounding error (2.4e-7) above 1
+            at the very top of its range, well inside its stated accuracy.
+        */
+        inline int getFeatures (const DistortionParameters& start, const DistortionParameters& end,
+                                Accuracy accuracy) noexcept
+        {
+            return (accuracy == Accuracy::exact ? useExactTanh : 0)
+                 | (start.threshold < 1.0f || end.threshold < 1.0f ? useClamp : 0)
+                 | (start.dry != 0.0f || end.dry != 0.0f ? useDry : 0)
+                 | (start.outputLvl != 1.0f || end.outputLvl != 1.0f ? useOutputGain : 0);
+        }
+    }
+}
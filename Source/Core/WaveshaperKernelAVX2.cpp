@@ -0,0 +1,113 @@
+/*
+  ==============================================================================
+
+    WaveshaperKernelAVX2.cpp
+
+    The AVX2 (8 floats or 4 doubles per vector) variant of the waveshaper kernel. Only this
+    file is compiled for the extended instruction set, and it is only ever
+    called after WaveshaperKernel.cpp has checked that the CPU supports it.
+
+  ==============================================================================
+*/
+
+#include "WaveshaperKernel.h"
+
+#if HYPERBOLIC_KERNEL_X86
+
+// Standard headers must be included before the target switch, so that none of
+// their inline functions get compiled for AVX2 and then shared with other files.
+#include <array>
+#include <cmath>
+#include <immintrin.h>
+#include <utility>
+
+#if defined (__clang__)
+ #pragma clang attribute push (__attribute__ ((target ("avx2,fma"))), apply_to = function)
+#elif defined (__GNUC__)
+ #pragma GCC push_options
+ #pragma GCC target ("avx2,fma")
+#endif
+
+#include "WaveshaperKernelImpl.h"
+
+namespace
+{
+
+template <typename SampleType> struct AVX2Vector;
+
+template <>
+struct AVX2Vector<float>
+{
+    using Sample = float;
+    using Type = __m256;
+    static constexpr int width = 8;
+
+    static Type load (const Sample* p) noexcept         { return _mm256_loadu_ps (p); }
+    static void store (Sample* p, Type v) noexcept      { _mm256_storeu_ps (p, v); }
+    static Type set (Sample v) noexcept                 { return _mm256_set1_ps (v); }
+    static Type lanes() noexcept                        { return _mm256_setr_ps (0.0f, 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f); }
+    static Type add (Type a, Type b) noexcept           { return _mm256_add_ps (a, b); }
+    static Type sub (Type a, Type b) noexcept           { return _mm256_sub_ps (a, b); }
+    static Type mul (Type a, Type b) noexcept           { return _mm256_mul_ps (a, b); }
+    static Type div (Type a, Type b) noexcept           { return _mm256_div_ps (a, b); }
+    static Type min (Type a, Type b) noexcept           { return _mm256_min_ps (a, b); }
+    static Type max (Type a, Type b) noexcept           { return _mm256_max_ps (a, b); }
+};
+
+template <>
+struct AVX2Vector<double>
+{
+    using Sample = double;
+    using Type = __m256d;
+    static constexpr int width = 4;
+
+    static Type load (const Sample* p) noexcept         { return _mm256_loadu_pd (p); }
+    static void store (Sample* p, Type v) noexcept      { _mm256_storeu_pd (p, v); }
+    static Type set (Sample v) noexcept                 { return _mm256_set1_pd (v); }
+    static Type lanes() noexcept                        { return _mm256_setr_pd (0.0, 1.0, 2.0, 3.0); }
+    static Type add (Type a, Type b) noexcept           { return _mm256_add_pd (a, b); }
+    static Type sub (Type a, Type b) noexcept           { return _mm256_sub_pd (a, b); }
+    static Type mul (Type a, Type b) noexcept           { return _mm256_mul_pd (a, b); }
+    static Type div (Type a, Type b) noexcept           { return _mm256_div_pd (a, b); }
+    static Type min (Type a, Type b) noexcept           { return _mm256_min_pd (a, b); }
+    static Type max (Type a, Type b) noexcept           { return _mm256_max_pd (a, b); }
+};
+
+} // namespace
+
+namespace WaveshaperKernel::detail
+{
+    void processAVX2 (float* const* channels, int numChannels, int numSamples,
+                      const DistortionParameters& start, const DistortionParameters& end,
+                      int features) noexcept
+    {
+        WaveshaperImpl<AVX2Vector<float>>::process (channels, numChannels, numSamples, start, end, features);
+    }
+
+    void processAVX2 (double* const* channels, int numChannels, int numSamples,
+                      const DistortionParameters& start, const DistortionParameters& end,
+                      int features) noexcept
+    {
+        WaveshaperImpl<AVX2Vector<double>>::process (channels, numChannels, numSamples, start, end, features);
+    }
+
+    void processBandsAVX2 (const float* frames, float* output, int numFrames,
+                           const DistortionParameters* bands, bool exact) noexcept
+    {
+        WaveshaperImpl<AVX2Vector<float>>::processBands (frames, output, numFrames, bands, exact);
+    }
+
+    void processBandsAVX2 (const double* frames, double* output, int numFrames,
+                           const DistortionParameters* bands, bool exact) noexcept
+    {
+        WaveshaperImpl<AVX2Vector<double>>::processBands (frames, output, numFrames, bands, exact);
+    }
+}
+
+#if defined (__clang__)
+ #pragma clang attribute pop
+#elif defined (__GNUC__)
+ #pragma GCC pop_options
+#endif
+
+#endif
@@ -0,0 +1,113 @@
+/*
+  ==============================================================================
+
+    WaveshaperKernelAVX512.cpp
+
+    The AVX-512F (16 floats or 8 doubles per vector) variant of the waveshaper kernel. Only this
+    file is compiled for the extended instruction set, and it is only ever
+    called after WaveshaperKernel.cpp has checked that the CPU supports it.
+
+  ==============================================================================
+*/
+
+#include "WaveshaperKernel.h"
+
+#if HYPERBOLIC_KERNEL_X86
+
+// Standard headers must be included before the target switch, so that none of
+// their inline functions get compiled for AVX512 and then shared with other files.
+#include <array>
+#include <cmath>
+#include <immintrin.h>
+#include <utility>
+
+#if defined (__clang__)
+ #pragma clang attribute push (__attribute__ ((target ("avx512f"))), apply_to = function)
+#elif defined (__GNUC__)
+ #pragma GCC push_options
+ #pragma GCC target ("avx512f")
+#endif
+
+#include "WaveshaperKernelImpl.h"
+
+namespace
+{
+
+template <typename SampleType> struct AVX512Vector;
+
+template <>
+struct AVX512Vector<float>
+{
+    using Sample = float;
+    using Type = __m512;
+    static constexpr int width = 16;
+
+    static Type load (const Sample* p) noexcept         { return _mm512_loadu_ps (p); }
+    static void store (Sample* p, Type v) noexcept      { _mm512_storeu_ps (p, v); }
+    static Type set (Sample v) noexcept                 { return _mm512_set1_ps (v); }
+    static Type lanes() noexcept                        { return _mm512_set_ps (15.0f, 14.0f, 13.0f, 12.0f, 11.0f, 10.0f, 9.0f, 8.0f, 7.0f, 6.0f, 5.0f, 4.0f, 3.0f, 2.0f, 1.0f, 0.0f); }
+    static Type add (Type a, Type b) noexcept           { return _mm512_add_ps (a, b); }
+    static Type sub (Type a, Type b) noexcept           { return _mm512_sub_ps (a, b); }
+    static Type mul (Type a, Type b) noexcept           { return _mm512_mul_ps (a, b); }
+    static Type div (Type a, Type b) noexcept           { return _mm512_div_ps (a, b); }
+    static Type min (Type a, Type b) noexcept           { return _mm512_min_ps (a, b); }
+    static Type max (Type a, Type b) noexcept           { return _mm512_max_ps (a, b); }
+};
+
+template <>
+struct AVX512Vector<double>
+{
+    using Sample = double;
+    using Type = __m512d;
+    static constexpr int width = 8;
+
+    static Type load (const Sample* p) noexcept         { return _mm512_loadu_pd (p); }
+    static void store (Sample* p, Type v) noexcept      { _mm512_storeu_pd (p, v); }
+    static Type set (Sample v) noexcept                 { return _mm512_set1_pd (v); }
+    static Type lanes() noexcept                        { return _mm512_set_pd (7.0, 6.0, 5.0, 4.0, 3.0, 2.0, 1.0, 0.0); }
+    static Type add (Type a, Type b) noexcept           { return _mm512_add_pd (a, b); }
+    static Type sub (Type a, Type b) noexcept           { return _mm512_sub_pd (a, b); }
+    static Type mul (Type a, Type b) noexcept           { return _mm512_mul_pd (a, b); }
+    static Type div (Type a, Type b) noexcept           { return _mm512_div_pd (a, b); }
+    static Type min (Type a, Type b) noexcept           { return _mm512_min_pd (a, b); }
+    static Type max (Type a, Type b) noexcept           { return _mm512_max_pd (a, b); }
+};
+
+} // namespace
+
+namespace WaveshaperKernel::detail
+{
+    void processAVX512 (float* const* channels, int numChannels, int numSamples,
+                        const DistortionParameters& start, const DistortionParameters& end,
+                        int features) noexcept
+    {
+        WaveshaperImpl<AVX512Vector<float>>::process (channels, numChannels, numSamples, start, end, features);
+    }
+
+    void processAVX512 (double* const* channels, int numChannels, int numSamples,
+                        const DistortionParameters& start, const DistortionParameters& end,
+                        int features) noexcept
+    {
+        WaveshaperImpl<AVX512Vector<double>>::process (channels, numChannels, numSamples, start, end, features);
+    }
+
+    void processBandsAVX512 (const float* frames, float* output, int numFrames,
+                             const DistortionParameters* bands, bool exact) noexcept
+    {
+        WaveshaperImpl<AVX512Vector<float>>::processBands (frames, output, numFrames, bands, exact);
+    }
+
+    void processBandsAVX512 (const double* frames, double* output, int numFrames,
+                             const DistortionParameters* bands, bool exact) noexcept
+    {
+        WaveshaperImpl<AVX512Vector<double>>::processBands (frames, output, numFrames, bands, exact);
+    }
+}
+
+#if defined (__clang__)
+ #pragma clang attribute pop
+#elif defined (__GNUC__)
+ #pragma GCC pop_options
+#endif
+
+#endif
@@ -0,0 +1,354 @@
+/*
+  ==============================================================================
+
+    WaveshaperKernelImpl.h
+
+    The body of the waveshaper kernel, written once against a tiny vector
+    interface and instantiated by each instruction-set translation unit.
+
+    Everything in here lives in an anonymous namespace on purpose: each .cpp
+    that includes it is compiled for a different target, so none of these
+    functions may be shared between translation units by the linker.
+
+    A vector type V has to provide:
+        Sample (float or double), Type, width,
+        load, store, set, lanes (0, 1, 2 ...), add, sub, mul, div, min, max
+
+    process() is compiled once for every combination of the features in
+    WaveshaperKernel::detail::Features, and the ramped version also for one
+    and two channels, and picks one from a table of all of them per call.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "DistortionParameters.h"
+#include "WaveshaperKernel.h"
+#include <array>
+#include <cmath>
+#include <utility>
+
+namespace
+{
+
+//==============================================================================
+template <typename SampleType>
+struct ScalarVector
+{
+    using Sample = SampleType;
+    using Type = SampleType;
+    static constexpr int width = 1;
+
+    static Type load (const Sample* p) noexcept         { return *p; }
+    static void store (Sample* p, Type v) noexcept      { *p = v; }
+    static Type set (Sample v) noexcept                 { return v; }
+    static Type lanes() noexcept                        { return 0; }
+    static Type add (Type a, Type b) noexcept           { return a + b; }
+    static Type sub (Type a, Type b) noexcept           { return a - b; }
+    static Type mul (Type a, Type b) noexcept           { return a * b; }
+    static Type div (Type a, Type b) noexcept           { return a / b; }
+    static Type min (Type a, Type b) noexcept           { return a < b ? a : b; }
+    static Type max (Type a, Type b) noexcept           { return a > b ? a : b; }
+};
+
+//==============================================================================
+template <typename V>
+struct WaveshaperImpl
+{
+    using Sample = typename V::Sample;
+    using Vec = typename V::Type;
+
+    static constexpr int useExactTanh  = WaveshaperKernel::detail::useExactTanh;
+    static constexpr int useClamp      = WaveshaperKernel::detail::useClamp;
+    static constexpr int useDry        = WaveshaperKernel::detail::useDry;
+    static constexpr int useOutputGain = WaveshaperKernel::detail::useOutputGain;
+    static constexpr int allFeatures   = useClamp | useDry | useOutputGain;
+
+    /** The Pade approximant of tanh, tanh(x) ~ x (135135 + 17325x^2 + 378x^4 + x^6)
+        / (135135 + 62370x^2 + 3150x^4 + 28x^6). It rises monotonically to exactly 1
+        at |x| = 4.9718, so clamping the input there keeps it bounded and continuous.
+    */
+    static Vec fastTanh (Vec x) noexcept
+    {
+        const auto limit = V::set ((Sample) 4.97178686);
+        x = V::min (V::max (x, V::sub (V::set (0), limit)), limit);
+
+        auto x2  = V::mul (x, x);
+        auto num = V::mul (x, V::add (V::set (135135),
+                              V::mul (x2, V::add (V::set (17325),
+                                          V::mul (x2, V::add (V::set (378), x2))))));
+        auto den = V::add (V::set (135135),
+                           V::mul (x2, V::add (V::set (62370),
+                                       V::mul (x2, V::add (V::set (3150),
+                                                   V::mul (x2, V::set (28)))))));
+        return V::div (num, den);
+    }
+
+    static Vec exactTanh (Vec x) noexcept
+    {
+        alignas (64) Sample lanes[V::width];
+        V::store (lanes, x);
+
+        for (auto& lane : lanes)
+            lane = std::tanh (lane);
+
+        return V::load (lanes);
+    }
+
+    /** ceiling is min (threshold, 1): tanh never goes past 1 anyway, so a single
+        clamp covers both the asymptote of the fast approximation and the threshold.
+        Whatever features leaves out isn't computed at all, and its arguments are ignored.
+    */
+    template <int features>
+    static Vec shape (Vec x, Vec drive, Vec ceiling, Vec wet, Vec dry, Vec outputLvl) noexcept
+    {
+        // Here, I have used the hyperbolic tan function to distort the signal, as it has
+        // horizontal asymptotes at y = -1 & y = 1. The variable drive therefore adjusts
+        // the intensity (or harshness) of the wave
+        auto driven    = V::mul (x, drive);
+        auto distorted = (features & useExactTanh) != 0 ? exactTanh (driven) : fastTanh (driven);
+
+        if constexpr ((features & useClamp) != 0)
+            distorted = V::min (V::max (distorted, V::sub (V::set (0), ceiling)), ceiling);
+
+        auto mixed = V::mul (wet, distorted);
+
+        if constexpr ((features & useDry) != 0)
+            mixed = V::add (V::mul (dry, x), mixed);
+
+        if constexpr ((features & useOutputGain) != 0)
+            mixed = V::mul (mixed, outputLvl);
+
+        return mixed;
+    }
+
+    template <int features>
+    static void processConstant (Sample* const* channels, int numChannels, int numSamples,
+                                 const DistortionParameters& p) noexcept
+    {
+        using Scalar = WaveshaperImpl<ScalarVector<Sample>>;
+
+        const auto drive     = V::set (p.drive);
+        const auto ceiling   = V::set (p.threshold < 1.0f ? p.threshold : 1.0f);
+        const auto wet       = V::set (p.wet);
+        const auto dry       = V::set (p.dry);
+        const auto outputLvl = V::set (p.outputLvl);
+
+        // With nothing moving each channel is just a contiguous run, so go through
+        // them one after the other and let the prefetcher do its job.
+        for (int channel = 0; channel < numChannels; ++channel)
+        {
+            auto* data = channels[channel];
+            int i = 0;
+
+            for (; i + V::width <= numSamples; i += V::width)
+                V::store (data + i, shape<features> (V::load (data + i), drive, ceiling, wet, dry, outputLvl));
+
+            for (; i < numSamples; ++i)
+                data[i] = Scalar::template shape<features> (data[i], p.drive, (Sample) (p.threshold < 1.0f ? p.threshold : 1.0f),
+                                                            p.wet, p.dry, p.outputLvl);
+        }
+    }
+
+    /** Only the position within the ramp decides the parameter values, so they are
+        worked out once per vector of samples and then reused for every channel.
+        That keeps the ramp cost independent of the channel count. fixedChannels is
+        1 or 2 for the mono and stereo variants, whose channel loops unroll, and 0
+        for any other count.
+    */
+    template <int features, int fixedChannels>
+    static void processRamped (Sample* const* channels, int numChannels, int numSamples,
+                               const DistortionParameters& start, const DistortionParameters& end) noexcept
+    {
+        using Scalar = WaveshaperImpl<ScalarVector<Sample>>;
+
+        if constexpr (fixedChannels > 0)
+            numChannels = fixedChannels;
+
+        const auto step = (Sample) 1 / (Sample) numSamples;
+        const auto laneOffsets = V::lanes();
+
+        const auto drive0  = V::set (start.drive),     driveDelta  = V::set ((Sample) end.drive - (Sample) start.drive);
+        const auto thresh0 = V::set (start.threshold), threshDelta = V::set ((Sample) end.threshold - (Sample) start.threshold);
+        const auto wet0    = V::set (start.wet),       wetDelta    = V::set ((Sample) end.wet - (Sample) start.wet);
+        const auto dry0    = V::set (start.dry),       dryDelta    = V::set ((Sample) end.dry - (Sample) start.dry);
+        const auto out0    = V::set (start.outputLvl), outDelta    = V::set ((Sample) end.outputLvl - (Sample) start.outputLvl);
+        const auto one = V::set (1);
+
+        int i = 0;
+
+        for (; i + V::width <= numSamples; i += V::width)
+        {
+            auto alpha = V::mul (V::add (V::set ((Sample) (i + 1)), laneOffsets), V::set (step));
+
+            auto drive = V::add (drive0, V::mul (driveDelta, alpha));
+            auto wet   = V::add (wet0, V::mul (wetDelta, alpha));
+            Vec ceiling = one, dry = one, out = one;
+
+            if constexpr ((features & useClamp) != 0)
+                ceiling = V::min (V::add (thresh0, V::mul (threshDelta, alpha)), one);
+
+            if constexpr ((features & useDry) != 0)
+                dry = V::add (dry0, V::mul (dryDelta, alpha));
+
+            if constexpr ((features & useOutputGain) != 0)
+                out = V::add (out0, V::mul (outDelta, alpha));
+
+            for (int channel = 0; channel < numChannels; ++channel)
+            {
+                auto* data = channels[channel] + i;
+                V::store (data, shape<features> (V::load (data), drive, ceiling, wet, dry, out));
+            }
+        }
+
+        for (; i < numSamples; ++i)
+        {
+            auto alpha = (Sample) (i + 1) * step;
+
+            auto drive   = (Sample) start.drive     + alpha * ((Sample) end.drive     - (Sample) start.drive);
+            auto ceiling = (Sample) start.threshold + alpha * ((Sample) end.threshold - (Sample) start.threshold);
+            auto wet     = (Sample) start.wet       + alpha * ((Sample) end.wet       - (Sample) start.wet);
+            auto dry     = (Sample) start.dry       + alpha * ((Sample) end.dry       - (Sample) start.dry);
+            auto out     = (Sample) start.outputLvl + alpha * ((Sample) end.outputLvl - (Sample) start.outputLvl);
+            ceiling = ceiling < (Sample) 1 ? ceiling : (Sample) 1;
+
+            for (int channel = 0; channel < numChannels; ++channel)
+                channels[channel][i] = Scalar::template shape<features> (channels[channel][i], drive, ceiling, wet, dry, out);
+        }
+    }
+
+    /** Frames of bandLanes interleaved samples, one per band. Every vector position
+        within a span of frames always holds the same bands, so each lane gets its
+        band's parameters from a vector built once up front - the bands are shaped
+        side by side instead of one after the other.
+    */
+    template <int features>
+    static void processBandsImpl (const Sample* frames, Sample* output, int numFrames,
+                                  const DistortionParameters* bands) noexcept
+    {
+        using Scalar = WaveshaperImpl<ScalarVector<Sample>>;
+
+        constexpr int bandLanes = WaveshaperKernel::bandLanes;
+        constexpr int span = V::width > bandLanes ? V::width : bandLanes;
+        constexpr int vectorsPerSpan = span / V::width;
+        constexpr int framesPerSpan = span / bandLanes;
+
+        static_assert (bandLanes == 4, "The sums below add up four bands");
+        static_assert (span % V::width == 0 && span % bandLanes == 0, "Vector width and band count don't line up");
+
+        Vec drive[vectorsPerSpan], ceiling[vectorsPerSpan], wet[vectorsPerSpan], dry[vectorsPerSpan], out[vectorsPerSpan];
+
+        for (int v = 0; v < vectorsPerSpan; ++v)
+        {
+            alignas (64) Sample lanes[5][V::width];
+
+            for (int j = 0; j < V::width; ++j)
+            {
+                auto& band = bands[(v * V::width + j) % bandLanes];
+                lanes[0][j] = band.drive;
+                lanes[1][j] = band.threshold < 1.0f ? band.threshold : 1.0f;
+                lanes[2][j] = band.wet;
+                lanes[3][j] = band.dry;
+                lanes[4][j] = band.outputLvl;
+            }
+
+            drive[v]   = V::load (lanes[0]);
+            ceiling[v] = V::load (lanes[1]);
+            wet[v]     = V::load (lanes[2]);
+            dry[v]     = V::load (lanes[3]);
+            out[v]     = V::load (lanes[4]);
+        }
+
+        int frame = 0;
+
+        for (; frame + framesPerSpan <= numFrames; frame += framesPerSpan)
+        {
+            alignas (64) Sample shaped[span];
+            auto* input = frames + frame * bandLanes;
+
+            for (int v = 0; v < vectorsPerSpan; ++v)
+                V::store (shaped + v * V::width,
+                          shape<features> (V::load (input + v * V::width), drive[v], ceiling[v], wet[v], dry[v], out[v]));
+
+            for (int f = 0; f < framesPerSpan; ++f)
+            {
+                auto* bandsOut = shaped + f * bandLanes;
+                output[frame + f] = (bandsOut[0] + bandsOut[1]) + (bandsOut[2] + bandsOut[3]);
+            }
+        }
+
+        for (; frame < numFrames; ++frame)
+        {
+            Sample shaped[bandLanes];
+
+            for (int b = 0; b < bandLanes; ++b)
+            {
+                auto& band = bands[b];
+                shaped[b] = Scalar::template shape<features> (frames[frame * bandLanes + b], band.drive,
+                                                              (Sample) (band.threshold < 1.0f ? band.threshold : 1.0f),
+                                                              band.wet, band.dry, band.outputLvl);
+            }
+
+            output[frame] = (shaped[0] + shaped[1]) + (shaped[2] + shaped[3]);
+        }
+    }
+
+    static void processBands (const Sample* frames, Sample* output, int numFrames,
+                              const DistortionParameters* bands, bool exact) noexcept
+    {
+        if (numFrames <= 0)
+            return;
+
+        // The bands each have their own settings, so every feature stays in
+        if (exact)  processBandsImpl<useExactTanh | allFeatures> (frames, output, numFrames, bands);
+        else        processBandsImpl<allFeatures>                (frames, output, numFrames, bands);
+    }
+
+    //==============================================================================
+    using ConstantFunction = void (*) (Sample* const*, int, int, const DistortionParameters&) noexcept;
+    using RampedFunction   = void (*) (Sample* const*, int, int, const DistortionParameters&, const DistortionParameters&) noexcept;
+
+    static constexpr int numVariants = WaveshaperKernel::detail::numVariants;
+    static constexpr int numLayouts = 3;    // any channel count, mono, stereo
+
+    template <int... variants>
+    static constexpr std::array<ConstantFunction, sizeof... (variants)> makeConstantTable (std::integer_sequence<int, variants...>) noexcept
+    {
+        return {{ &processConstant<variants>... }};
+    }
+
+    // Entry features * numLayouts + channels, where channels is 0 for any count
+    template <int... variants>
+    static constexpr std::array<RampedFunction, sizeof... (variants)> makeRampedTable (std::integer_sequence<int, variants...>) noexcept
+    {
+        return {{ &processRamped<variants / numLayouts, variants % numLayouts>... }};
+    }
+
+    /** features is a combination of WaveshaperKernel::detail::Features, worked out
+        from the block's parameters by the caller.
+    */
+    static void process (Sample* const* channels, int numChannels, int numSamples,
+                         const DistortionParameters& start, const DistortionParameters& end,
+                         int features) noexcept
+    {
+        static constexpr auto constantVariants = makeConstantTable (std::make_integer_sequence<int, numVariants>());
+        static constexpr auto rampedVariants   = makeRampedTable (std::make_integer_sequence<int, numVariants * numLayouts>());
+
+        if (numSamples <= 0 || numChannels <= 0)
+            return;
+
+        auto variant = features & (numVariants - 1);
+
+        if (start == end)
+        {
+            constantVariants[(size_t) variant] (channels, numChannels, numSamples, start);
+            return;
+        }
+
+        auto layout = (features & WaveshaperKernel::detail::anyChannelCount) == 0 && numChannels < numLayouts ? numChannels : 0;
+        rampedVariants[(size_t) (variant * numLayouts + layout)] (channels, numChannels, numSamples, start, end);
+    }
+};
+
+} // namespace
@@ -0,0 +1,47 @@
+/*
+  ==============================================================================
+
+    EditorAssets.cpp
+
+  ==============================================================================
+*/
+
+#include "EditorAssets.h"
+
+//==============================================================================
+EditorAssets::EditorAssets()
+{
+    // Resolving the typeface here means every label and every background render
+    // after this reuses it instead of searching the system fonts again.
+    Font font (FontOptions ("Chalkduster", 16.0f, Font::plain));
+    chalkDuster = FontOptions (font.getTypefacePtr());
+}
+
+FontOptions EditorAssets::getFont (float height) const
+{
+    return chalkDuster.withHeight (height);
+}
+
+Image EditorAssets::getBackground (int width, int height, float scale,
+                                   const std::function<void (Graphics&)>& paintBackground)
+{
+    for (auto& cached : backgrounds)
+        if (cached.width == width && cached.height == height && cached.scale == scale)
+            return cached.image;
+
+    // Rendered at the display's pixel density so it stays sharp on high DPI screens
+    Image image (Image::RGB, jmax (1, roundToInt ((float) width * scale)),
+                             jmax (1, roundToInt ((float) height * scale)), true);
+    {
+        Graphics g (image);
+        g.addTransform (AffineTransform::scale (scale));
+        paintBackground (g);
+    }
+
+    // Only a couple of sizes ever show up (one per screen scale), so this stays tiny
+    if (backgrounds.size() >= 4)
+        backgrounds.erase (backgrounds.begin());
+
+    backgrounds.push_back ({ width, height, scale, image });
+    return image;
+}
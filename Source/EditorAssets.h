@@ -0,0 +1,71 @@
+/*
+  ==============================================================================
+
+    EditorAssets.h
+
+    The parts of the editor that are the same for every plugin instance: the
+    look and feel, the font, and the pre-rendered background. They're created
+    when the first editor opens, shared through a SharedResourcePointer by all
+    the editors that are open at the same time, and freed when the last one
+    closes. Message thread only.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+using namespace juce;
+
+//==============================================================================
+class GreenTheme : public LookAndFeel_V4
+{
+    public:
+    GreenTheme()
+    {
+        setColour(Slider::rotarySliderOutlineColourId, Colour(213, 245, 223));
+        setColour(Slider::thumbColourId, Colour(60, 81, 72));
+        setColour(Slider::rotarySliderFillColourId, Colour(107, 142, 78));
+        setColour(Slider::backgroundColourId, Colour(178, 197, 178));
+        setColour(Slider::trackColourId, Colour(107, 142, 78));
+        setColour(Slider::textBoxOutlineColourId, Colours::transparentBlack);
+        
+    }
+    
+};
+
+//==============================================================================
+class EditorAssets
+{
+public:
+    EditorAssets();
+
+    GreenTheme& getTheme() noexcept     { return greenTheme; }
+
+    /** Chalkduster at the given height. The typeface is looked up once, by name, from
+        the fonts installed on the system; where it isn't available (anything but
+        macOS) this falls back to the default sans-serif.
+    */
+    FontOptions getFont (float height) const;
+
+    /** Returns the background for an editor of the given size at the given display
+        scale, calling paintBackground to render it only if no editor has asked for
+        that size and scale before.
+    */
+    Image getBackground (int width, int height, float scale,
+                         const std::function<void (Graphics&)>& paintBackground);
+
+private:
+    struct CachedBackground
+    {
+        int width = 0, height = 0;
+        float scale = 1.0f;
+        Image image;
+    };
+
+    GreenTheme greenTheme;
+    FontOptions chalkDuster;
+    std::vector<CachedBackground> backgrounds;
+
+    JUCE_DECLARE_NON_COPYABLE (EditorAssets)
+};
@@ -0,0 +1,267 @@
+/*
+  ==============================================================================
+
+    LimiterStage.cpp
+
+  ==============================================================================
+*/
+
+#include "LimiterStage.h"
+
+//==============================================================================
+LimiterStage::LimiterStage()
+{
+    // Windowed sinc at a quarter, half and three quarters of the way from the
+    // sample numTaps / 2 back to the next one, each phase normalised to unity gain
+    for (int phase = 1; phase < numPhases; ++phase)
+    {
+        auto* taps = coefficients[phase - 1];
+        double sum = 0.0;
+
+        for (int tap = 0; tap < numTaps; ++tap)
+        {
+            auto distance = (double) (tap - (numTaps - 1 - detectorDelay)) - (double) phase / numPhases;
+            auto x = MathConstants<double>::pi * distance;
+            auto window = 0.5 + 0.5 * std::cos (x / detectorDelay);
+            auto value = std::sin (x) / x * window;
+
+            taps[tap] = (float) value;
+            sum += value;
+        }
+
+        for (int tap = 0; tap < numTaps; ++tap)
+            taps[tap] = (float) (taps[tap] / sum);
+    }
+}
+
+void LimiterStage::prepare (double sampleRate, int newNumChannels, int newMaxBlockSize)
+{
+    numChannels = jlimit (1, maxChannels, newNumChannels);
+    maxBlockSize = jmax (1, newMaxBlockSize);
+
+    lookahead = jmax (1, roundToInt (lookaheadSeconds * sampleRate));
+    latency = detectorDelay + lookahead - 1;
+    releaseCoefficient = (float) (1.0 - std::exp (-1.0 / (releaseSeconds * sampleRate)));
+
+    // Held for one sample longer than the lookahead, so the gain covers the sample
+    // after a peak as well, which the peak between the two depends on
+    windowMask = nextPowerOfTwo (lookahead + 2) - 1;
+
+    // Whatever the last prepare handed out is the wrong size now
+    AudioArena nothing;
+    takeWorkingMemory (nothing);
+}
+
+void LimiterStage::takeWorkingMemory (AudioArena& arena) noexcept
+{
+    for (int channel = 0; channel < maxChannels; ++channel)
+    {
+        delay[channel] = channel < numChannels ? arena.allocate<double> ((size_t) latency) : nullptr;
+        history[channel] = channel < numChannels ? arena.allocate<float> ((size_t) (numTaps - 1 + maxBlockSize)) : nullptr;
+    }
+
+    peaks = arena.allocate<float> ((size_t) maxBlockSize);
+    gains = arena.allocate<float> ((size_t) maxBlockSize);
+    windowPeaks = arena.allocate<float> ((size_t) windowMask + 1);
+    windowTimes = arena.allocate<int64> ((size_t) windowMask + 1);
+    average = arena.allocate<float> ((size_t) lookahead);
+
+    reset();
+}
+
+void LimiterStage::reset() noexcept
+{
+    windowFront = windowSize = 0;
+    time = 0;
+    delayPosition = averagePosition = 0;
+    envelope = 1.0f;
+
+    if (peaks == nullptr)
+        return;
+
+    for (int channel = 0; channel < numChannels; ++channel)
+    {
+        std::fill (delay[channel], delay[channel] + latency, 0.0);
+        FloatVectorOperations::clear (history[channel], numTaps - 1);
+    }
+
+    FloatVectorOperations::fill (average, 1.0f, lookahead);
+}
+
+bool LimiterStage::setEnabled (bool shouldBeEnabled) noexcept
+{
+    if (shouldBeEnabled == enabled)
+        return false;
+
+    enabled = shouldBeEnabled;
+
+    if (enabled)
+    {
+        // The delay is empty, so the signal would come back in with a step: the gain
+        // starts at zero instead and rises with the release
+        reset();
+        envelope = 0.0f;
+
+        if (average != nullptr)
+            FloatVectorOperations::clear (average, lookahead);
+    }
+
+    return true;
+}
+
+//==============================================================================
+template <typename SampleType>
+void LimiterStage::process (const dsp::AudioBlock<SampleType>& block) noexcept
+{
+    run (block, true);
+}
+
+template <typename SampleType>
+void LimiterStage::processBypassed (const dsp::AudioBlock<SampleType>& block) noexcept
+{
+    run (block, false);
+}
+
+template <typename SampleType>
+void LimiterStage::run (const dsp::AudioBlock<SampleType>& block, bool applyGain) noexcept
+{
+    if (! enabled || peaks == nullptr)
+        return;
+
+    auto numChannelsToRun = jmin ((int) block.getNumChannels(), numChannels);
+    auto numSamples = (int) block.getNumSamples();
+    jassert (numSamples <= maxBlockSize);
+
+    FloatVectorOperations::clear (peaks, numSamples);
+
+    for (int channel = 0; channel < numChannelsToRun; ++channel)
+    {
+        auto* source = block.getChannelPointer ((size_t) channel);
+        auto* dest = history[channel] + numTaps - 1;
+
+        for (int i = 0; i < numSamples; ++i)
+            dest[i] = (float) source[i];
+
+        detectPeaks (channel, numSamples);
+    }
+
+    computeGains (numSamples);
+
+    if (! applyGain)
+        FloatVectorOperations::fill (gains, 1.0f, numSamples);
+
+    for (int channel = 0; channel < numChannelsToRun; ++channel)
+    {
+        auto* data = block.getChannelPointer ((size_t) channel);
+        auto* line = delay[channel];
+        auto position = delayPosition;
+
+        for (int i = 0; i < numSamples; ++i)
+        {
+            auto delayed = line[position];
+            line[position] = (double) data[i];
+            data[i] = (SampleType) (delayed * gains[i]);
+
+            if (++position == latency)
+                position = 0;
+        }
+    }
+
+    delayPosition = (delayPosition + numSamples) % latency;
+}
+
+//==============================================================================
+void LimiterStage::detectPeaks (int channel, int numSamples) noexcept
+{
+    auto* samples = history[channel];
+
+    // The sample detectorDelay back, then the three points after it. Every tap is a
+    // multiply-add over the whole block, so it all runs in SIMD registers, with gains
+    // as the scratch space until computeGains() fills it.
+    FloatVectorOperations::abs (gains, samples + numTaps - 1 - detectorDelay, numSamples);
+    FloatVectorOperations::max (peaks, peaks, gains, numSamples);
+
+    for (auto& taps : coefficients)
+    {
+        FloatVectorOperations::multiply (gains, samples, taps[0], numSamples);
+
+        for (int tap = 1; tap < numTaps; ++tap)
+            FloatVectorOperations::addWithMultiply (gains, samples + tap, taps[tap], numSamples);
+
+        FloatVectorOperations::abs (gains, gains, numSamples);
+        FloatVectorOperations::max (peaks, peaks, gains, numSamples);
+    }
+
+    // The end of this block is the start of the next one's interpolation
+    std::copy (samples + numSamples, samples + numSamples + numTaps - 1, samples);
+}
+
+void LimiterStage::computeGains (int numSamples) noexcept
+{
+    const auto holdLength = (int64) lookahead + 1;
+    const auto averageScale = 1.0 / lookahead;
+
+    // In locals for the loop, otherwise every store to the buffers could have changed
+    // them as far as the compiler knows, and they'd be read back from memory each time
+    auto front = windowFront, size = windowSize, position = averagePosition;
+    auto now = time;
+    auto gain = envelope;
+    auto limit = ceiling, release = releaseCoefficient;
+
+    // Re-added from scratch once per block, so rounding can't pile up in the running sum
+    auto sum = 0.0;
+
+    for (int i = 0; i < lookahead; ++i)
+        sum += average[i];
+
+    for (int i = 0; i < numSamples; ++i)
+    {
+        // Everything below the ceiling needs no gain reduction, so it all goes in as the
+        // ceiling: below it the window then holds a single entry, and the loop is cheap
+        auto peak = jmax (peaks[i], limit);
+
+        // Anything at or below the new peak can never be the highest again
+        while (size > 0 && windowPeaks[(front + size - 1) & windowMask] <= peak)
+            --size;
+
+        auto back = (front + size) & windowMask;
+        windowPeaks[back] = peak;
+        windowTimes[back] = now;
+        ++size;
+
+        // And the front leaves once it's older than the window, one per sample at most
+        if (windowTimes[front] <= now - holdLength)
+        {
+            front = (front + 1) & windowMask;
+            --size;
+        }
+
+        ++now;
+
+        // Down to the target at once (the averaging below is the attack), back up with the release
+        auto target = limit / windowPeaks[front];
+        gain = jmin (target, gain + release * (target - gain));
+
+        // Averaging a gain that's been held for the whole lookahead gets there
+        // exactly when the peak leaves the delay, without a corner on the way
+        sum += gain - average[position];
+        average[position] = gain;
+
+        if (++position == lookahead)
+            position = 0;
+
+        gains[i] = (float) (sum * averageScale);
+    }
+
+    windowFront = front;
+    windowSize = size;
+    averagePosition = position;
+    time = now;
+    envelope = gain;
+}
+
+//==============================================================================
+template void LimiterStage::process (const dsp::AudioBlock<float>&) noexcept;
+template void LimiterStage::process (const dsp::AudioBlock<double>&) noexcept;
+template void LimiterStage::processBypassed (const dsp::AudioBlock<float>&) noexcept;
+template void LimiterStage::processBypassed (const dsp::AudioBlock<double>&) noexcept;
@@ -0,0 +1,120 @@
+/*
+  ==============================================================================
+
+    LimiterStage.h
+
+    An optional lookahead limiter at the very end, so Output Level can push
+    the signal up to +12 dB without a separate limiter behind the plugin.
+
+    It limits true peaks, not just samples: every block is interpolated 4x
+    (a 48 tap windowed sinc, 12 per phase, as in ITU-R BS.1770) and the peak
+    between each pair of samples counts along with the samples themselves,
+    so the output stays below the ceiling after the DAC's reconstruction too.
+
+    The gain follows the highest peak over the lookahead window, taken with
+    a monotonic deque - each peak goes in and out of it at most once, so the
+    window's length costs nothing per sample. The gain needed for that peak
+    is then averaged over the lookahead, which bends it down smoothly and
+    reaches it exactly as the peak comes out of the delay, and it recovers
+    with an exponential release. The gain is the same for every channel, so
+    the image doesn't move.
+
+    The delay is lookaheadSeconds plus half the interpolator, and counts
+    towards the plugin's latency while the limiter is on. Switching it on or
+    off changes the latency, as switching the oversampling factor does.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "AudioArena.h"
+using namespace juce;
+
+//==============================================================================
+class LimiterStage
+{
+public:
+    static constexpr double lookaheadSeconds = 0.002;
+    static constexpr double releaseSeconds = 0.1;
+
+    /** As many as the waveshaper takes. */
+    static constexpr int maxChannels = 16;
+
+    LimiterStage();
+
+    /** Call from prepareToPlay. */
+    void prepare (double sampleRate, int numChannels, int maxBlockSize);
+
+    /** Takes the delay lines and the detector's buffers, see AudioArena. */
+    void takeWorkingMemory (AudioArena& arena) noexcept;
+
+    /** Clears the delay and the detector, with the gain back at unity. */
+    void reset() noexcept;
+
+    /** Audio thread, once per block. Returns true if that changed the latency.
+        Switching on fades in from silence, since the delay starts out empty.
+    */
+    bool setEnabled (bool shouldBeEnabled) noexcept;
+
+    /** Audio thread: the most any true peak may reach, as a gain. */
+    void setCeiling (float newCeiling) noexcept     { ceiling = jlimit (1.0e-4f, 1.0f, newCeiling); }
+
+    /** Audio thread. Already true in prepareToPlay, before the buffers are handed out,
+        so the latency can be reported from there.
+    */
+    bool isActive() const noexcept                  { return enabled; }
+
+    /** What the stage adds to the plugin's latency: the lookahead while it's on, else 0. */
+    int getLatencyInSamples() const noexcept        { return isActive() ? latency : 0; }
+
+    /** The same: once the input has been silent that long, the delay holds nothing but zeros. */
+    int getTailLengthInSamples() const noexcept     { return getLatencyInSamples(); }
+
+    /** Limits the channels in place, late by getLatencyInSamples(). Does nothing unless isActive(). */
+    template <typename SampleType>
+    void process (const dsp::AudioBlock<SampleType>& block) noexcept;
+
+    /** Delays the channels without limiting them, for the host's bypass. The detector
+        keeps running, so the gain is right as soon as the bypass ends.
+    */
+    template <typename SampleType>
+    void processBypassed (const dsp::AudioBlock<SampleType>& block) noexcept;
+
+private:
+    static constexpr int numPhases = 4;
+    static constexpr int numTaps = 12;                  // per phase
+    static constexpr int detectorDelay = numTaps / 2;
+
+    template <typename SampleType>
+    void run (const dsp::AudioBlock<SampleType>& block, bool applyGain) noexcept;
+
+    void detectPeaks (int channel, int numSamples) noexcept;
+    void computeGains (int numSamples) noexcept;
+
+    // The in-between phases, the first phase is the samples themselves
+    float coefficients[numPhases - 1][numTaps] = {};
+
+    double* delay[maxChannels] = {};        // from the arena, double so either sample type goes through as it is
+    float* history[maxChannels] = {};       // numTaps - 1 old samples, then the block
+    float* peaks = nullptr;                 // the highest true peak per sample, over all channels
+    float* gains = nullptr;
+
+    // The sliding maximum: the peaks that can still be the highest in the window,
+    // falling from front to back, with when each came in
+    float* windowPeaks = nullptr;
+    int64* windowTimes = nullptr;
+    int windowMask = 0, windowFront = 0, windowSize = 0;
+    int64 time = 0;
+
+    float* average = nullptr;               // the last lookahead samples' gains
+    int averagePosition = 0;
+
+    int numChannels = 0, maxBlockSize = 0;
+    int lookahead = 1, latency = detectorDelay, delayPosition = 0;
+    float ceiling = 1.0f, releaseCoefficient = 0.0f, envelope = 1.0f;
+    bool enabled = false;
+
+    JUCE_DECLARE_NON_COPYABLE (LimiterStage)
+};
@@ -0,0 +1,213 @@
+/*
+  ==============================================================================
+
+    MeterDisplay.cpp
+
+  ==============================================================================
+*/
+
+#include "MeterDisplay.h"
+
+namespace
+{
+    const Colour meterBackground (17, 25, 25);
+    const Colour meterFill (107, 142, 78);
+    const Colour meterHighlight (76, 187, 23);
+    const Colour meterPale (213, 245, 223);
+}
+
+//==============================================================================
+LevelMeter::LevelMeter (Style meterStyle)
+    : style (meterStyle)
+{
+    setOpaque (true);
+}
+
+void LevelMeter::setLevels (float newPeakDb, float newRmsDb)
+{
+    peakDb = newPeakDb;
+    rmsDb = newRmsDb;
+
+    auto peakY = levelToY (peakDb);
+    auto rmsY = levelToY (rmsDb);
+
+    if (peakY != drawnPeakY || rmsY != drawnRmsY)
+    {
+        drawnPeakY = peakY;
+        drawnRmsY = rmsY;
+        repaint();
+    }
+}
+
+int LevelMeter::levelToY (float db) const noexcept
+{
+    auto height = (float) getHeight();
+
+    if (style == Style::reduction)
+        return roundToInt (jlimit (0.0f, 1.0f, db / 24.0f) * height);
+
+    return roundToInt ((1.0f - jlimit (0.0f, 1.0f, (db + 60.0f) / 60.0f)) * height);
+}
+
+void LevelMeter::paint (Graphics& g)
+{
+    g.fillAll (meterBackground);
+
+    auto width = getWidth();
+    auto peakY = levelToY (peakDb);
+
+    if (style == Style::reduction)
+    {
+        g.setColour (meterPale);
+        g.fillRect (0, 0, width, peakY);
+        return;
+    }
+
+    auto rmsY = levelToY (rmsDb);
+
+    g.setColour (meterFill);
+    g.fillRect (0, rmsY, width, getHeight() - rmsY);
+
+    if (peakY < getHeight())
+    {
+        g.setColour (meterHighlight);
+        g.fillRect (0, peakY, width, 2);
+    }
+}
+
+//==============================================================================
+TransferCurveDisplay::TransferCurveDisplay()
+{
+    setOpaque (true);
+}
+
+void TransferCurveDisplay::setParameters (const DistortionParameters& newParameters)
+{
+    if (newParameters == parameters)
+        return;
+
+    parameters = newParameters;
+    rebuildCurve();
+    repaint();
+}
+
+void TransferCurveDisplay::setInputPeak (float newPeak)
+{
+    inputPeak = jlimit (0.0f, 1.0f, newPeak);
+
+    auto dot = toScreen (inputPeak, evaluate (inputPeak)).roundToInt();
+
+    if (dot != drawnDot)
+    {
+        drawnDot = dot;
+        repaint();
+    }
+}
+
+float TransferCurveDisplay::evaluate (float x) const noexcept
+{
+    auto distorted = jlimit (-parameters.threshold, parameters.threshold, std::tanh (x * parameters.drive));
+    return (parameters.dry * x + parameters.wet * distorted) * parameters.outputLvl;
+}
+
+Point<float> TransferCurveDisplay::toScreen (float x, float y) const noexcept
+{
+    // Both axes run from -1 to 1
+    return { (x + 1.0f) * 0.5f * (float) getWidth(),
+             (1.0f - (y + 1.0f) * 0.5f) * (float) getHeight() };
+}
+
+void TransferCurveDisplay::rebuildCurve()
+{
+    const int numPoints = 64;
+    curve.clear();
+
+    for (int i = 0; i <= numPoints; ++i)
+    {
+        auto x = -1.0f + 2.0f * (float) i / (float) numPoints;
+        auto point = toScreen (x, evaluate (x));
+
+        if (i == 0)
+            curve.startNewSubPath (point);
+        else
+            curve.lineTo (point);
+    }
+}
+
+void TransferCurveDisplay::resized()
+{
+    rebuildCurve();
+}
+
+void TransferCurveDisplay::paint (Graphics& g)
+{
+    g.fillAll (meterBackground);
+
+    auto bounds = getLocalBounds().toFloat();
+
+    g.setColour (meterFill.withAlpha (0.3f));
+    g.drawLine (bounds.getCentreX(), 0.0f, bounds.getCentreX(), bounds.getBottom());
+    g.drawLine (0.0f, bounds.getCentreY(), bounds.getRight(), bounds.getCentreY());
+
+    g.reduceClipRegion (getLocalBounds());
+    g.setColour (meterHighlight);
+    g.strokePath (curve, PathStrokeType (1.5f));
+
+    if (inputPeak > 0.0f)
+    {
+        g.setColour (meterPale);
+        g.fillEllipse (Rectangle<float> (5.0f, 5.0f).withCentre (drawnDot.toFloat()));
+    }
+}
+
+//==============================================================================
+WaveformDisplay::WaveformDisplay()
+{
+    setOpaque (true);
+}
+
+void WaveformDisplay::pushColumn (float minimum, float maximum) noexcept
+{
+    minimums[(size_t) writeIndex] = minimum;
+    maximums[(size_t) writeIndex] = maximum;
+    writeIndex = (writeIndex + 1) % numColumns;
+
+    silentColumns = (minimum == 0.0f && maximum == 0.0f) ? jmin (numColumns, silentColumns + 1) : 0;
+    hasNewColumns = true;
+}
+
+void WaveformDisplay::refresh()
+{
+    if (! hasNewColumns)
+        return;
+
+    hasNewColumns = false;
+
+    // Once silence has scrolled all the way through there's nothing new to draw
+    auto isFlat = silentColumns >= numColumns;
+
+    if (isFlat && drawnFlat)
+        return;
+
+    drawnFlat = isFlat;
+    repaint();
+}
+
+void WaveformDisplay::paint (Graphics& g)
+{
+    g.fillAll (meterBackground);
+    g.setColour (meterFill);
+
+    auto centre = (float) getHeight() * 0.5f;
+    auto columnWidth = (float) getWidth() / (float) numColumns;
+
+    // Oldest column on the left
+    for (int i = 0; i < numColumns; ++i)
+    {
+        auto index = (size_t) ((writeIndex + i) % numColumns);
+        auto top    = centre - jlimit (-1.0f, 1.0f, maximums[index]) * centre;
+        auto bottom = centre - jlimit (-1.0f, 1.0f, minimums[index]) * centre;
+
+        g.fillRect ((float) i * columnWidth, top, columnWidth, jmax (1.0f, bottom - top));
+    }
+}
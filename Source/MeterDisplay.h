@@ -0,0 +1,100 @@
+/*
+  ==============================================================================
+
+    MeterDisplay.h
+
+    The components that show what MeterSource measures. Each of them keeps
+    track of what it last drew and only repaints its own bounds when the
+    picture would visibly change, so an idle editor costs next to nothing
+    and a busy one never repaints more than these few small areas.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "Core/DistortionParameters.h"
+using namespace juce;
+
+//==============================================================================
+/** A vertical bar: peak and RMS level, or gain reduction hanging down from the top. */
+class LevelMeter  : public Component
+{
+public:
+    enum class Style
+    {
+        level,          // -60 to 0 dB, filling up from the bottom
+        reduction       // 0 to 24 dB, filling down from the top
+    };
+
+    explicit LevelMeter (Style meterStyle = Style::level);
+
+    /** Both in dB. Repaints only if either bar moves by at least a pixel. */
+    void setLevels (float newPeakDb, float newRmsDb);
+
+    void paint (Graphics&) override;
+
+private:
+    int levelToY (float db) const noexcept;
+
+    Style style;
+    float peakDb = -100.0f, rmsDb = -100.0f;
+    int drawnPeakY = -1, drawnRmsY = -1;
+
+    JUCE_DECLARE_NON_COPYABLE (LevelMeter)
+};
+
+//==============================================================================
+/** The input -> output curve for the current settings, with a dot on the input peak. */
+class TransferCurveDisplay  : public Component
+{
+public:
+    TransferCurveDisplay();
+
+    /** Rebuilds the curve only when one of the parameters has actually changed. */
+    void setParameters (const DistortionParameters& newParameters);
+
+    /** Moves the dot. Repaints only if it moves by at least a pixel. */
+    void setInputPeak (float newPeak);
+
+    void paint (Graphics&) override;
+    void resized() override;
+
+private:
+    float evaluate (float x) const noexcept;
+    Point<float> toScreen (float x, float y) const noexcept;
+    void rebuildCurve();
+
+    DistortionParameters parameters;
+    float inputPeak = 0.0f;
+    Point<int> drawnDot { -1, -1 };
+    Path curve;
+
+    JUCE_DECLARE_NON_COPYABLE (TransferCurveDisplay)
+};
+
+//==============================================================================
+/** A scrolling min/max outline of the output, one column per MeterFrame. */
+class WaveformDisplay  : public Component
+{
+public:
+    static constexpr int numColumns = 128;
+
+    WaveformDisplay();
+
+    void pushColumn (float minimum, float maximum) noexcept;
+
+    /** Call once after pushing a batch of columns. */
+    void refresh();
+
+    void paint (Graphics&) override;
+
+private:
+    std::array<float, numColumns> minimums {}, maximums {};
+    int writeIndex = 0;
+    int silentColumns = numColumns;     // how many of the newest columns are flat
+    bool hasNewColumns = false, drawnFlat = true;
+
+    JUCE_DECLARE_NON_COPYABLE (WaveformDisplay)
+};
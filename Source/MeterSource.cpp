@@ -0,0 +1,125 @@
+/*
+  ==============================================================================
+
+    MeterSource.cpp
+
+  ==============================================================================
+*/
+
+#include "MeterSource.h"
+
+//==============================================================================
+void MeterSource::prepare (double sampleRate, double frameLengthSeconds)
+{
+    samplesPerFrame = jmax (1, roundToInt (sampleRate * frameLengthSeconds));
+    resetPending();
+}
+
+void MeterSource::resetPending() noexcept
+{
+    pending = {};
+    inputSquares = outputSquares = 0.0;
+    numValues = 0;
+}
+
+bool MeterSource::shouldMeasure() noexcept
+{
+    auto active = isEnabled();
+
+    // A frame that was half collected when the editor closed would be stale by now
+    if (active && ! wasEnabled)
+        resetPending();
+
+    wasEnabled = active;
+    return active;
+}
+
+template <typename SampleType>
+void MeterSource::measureInput (const dsp::AudioBlock<SampleType>& block, const DistortionParameters& parameters) noexcept
+{
+    auto numSamples = (int) block.getNumSamples();
+    float peak = 0.0f;
+
+    // With the threshold below 1, anything driven past atanh (threshold) lands on the clamp
+    auto clipsAt = parameters.threshold < 1.0f ? (SampleType) (std::atanh (parameters.threshold) / parameters.drive)
+                                               : std::numeric_limits<SampleType>::max();
+
+    for (size_t channel = 0; channel < block.getNumChannels(); ++channel)
+    {
+        auto* data = block.getChannelPointer (channel);
+        auto range = FloatVectorOperations::findMinAndMax (data, numSamples);
+        auto channelPeak = jmax (-range.getStart(), range.getEnd());
+        peak = jmax (peak, (float) channelPeak);
+
+        double squares = 0.0;
+
+        for (int i = 0; i < numSamples; ++i)
+            squares += (double) (data[i] * data[i]);
+
+        inputSquares += squares;
+
+        if (channelPeak > clipsAt)
+            for (int i = 0; i < numSamples; ++i)
+                pending.clippedSamples += std::abs (data[i]) > clipsAt ? 1 : 0;
+    }
+
+    pending.inputPeak = jmax (pending.inputPeak, peak);
+
+    // The curve is monotonic, so the loudest input sample tells how hard the clamp is working
+    auto shapedPeak = std::tanh (peak * parameters.drive);
+
+    if (shapedPeak > parameters.threshold)
+        pending.gainReductionDb = jmax (pending.gainReductionDb, Decibels::gainToDecibels (shapedPeak / parameters.threshold));
+}
+
+template <typename SampleType>
+void MeterSource::measureOutput (const dsp::AudioBlock<SampleType>& block) noexcept
+{
+    auto numSamples = (int) block.getNumSamples();
+    auto numChannels = (int) block.getNumChannels();
+
+    for (size_t channel = 0; channel < block.getNumChannels(); ++channel)
+    {
+        auto* data = block.getChannelPointer (channel);
+        auto range = FloatVectorOperations::findMinAndMax (data, numSamples);
+
+        pending.outputMin = jmin (pending.outputMin, (float) range.getStart());
+        pending.outputMax = jmax (pending.outputMax, (float) range.getEnd());
+
+        double squares = 0.0;
+
+        for (int i = 0; i < numSamples; ++i)
+            squares += (double) (data[i] * data[i]);
+
+        outputSquares += squares;
+    }
+
+    pending.outputPeak = jmax (-pending.outputMin, pending.outputMax);
+    pending.numSamples += numSamples;
+    numValues += (int64) numSamples * numChannels;
+
+    if (pending.numSamples < samplesPerFrame)
+        return;
+
+    if (numValues > 0)
+    {
+        pending.inputRms  = (float) std::sqrt (inputSquares  / (double) numValues);
+        pending.outputRms = (float) std::sqrt (outputSquares / (double) numValues);
+    }
+
+    // If the editor hasn't kept up, this frame is dropped rather than waiting for it
+    {
+        auto scope = fifo.write (1);
+
+        if (scope.blockSize1 > 0)
+            frames[(size_t) scope.startIndex1] = pending;
+    }
+
+    resetPending();
+}
+
+//==============================================================================
+template void MeterSource::measureInput  (const dsp::AudioBlock<float>&,  const DistortionParameters&) noexcept;
+template void MeterSource::measureInput  (const dsp::AudioBlock<double>&, const DistortionParameters&) noexcept;
+template void MeterSource::measureOutput (const dsp::AudioBlock<float>&)  noexcept;
+template void MeterSource::measureOutput (const dsp::AudioBlock<double>&) noexcept;
@@ -0,0 +1,85 @@
+/*
+  ==============================================================================
+
+    MeterSource.h
+
+    Collects levels on the audio thread and hands them to the editor through a
+    single producer / single consumer FIFO. Nothing in here allocates or locks
+    once prepare() has been called, and the audio thread never waits: if the
+    editor falls behind and the FIFO fills up, new frames are simply dropped.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "Core/DistortionParameters.h"
+using namespace juce;
+
+//==============================================================================
+/** What the meters show for a few milliseconds of audio. Levels are linear gains. */
+struct MeterFrame
+{
+    float inputPeak = 0.0f, inputRms = 0.0f;
+    float outputPeak = 0.0f, outputRms = 0.0f;
+    float gainReductionDb = 0.0f;       // how far the threshold clamp pulled the loudest sample down
+    float outputMin = 0.0f, outputMax = 0.0f;   // one column of the waveform display
+    int clippedSamples = 0;             // samples that ended up on the threshold clamp
+    int numSamples = 0;
+};
+
+//==============================================================================
+class MeterSource
+{
+public:
+    static constexpr int capacity = 256;
+
+    MeterSource() = default;
+
+    /** Frames are cut every frameLengthSeconds, whatever the host's block size is. */
+    void prepare (double sampleRate, double frameLengthSeconds = 0.005);
+
+    /** Only measured while enabled - the editor switches this on while it's open. */
+    void setEnabled (bool shouldBeEnabled) noexcept     { enabled.store (shouldBeEnabled, std::memory_order_relaxed); }
+    bool isEnabled() const noexcept                     { return enabled.load (std::memory_order_relaxed); }
+
+    /** Audio thread: call once per buffer, and only measure it if this returns true. */
+    bool shouldMeasure() noexcept;
+
+    /** Audio thread: call with the input of a block, before it's processed. */
+    template <typename SampleType>
+    void measureInput (const dsp::AudioBlock<SampleType>& block, const DistortionParameters& parameters) noexcept;
+
+    /** Audio thread: call with the same block once it has been processed. */
+    template <typename SampleType>
+    void measureOutput (const dsp::AudioBlock<SampleType>& block) noexcept;
+
+    /** Message thread: calls frameCallback (const MeterFrame&) for every frame that has
+        arrived since the last call, oldest first. Returns the number of frames read.
+    */
+    template <typename Callback>
+    int readFrames (Callback&& frameCallback)
+    {
+        auto scope = fifo.read (fifo.getNumReady());
+        scope.forEach ([&] (int index) { frameCallback (frames[(size_t) index]); });
+        return scope.blockSize1 + scope.blockSize2;
+    }
+
+private:
+    void resetPending() noexcept;
+
+    AbstractFifo fifo { capacity };
+    std::array<MeterFrame, capacity> frames;
+
+    // Audio thread only
+    MeterFrame pending;
+    double inputSquares = 0.0, outputSquares = 0.0;
+    int64 numValues = 0;
+    int samplesPerFrame = 256;
+    bool wasEnabled = false;
+
+    std::atomic<bool> enabled { false };
+
+    JUCE_DECLARE_NON_COPYABLE (MeterSource)
+};
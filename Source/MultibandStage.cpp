@@ -0,0 +1,249 @@
+/*
+  ==============================================================================
+
+    MultibandStage.cpp
+
+  ==============================================================================
+*/
+
+#include "MultibandStage.h"
+
+//==============================================================================
+template <typename SampleType>
+void MultibandStage<SampleType>::prepare (double sampleRate, int numChannels, int maxBlockSize)
+{
+    for (int i = 0; i <= OversamplingOptions::maxFactorIndex; ++i)
+    {
+        auto& crossover = crossovers[i];
+        crossover.sampleRate = sampleRate * (1 << i);
+
+        dsp::ProcessSpec spec { crossover.sampleRate, (uint32) (maxBlockSize << i), (uint32) numChannels };
+
+        // The splits give both outputs at once, so their own type doesn't matter
+        for (auto& filter : crossover.split)
+            filter.prepare (spec);
+
+        for (auto& filter : crossover.allpass)
+        {
+            filter.setType (dsp::LinkwitzRileyFilterType::allpass);
+            filter.prepare (spec);
+        }
+
+        std::fill (std::begin (crossover.applied), std::end (crossover.applied), 0.0f);
+    }
+
+    maxFrames = maxBlockSize * OversamplingOptions::getMaxFactor();
+
+    for (int band = 0; band < maxBands; ++band)
+    {
+        for (auto* value : { &drive[band], &threshold[band], &level[band] })
+        {
+            value->reset (sampleRate, 0.05);
+            value->setCurrentAndTargetValue (1.0f);
+        }
+
+        bandStart[band] = bandEnd[band] = {};
+    }
+
+    // Spread out evenly until the first block says otherwise
+    for (int i = 0; i < maxBands - 1; ++i)
+    {
+        frequencies[i].reset (sampleRate, 0.05);
+        frequencies[i].setCurrentAndTargetValue (200.0f * std::pow (5.0f, (float) i));
+    }
+
+    // The lowest crossover rings the longest. A 4th order Butterworth pair at f
+    // takes about 5 / f seconds to decay below -150 dB.
+    tailLength = (int) std::ceil (5.0 / minCrossover * sampleRate);
+
+    reset();
+}
+
+template <typename SampleType>
+void MultibandStage<SampleType>::takeWorkingMemory (AudioArena& arena) noexcept
+{
+    frames = arena.allocate<SampleType> ((size_t) (maxFrames * maxBands));
+}
+
+template <typename SampleType>
+void MultibandStage<SampleType>::reset() noexcept
+{
+    for (auto& crossover : crossovers)
+    {
+        for (auto& filter : crossover.split)
+            filter.reset();
+
+        for (auto& filter : crossover.allpass)
+            filter.reset();
+    }
+}
+
+template <typename SampleType>
+void MultibandStage<SampleType>::setNumBands (int newNumBands) noexcept
+{
+    newNumBands = jlimit (1, maxBands, newNumBands);
+
+    if (newNumBands == numBands)
+        return;
+
+    // The filters feed different bands now, whatever they still hold is meaningless
+    numBands = newNumBands;
+    reset();
+}
+
+//==============================================================================
+template <typename SampleType>
+void MultibandStage<SampleType>::beginBlock (const BandSettings* targets, const float* crossoverTargets, int numSamples) noexcept
+{
+    auto advance = [numSamples] (SmoothedValue<float>& value, float target, float& startValue, float& endValue)
+    {
+        value.setTargetValue (target);
+        startValue = value.getCurrentValue();
+        endValue = value.isSmoothing() ? value.skip (numSamples) : startValue;
+    };
+
+    for (int band = 0; band < maxBands; ++band)
+    {
+        advance (drive[band],     targets[band].drive,     bandStart[band].drive,     bandEnd[band].drive);
+        advance (threshold[band], targets[band].threshold, bandStart[band].threshold, bandEnd[band].threshold);
+        advance (level[band],     targets[band].level,     bandStart[band].level,     bandEnd[band].level);
+    }
+
+    // Kept in ascending order, so a band can shrink to nothing but never turn inside out
+    auto lowest = minCrossover;
+
+    for (int i = 0; i < maxBands - 1; ++i)
+    {
+        lowest = jmax (lowest, crossoverTargets[i]);
+        frequencies[i].setTargetValue (lowest);
+        frequencies[i].skip (numSamples);
+    }
+}
+
+template <typename SampleType>
+void MultibandStage<SampleType>::setFrequencies (Crossover& crossover) noexcept
+{
+    // The filters are retuned once per block, to where the ramps have got to by its end
+    const auto ceiling = (float) (crossover.sampleRate * 0.45);
+    bool changed = false;
+
+    for (int i = 0; i < maxBands - 1; ++i)
+    {
+        auto frequency = jmin (frequencies[i].getCurrentValue(), ceiling);
+
+        if (frequency != crossover.applied[i])
+        {
+            crossover.applied[i] = frequency;
+            crossover.split[i].setCutoffFrequency ((SampleType) frequency);
+            changed = true;
+        }
+    }
+
+    if (changed)
+    {
+        crossover.allpass[0].setCutoffFrequency ((SampleType) crossover.applied[1]);
+        crossover.allpass[1].setCutoffFrequency ((SampleType) crossover.applied[2]);
+        crossover.allpass[2].setCutoffFrequency ((SampleType) crossover.applied[2]);
+    }
+}
+
+template <typename SampleType>
+void MultibandStage<SampleType>::split (Crossover& crossover, int channel, const SampleType* input, int numSamples) noexcept
+{
+    auto* frame = frames;
+    auto* splits = crossover.split;
+    auto* allpass = crossover.allpass;
+
+    // Each band goes through allpass copies of the crossovers above it that it
+    // wasn't split by, so all of them come out with the same phase response
+    switch (numBands)
+    {
+        case 2:
+            for (int i = 0; i < numSamples; ++i, frame += maxBands)
+            {
+                splits[0].processSample (channel, input[i], frame[0], frame[1]);
+                frame[2] = frame[3] = 0;
+            }
+            break;
+
+        case 3:
+            for (int i = 0; i < numSamples; ++i, frame += maxBands)
+            {
+                SampleType low, high;
+                splits[0].processSample (channel, input[i], low, high);
+                splits[1].processSample (channel, high, frame[1], frame[2]);
+                frame[0] = allpass[0].processSample (channel, low);
+                frame[3] = 0;
+            }
+            break;
+
+        default:
+            for (int i = 0; i < numSamples; ++i, frame += maxBands)
+            {
+                SampleType low, high, mid, upper;
+                splits[0].processSample (channel, input[i], low, high);
+                splits[1].processSample (channel, high, mid, upper);
+                splits[2].processSample (channel, upper, frame[2], frame[3]);
+                frame[0] = allpass[1].processSample (channel, allpass[0].processSample (channel, low));
+                frame[1] = allpass[2].processSample (channel, mid);
+            }
+            break;
+    }
+}
+
+template <typename SampleType>
+void MultibandStage<SampleType>::getBandParameters (const DistortionParameters& start, const DistortionParameters& end,
+                                                    float alpha, DistortionParameters* bands) const noexcept
+{
+    auto lerp = [alpha] (float a, float b) { return a + (b - a) * alpha; };
+
+    for (int band = 0; band < maxBands; ++band)
+    {
+        auto& p = bands[band];
+        p.drive     = lerp (start.drive, end.drive)         * lerp (bandStart[band].drive, bandEnd[band].drive);
+        p.threshold = lerp (start.threshold, end.threshold) * lerp (bandStart[band].threshold, bandEnd[band].threshold);
+        p.outputLvl = lerp (start.outputLvl, end.outputLvl) * lerp (bandStart[band].level, bandEnd[band].level);
+        p.wet       = lerp (start.wet, end.wet);
+        p.dry       = lerp (start.dry, end.dry);
+    }
+}
+
+//==============================================================================
+template <typename SampleType>
+void MultibandStage<SampleType>::process (SampleType* const* channels, int numChannels, int numSamples, int factorIndex,
+                                          const DistortionParameters& start, const DistortionParameters& end) noexcept
+{
+    jassert (numSamples <= maxFrames);
+    numSamples = jmin (numSamples, maxFrames);
+
+    auto& crossover = crossovers[jlimit (0, OversamplingOptions::maxFactorIndex, factorIndex)];
+    setFrequencies (crossover);
+
+    auto moving = start != end;
+
+    for (int band = 0; band < numBands; ++band)
+        moving = moving || bandStart[band] != bandEnd[band];
+
+    // While something moves the bands get new parameters every few samples, which
+    // is close enough to a per sample ramp and keeps the kernel on constants.
+    const int rampStep = moving ? 16 : numSamples;
+    DistortionParameters bands[maxBands];
+
+    for (int channel = 0; channel < numChannels; ++channel)
+    {
+        auto* data = channels[channel];
+        split (crossover, channel, data, numSamples);
+
+        for (int offset = 0; offset < numSamples; offset += rampStep)
+        {
+            auto length = jmin (rampStep, numSamples - offset);
+            getBandParameters (start, end, (float) (offset + length) / (float) numSamples, bands);
+
+            WaveshaperKernel::processBands (frames + offset * maxBands, data + offset, length, bands, accuracy);
+        }
+    }
+}
+
+//==============================================================================
+template class MultibandStage<float>;
+template class MultibandStage<double>;
@@ -0,0 +1,118 @@
+/*
+  ==============================================================================
+
+    MultibandStage.h
+
+    Splits the signal into 2, 3 or 4 bands with Linkwitz-Riley crossovers and
+    distorts each band with its own drive, threshold and level, so the low end
+    can stay tight while the top is driven hard.
+
+    The crossovers are 4th order, and every band is passed through allpass
+    copies of the crossovers it didn't go through, so all bands leave with the
+    same phase. With every band set the same and the curve in its linear
+    region the bands sum back to an allpass of the input: flat magnitude.
+
+    It runs inside the oversampling stage, at the oversampled rate, and mixes
+    the dry signal per band as well - the dry signal has to see the same phase
+    shift as the wet one, or the mix would comb filter around the crossovers.
+    Everything is allocated in prepare().
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "AudioArena.h"
+#include "Core/DistortionParameters.h"
+#include "OversamplingStage.h"
+#include "Core/WaveshaperKernel.h"
+using namespace juce;
+
+//==============================================================================
+/** One band's settings, as linear gains on top of the global drive, threshold and output level. */
+struct BandSettings
+{
+    float drive     = 1.0f;
+    float threshold = 1.0f;
+    float level     = 1.0f;
+
+    bool operator== (const BandSettings& other) const noexcept
+    {
+        return drive == other.drive && threshold == other.threshold && level == other.level;
+    }
+
+    bool operator!= (const BandSettings& other) const noexcept    { return ! operator== (other); }
+};
+
+//==============================================================================
+template <typename SampleType>
+class MultibandStage
+{
+public:
+    static constexpr int maxBands = WaveshaperKernel::bandLanes;
+    static constexpr float minCrossover = 40.0f;
+
+    MultibandStage() = default;
+
+    /** maxBlockSize is at the host rate, the filters are set up for every oversampling factor. */
+    void prepare (double sampleRate, int numChannels, int maxBlockSize);
+
+    /** Takes the band buffer for what prepare() was given, see AudioArena. */
+    void takeWorkingMemory (AudioArena& arena) noexcept;
+    void reset() noexcept;
+
+    /** 1 turns the split off. Changing the number of bands clears the filters. */
+    void setNumBands (int newNumBands) noexcept;
+    int getNumBands() const noexcept                { return numBands; }
+    bool isActive() const noexcept                  { return numBands > 1; }
+
+    /** The table mode has no per band version, it runs the bands with the fast tanh. */
+    void setAccuracy (WaveshaperKernel::Accuracy newAccuracy) noexcept     { accuracy = newAccuracy; }
+
+    /** How long the crossovers ring after the input stops, at the host rate. */
+    int getTailLengthInSamples() const noexcept     { return isActive() ? tailLength : 0; }
+
+    /** Call once per host block with the band settings and crossover frequencies
+        (maxBands - 1 of them, in Hz) the block should head for. They're ramped
+        over numSamples the same way the global parameters are.
+    */
+    void beginBlock (const BandSettings* targets, const float* crossoverTargets, int numSamples) noexcept;
+
+    /** Splits, distorts and sums the channels in place. factorIndex is the oversampling
+        the channels are running at (0 = none, as in OversamplingStage::setMode), and
+        start and end are the global parameters including the dry mix and output level.
+    */
+    void process (SampleType* const* channels, int numChannels, int numSamples, int factorIndex,
+                  const DistortionParameters& start, const DistortionParameters& end) noexcept;
+
+private:
+    // One set of filters per oversampling factor, so switching never needs a prepare
+    struct Crossover
+    {
+        dsp::LinkwitzRileyFilter<SampleType> split[maxBands - 1];       // at each crossover frequency
+        dsp::LinkwitzRileyFilter<SampleType> allpass[maxBands - 1];     // band 1 through f2 and f3, band 2 through f3
+        float applied[maxBands - 1] {};                                 // the frequencies the filters are tuned to
+        double sampleRate = 44100.0;
+    };
+
+    void setFrequencies (Crossover& crossover) noexcept;
+    void split (Crossover& crossover, int channel, const SampleType* input, int numSamples) noexcept;
+
+    void getBandParameters (const DistortionParameters& start, const DistortionParameters& end,
+                            float alpha, DistortionParameters* bands) const noexcept;
+
+    Crossover crossovers[OversamplingOptions::maxFactorIndex + 1];
+    SampleType* frames = nullptr;       // maxBands interleaved samples per frame, from the arena
+    int maxFrames = 0;
+
+    SmoothedValue<float> drive[maxBands], threshold[maxBands], level[maxBands];
+    SmoothedValue<float, ValueSmoothingTypes::Multiplicative> frequencies[maxBands - 1];
+    BandSettings bandStart[maxBands], bandEnd[maxBands];
+
+    WaveshaperKernel::Accuracy accuracy = WaveshaperKernel::Accuracy::fast;
+    int numBands = 1;
+    int tailLength = 0;
+
+    JUCE_DECLARE_NON_COPYABLE (MultibandStage)
+};
@@ -0,0 +1,330 @@
+/*
+  ==============================================================================
+
+    OversamplingStage.cpp
+
+  ==============================================================================
+*/
+
+#include "OversamplingStage.h"
+#include "MultibandStage.h"
+
+//==============================================================================
+template <typename SampleType>
+void OversamplingStage<SampleType>::prepare (double sampleRate, int numChannels, int maxBlockSize)
+{
+    int maxLatency = 0;
+
+    for (int filter = 0; filter < 2; ++filter)
+    {
+        auto type = filter == (int) Filter::iirMinimumPhase ? dsp::Oversampling<SampleType>::filterHalfBandPolyphaseIIR
+                                                            : dsp::Oversampling<SampleType>::filterHalfBandFIREquiripple;
+
+        for (int i = 0; i < maxFactorIndex; ++i)
+        {
+            // Integer latency so the dry path can be compensated with a plain delay
+            auto& oversampler = oversamplers[filter][i];
+            oversampler = std::make_unique<dsp::Oversampling<SampleType>> ((size_t) numChannels, (size_t) (i + 1),
+                                                                           type, true, true);
+            oversampler->initProcessing ((size_t) maxBlockSize);
+            tailLengths[filter][i] = TailCache::getInstance().get ({ (int) sizeof (SampleType), filter, i }, [&]
+            {
+                return measureTail (*oversampler, numChannels, maxBlockSize);
+            });
+
+            maxLatency = jmax (maxLatency, roundToInt (oversampler->getLatencyInSamples()));
+        }
+    }
+
+    dryNumChannels = jmin (numChannels, Waveshaper::maxChannels);
+    dryMaxSamples = maxBlockSize;
+
+    // Plus the sample the shaper's delay can add at most
+    dryDelay.setMaximumDelayInSamples (maxLatency + 1);
+    dryDelay.prepare ({ sampleRate, (uint32) maxBlockSize, (uint32) numChannels });
+
+    isPrepared = true;
+    updateLatency();
+    reset();
+}
+
+template <typename SampleType>
+void OversamplingStage<SampleType>::takeWorkingMemory (AudioArena& arena) noexcept
+{
+    for (int channel = 0; channel < dryNumChannels; ++channel)
+        dryChannels[channel] = arena.allocate<SampleType> ((size_t) dryMaxSamples);
+}
+
+template <typename SampleType>
+void OversamplingStage<SampleType>::reset() noexcept
+{
+    for (auto& filter : oversamplers)
+        for (auto& oversampler : filter)
+            if (oversampler != nullptr)
+                oversampler->reset();
+
+    dryDelay.reset();
+    filtersIdle = false;
+}
+
+template <typename SampleType>
+bool OversamplingStage<SampleType>::setMode (int newFactorIndex, Filter newFilter) noexcept
+{
+    newFactorIndex = jlimit (0, maxFactorIndex, newFactorIndex);
+
+    if (newFactorIndex == factorIndex && newFilter == filterType)
+        return false;
+
+    factorIndex = newFactorIndex;
+    filterType = newFilter;
+
+    // The newly selected chain may still hold audio from the last time it was used
+    if (auto* active = getActiveOversampler())
+        active->reset();
+
+    auto oldLatency = latency;
+    updateLatency();
+
+    return latency != oldLatency;
+}
+
+template <typename SampleType>
+void OversamplingStage<SampleType>::updateLatency() noexcept
+{
+    auto* active = getActiveOversampler();
+    latency = active != nullptr ? roundToInt (active->getLatencyInSamples()) : 0;
+    tailLength = active != nullptr ? *tailLengths[(int) filterType][factorIndex - 1] : 0;
+
+    dryDelay.reset();
+    dryDelay.setDelay ((SampleType) (latency + dryFraction));
+}
+
+template <typename SampleType>
+void OversamplingStage<SampleType>::setDryFraction (double newFraction) noexcept
+{
+    // Not reset: the interpolation just moves, so the dry signal carries on without a gap
+    if (newFraction != dryFraction)
+    {
+        dryFraction = newFraction;
+        dryDelay.setDelay ((SampleType) (latency + dryFraction));
+    }
+}
+
+template <typename SampleType>
+dsp::Oversampling<SampleType>* OversamplingStage<SampleType>::getActiveOversampler() const noexcept
+{
+    if (factorIndex == 0 || ! isPrepared)
+        return nullptr;
+
+    return oversamplers[(int) filterType][factorIndex - 1].get();
+}
+
+template <typename SampleType>
+int OversamplingStage<SampleType>::measureTail (dsp::Oversampling<SampleType>& oversampler, int numChannels, int maxBlockSize)
+{
+    // Feeds an impulse through the up and down filters and finds the last
+    // output sample above -150 dB, which is far below anything float audio
+    // can carry next to a full scale signal.
+    const auto threshold = (SampleType) 3.0e-8;
+    const int maxTail = 1 << 16;
+
+    AudioBuffer<SampleType> impulse (numChannels, maxBlockSize);
+    int tail = 0;
+
+    for (int offset = 0; offset < maxTail; offset += maxBlockSize)
+    {
+        impulse.clear();
+
+        if (offset == 0)
+            impulse.setSample (0, 0, (SampleType) 1);
+
+        dsp::AudioBlock<SampleType> block (impulse);
+        oversampler.processSamplesUp (block);
+        oversampler.processSamplesDown (block);
+
+        for (int i = 0; i < maxBlockSize; ++i)
+            if (std::abs (impulse.getSample (0, i)) > threshold)
+                tail = offset + i + 1;
+
+        // Stop once a good stretch has gone by without anything above the threshold
+        if (offset + maxBlockSize - tail >= 4096)
+            break;
+    }
+
+    oversampler.reset();
+    return tail;
+}
+
+//==============================================================================
+template <typename SampleType>
+void OversamplingStage<SampleType>::process (dsp::AudioBlock<SampleType> block,
+                                             const DistortionParameters& start, const DistortionParameters& end,
+                                             Waveshaper& waveshaper, MultibandStage<SampleType>* multiband) noexcept
+{
+    auto numChannels = (int) block.getNumChannels();
+    auto numSamples  = (int) block.getNumSamples();
+    auto* oversampler = getActiveOversampler();
+
+    jassert (numChannels <= Waveshaper::maxChannels);
+    SampleType* channels[Waveshaper::maxChannels];
+
+    // ADAA at the higher rate puts the wet signal part of a host sample late. The bands
+    // mix in their dry signal at that rate, so there it's already lined up.
+    if (oversampler != nullptr)
+        setDryFraction (multiband == nullptr ? waveshaper.getDelayInSamples() / getFactor() : 0.0);
+
+    // Nothing of the distortion is heard, so all that's left is a (delayed) gain.
+    // Not with bands though, whose dry signal still has to go through the crossovers.
+    if (start.wet == 0.0f && end.wet == 0.0f && multiband == nullptr)
+    {
+        if (oversampler != nullptr)
+        {
+            delayDry (block);
+            filtersIdle = true;
+        }
+        else
+        {
+            // Still as late as the shaped signal would be
+            for (int channel = 0; channel < numChannels; ++channel)
+                channels[channel] = block.getChannelPointer ((size_t) channel);
+
+            waveshaper.delayUnshaped (channels, numChannels, numSamples);
+        }
+
+        for (int channel = 0; channel < numChannels; ++channel)
+            applyDryGain (block.getChannelPointer ((size_t) channel), numSamples, start, end);
+
+        return;
+    }
+
+    if (oversampler == nullptr)
+    {
+        for (int channel = 0; channel < numChannels; ++channel)
+            channels[channel] = block.getChannelPointer ((size_t) channel);
+
+        if (multiband != nullptr)
+            multiband->process (channels, numChannels, numSamples, 0, start, end);
+        else
+            waveshaper.process (channels, numChannels, numSamples, start, end);
+
+        return;
+    }
+
+    jassert (numChannels <= dryNumChannels && numSamples <= dryMaxSamples);
+
+    // The wet signal ramps in from zero, so starting the filters from a clean state is inaudible
+    if (filtersIdle)
+    {
+        oversampler->reset();
+        filtersIdle = false;
+    }
+
+    // Keep a copy of the input for the dry path and delay it by the filters' latency
+    auto dryBlock = dsp::AudioBlock<SampleType> (dryChannels, (size_t) numChannels, (size_t) numSamples);
+    dryBlock.copyFrom (block);
+    delayDry (dryBlock);
+
+    if (multiband != nullptr)
+    {
+        // The whole mix happens per band at the higher rate, the delayed copy above
+        // only keeps the delay line running for when the bands are switched off.
+        auto upsampled = oversampler->processSamplesUp (block);
+
+        for (int channel = 0; channel < numChannels; ++channel)
+            channels[channel] = upsampled.getChannelPointer ((size_t) channel);
+
+        multiband->process (channels, numChannels, (int) upsampled.getNumSamples(), factorIndex, start, end);
+        oversampler->processSamplesDown (block);
+        return;
+    }
+
+    // Only the wet part is shaped at the higher rate, the mix happens back at the host rate
+    auto wetStart = start, wetEnd = end;
+    wetStart.dry = wetEnd.dry = 0.0f;
+    wetStart.outputLvl = wetEnd.outputLvl = 1.0f;
+
+    auto upsampled = oversampler->processSamplesUp (block);
+
+    for (int channel = 0; channel < numChannels; ++channel)
+        channels[channel] = upsampled.getChannelPointer ((size_t) channel);
+
+    waveshaper.process (channels, numChannels, (int) upsampled.getNumSamples(), wetStart, wetEnd);
+
+    oversampler->processSamplesDown (block);
+
+    for (int channel = 0; channel < numChannels; ++channel)
+    {
+        auto* output = block.getChannelPointer ((size_t) channel);
+        auto* dry = dryBlock.getChannelPointer ((size_t) channel);
+
+        if (start == end)
+        {
+            FloatVectorOperations::addWithMultiply (output, dry, (SampleType) start.dry, numSamples);
+            FloatVectorOperations::multiply (output, (SampleType) start.outputLvl, numSamples);
+        }
+        else
+        {
+            auto step = (SampleType) 1 / (SampleType) numSamples;
+
+            for (int i = 0; i < numSamples; ++i)
+            {
+                auto alpha = (SampleType) (i + 1) * step;
+                auto dryGain = (SampleType) start.dry + alpha * (SampleType) (end.dry - start.dry);
+                auto outputLvl = (SampleType) start.outputLvl + alpha * (SampleType) (end.outputLvl - start.outputLvl);
+
+                output[i] = (output[i] + dryGain * dry[i]) * outputLvl;
+            }
+        }
+    }
+}
+
+template <typename SampleType>
+void OversamplingStage<SampleType>::processBypassed (dsp::AudioBlock<SampleType> block) noexcept
+{
+    // Without latency there is nothing to line up, so the input can stay where it is
+    if (getActiveOversampler() == nullptr)
+        return;
+
+    // Going through the same delay line as the dry path means that switching
+    // bypass on and off doesn't lose or repeat any audio.
+    delayDry (block);
+    filtersIdle = true;
+}
+
+template <typename SampleType>
+void OversamplingStage<SampleType>::delayDry (dsp::AudioBlock<SampleType> block) noexcept
+{
+    dryDelay.process (dsp::ProcessContextReplacing<SampleType> (block));
+}
+
+template <typename SampleType>
+void OversamplingStage<SampleType>::applyDryGain (SampleType* data, int numSamples,
+                                                  const DistortionParameters& start, const DistortionParameters& end) noexcept
+{
+    if (start == end)
+    {
+        auto gain = (SampleType) start.dry * (SampleType) start.outputLvl;
+
+        if (gain == (SampleType) 0)
+            FloatVectorOperations::clear (data, numSamples);
+        else if (gain != (SampleType) 1)
+            FloatVectorOperations::multiply (data, gain, numSamples);
+
+        return;
+    }
+
+    auto step = (SampleType) 1 / (SampleType) numSamples;
+
+    for (int i = 0; i < numSamples; ++i)
+    {
+        auto alpha = (SampleType) (i + 1) * step;
+        auto dryGain = (SampleType) start.dry + alpha * (SampleType) (end.dry - start.dry);
+        auto outputLvl = (SampleType) start.outputLvl + alpha * (SampleType) (end.outputLvl - start.outputLvl);
+
+        data[i] *= dryGain * outputLvl;
+    }
+}
+
+//==============================================================================
+template class OversamplingStage<float>;
+template class OversamplingStage<double>;
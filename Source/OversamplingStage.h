@@ -0,0 +1,116 @@
+/*
+  ==============================================================================
+
+    OversamplingStage.h
+
+    Runs the waveshaper at 2x, 4x or 8x the host sample rate to keep the tanh
+    and the hard clip from aliasing at high drive settings. All the filter
+    chains are built in prepare(), so switching factor or filter type while
+    playing never allocates. The dry signal is delayed by the same amount as
+    the oversampling filters so the dry/wet mix stays phase aligned, plus the
+    fraction of a host sample that ADAA puts the wet signal behind at the
+    higher rate. That fraction goes through the delay's third order Lagrange
+    interpolation, which keeps the group delay to within a hundredth of a
+    sample up to an eighth of the sample rate.
+
+    How long each chain rings is measured once per process and shared by all
+    instances through a SharedCache, since it only depends on the chain.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "Core/DistortionParameters.h"
+#include "AudioArena.h"
+#include "SharedCache.h"
+#include "Waveshaper.h"
+using namespace juce;
+
+template <typename SampleType> class MultibandStage;
+
+//==============================================================================
+/** The settings shared by the float and double versions of the stage. */
+struct OversamplingOptions
+{
+    enum class Filter
+    {
+        iirMinimumPhase,    // polyphase IIR half-band filters, low latency but not phase linear
+        firLinearPhase      // equiripple FIR half-band filters, linear phase but more latency
+    };
+
+    static constexpr int maxFactorIndex = 3;    // 2^3 = 8x
+
+    static constexpr int getMaxFactor() noexcept    { return 1 << maxFactorIndex; }
+};
+
+//==============================================================================
+template <typename SampleType>
+class OversamplingStage  : public OversamplingOptions
+{
+public:
+    OversamplingStage() = default;
+
+    /** Builds every filter chain and the dry delay. Call from prepareToPlay. */
+    void prepare (double sampleRate, int numChannels, int maxBlockSize);
+
+    /** Takes the dry copy's buffers for what prepare() was given, see AudioArena. */
+    void takeWorkingMemory (AudioArena& arena) noexcept;
+    void reset() noexcept;
+
+    /** Selects the oversampling factor (0 = off, 1 = 2x, 2 = 4x, 3 = 8x) and filter type.
+        Returns true if the latency changed as a result.
+    */
+    bool setMode (int factorIndex, Filter filter) noexcept;
+
+    int getFactor() const noexcept                  { return 1 << factorIndex; }
+    int getLatencyInSamples() const noexcept        { return latency; }
+
+    /** How long the output keeps ringing after the input has gone silent: the
+        latency plus the time the filters take to decay below -150 dB. Zero when
+        oversampling is off, since the waveshaper maps 0 to exactly 0.
+    */
+    int getTailLengthInSamples() const noexcept     { return tailLength; }
+
+    /** Distorts the block in place, including the dry/wet mix and output level.
+        With the wet level at zero the oversampling filters and the waveshaper are
+        skipped and the block just gets the (delayed) dry gain.
+
+        If multiband is given it takes the waveshaper's place. It's handed the dry
+        signal too, since the dry part of the mix has to go through its crossovers.
+    */
+    void process (dsp::AudioBlock<SampleType> block,
+                  const DistortionParameters& start, const DistortionParameters& end,
+                  Waveshaper& waveshaper, MultibandStage<SampleType>* multiband = nullptr) noexcept;
+
+    /** Delays the block by the current latency without distorting it, for host bypass. */
+    void processBypassed (dsp::AudioBlock<SampleType> block) noexcept;
+
+private:
+    dsp::Oversampling<SampleType>* getActiveOversampler() const noexcept;
+    void updateLatency() noexcept;
+    void delayDry (dsp::AudioBlock<SampleType> block) noexcept;
+    void setDryFraction (double newFraction) noexcept;
+
+    static int measureTail (dsp::Oversampling<SampleType>& oversampler, int numChannels, int maxBlockSize);
+    static void applyDryGain (SampleType* data, int numSamples,
+                              const DistortionParameters& start, const DistortionParameters& end) noexcept;
+
+    std::unique_ptr<dsp::Oversampling<SampleType>> oversamplers[2][maxFactorIndex];
+    // Keyed by sample size, filter type and factor index
+    using TailCache = SharedCache<std::tuple<int, int, int>, int>;
+    std::shared_ptr<const int> tailLengths[2][maxFactorIndex];
+    dsp::DelayLine<SampleType, dsp::DelayLineInterpolationTypes::Lagrange3rd> dryDelay;
+    double dryFraction = 0.0;   // on top of the latency, in host samples
+    SampleType* dryChannels[Waveshaper::maxChannels] = {};     // from the arena
+    int dryNumChannels = 0, dryMaxSamples = 0;
+
+    int factorIndex = 0;
+    Filter filterType = Filter::iirMinimumPhase;
+    int latency = 0, tailLength = 0;
+    bool isPrepared = false;
+    bool filtersIdle = false;   // the filters missed some input and need a reset before they're used again
+
+    JUCE_DECLARE_NON_COPYABLE (OversamplingStage)
+};
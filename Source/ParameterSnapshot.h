@@ -0,0 +1,100 @@
+/*
+  ==============================================================================
+
+    ParameterSnapshot.h
+
+    Reads the plugin's parameters once per block instead of once per sample.
+    The raw parameter handles are looked up a single time in the constructor,
+    every value is converted from dB/percent exactly once per block, and the
+    gains are only ramped while a parameter is actually moving. The ramps are
+    the core's (see Core/ParameterRamp.h).
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "Core/DistortionParameters.h"
+#include "Core/ParameterRamp.h"
+using namespace juce;
+
+//==============================================================================
+/**
+    Caches the std::atomic<float>* handles of the value tree state and keeps one
+    ramp per parameter.
+
+    Call update() once per block with the values from readTargets(). It gives back the values at
+    the start and at the end of the block - if they are equal nothing is moving
+    and the whole block can run with constants, otherwise the values should be
+    ramped linearly from start to end across the block (which is exactly what
+    the ramp would have produced sample by sample).
+*/
+class ParameterSnapshot
+{
+public:
+    explicit ParameterSnapshot (AudioProcessorValueTreeState& state)
+        : driveParam     (state.getRawParameterValue ("drive")),
+          outputLvlParam (state.getRawParameterValue ("outputLvl")),
+          wetParam       (state.getRawParameterValue ("wet")),
+          dryParam       (state.getRawParameterValue ("dry")),
+          thresholdParam (state.getRawParameterValue ("threshold"))
+    {
+        jassert (driveParam != nullptr && outputLvlParam != nullptr && wetParam != nullptr
+                  && dryParam != nullptr && thresholdParam != nullptr);
+    }
+
+    /** Sets the ramp length and jumps straight to targets - the values the first block
+        will head for, so it starts out there rather than gliding in from somewhere else.
+    */
+    void prepare (double sampleRate, const DistortionParameters& targets, double rampLengthSeconds = 0.05)
+    {
+        ramp.prepare (sampleRate, targets, rampLengthSeconds);
+    }
+
+    /** Heads for targets (usually what readTargets() returned at the top of the
+        block) and advances the ramps by numSamples.
+        Returns true if any value moves during this block.
+    */
+    bool update (int numSamples, const DistortionParameters& targets,
+                 DistortionParameters& start, DistortionParameters& end)
+    {
+        return ramp.update (numSamples, targets, start, end);
+    }
+
+    /** Converts the raw parameter values to linear gains without touching the ramps. */
+    DistortionParameters readTargets() const noexcept
+    {
+        return toGains (readPlainValues());
+    }
+
+    /** The raw parameter values as they are, in dB and percent. */
+    PlainParameters readPlainValues() const noexcept
+    {
+        PlainParameters p;
+
+        p.drive     = driveParam->load (std::memory_order_relaxed);
+        p.outputLvl = outputLvlParam->load (std::memory_order_relaxed);
+        p.wet       = wetParam->load (std::memory_order_relaxed);
+        p.dry       = dryParam->load (std::memory_order_relaxed);
+        p.threshold = thresholdParam->load (std::memory_order_relaxed);
+
+        return p;
+    }
+
+    static DistortionParameters toGains (const PlainParameters& plain) noexcept
+    {
+        return plain.toGains();
+    }
+
+private:
+    std::atomic<float>* driveParam;
+    std::atomic<float>* outputLvlParam;
+    std::atomic<float>* wetParam;
+    std::atomic<float>* dryParam;
+    std::atomic<float>* thresholdParam;
+
+    ParameterRamp ramp;
+
+    JUCE_DECLARE_NON_COPYABLE (ParameterSnapshot)
+};
@@ -0,0 +1,162 @@
+/*
+  ==============================================================================
+
+    PerformanceMonitor.cpp
+
+  ==============================================================================
+*/
+
+#include "PerformanceMonitor.h"
+
+#if HYPERBOLIC_ENABLE_INSTRUMENTATION
+
+//==============================================================================
+void PerformanceMonitor::prepare (double sampleRate, int samplesPerBlock) noexcept
+{
+    auto ticksPerSecond = (double) Time::getHighResolutionTicksPerSecond();
+    auto deadlineSeconds = jmax (1, samplesPerBlock) / jmax (1.0, sampleRate);
+
+    deadlineTicks = deadlineSeconds * ticksPerSecond;
+    microsPerTick = 1.0e6 / ticksPerSecond;
+    deadlineMicros.store (deadlineSeconds * 1.0e6, std::memory_order_relaxed);
+}
+
+void PerformanceMonitor::endBlock (int64 startTicks, int numSamples, const DistortionParameters& parameters,
+                                   int oversampling, int numBands) noexcept
+{
+    auto ticks = (double) (Time::getHighResolutionTicks() - startTicks);
+    auto load = (float) (ticks / deadlineTicks);
+
+    auto bin = jlimit (0, numBins - 1, (int) (load * (float) numBins / maxLoad));
+    histogram[(size_t) bin].fetch_add (1, std::memory_order_relaxed);
+    numBlocks.fetch_add (1, std::memory_order_relaxed);
+
+    if (load > 1.0f)
+        numMisses.fetch_add (1, std::memory_order_relaxed);
+
+    if (load > worstLoad.load (std::memory_order_relaxed))
+        worstLoad.store (load, std::memory_order_relaxed);
+
+    auto index = written.load (std::memory_order_relaxed);
+    auto& record = recorder[(size_t) (index % recorderSize)];
+    record.blockIndex = index;
+    record.micros = (float) (ticks * microsPerTick);
+    record.load = load;
+    record.numSamples = numSamples;
+    record.oversampling = oversampling;
+    record.numBands = numBands;
+    record.parameters = parameters;
+
+    written.store (index + 1, std::memory_order_release);
+}
+
+//==============================================================================
+float PerformanceMonitor::Summary::getPercentile (float share) const noexcept
+{
+    if (numBlocks == 0)
+        return 0.0f;
+
+    auto wanted = (uint64) std::ceil ((double) share * (double) numBlocks);
+    uint64 count = 0;
+
+    for (int bin = 0; bin < numBins; ++bin)
+    {
+        count += histogram[(size_t) bin];
+
+        if (count >= wanted)
+            return (float) (bin + 1) * maxLoad / (float) numBins;
+    }
+
+    return worstLoad;
+}
+
+PerformanceMonitor::Summary PerformanceMonitor::getSummary() const noexcept
+{
+    Summary summary;
+
+    for (int bin = 0; bin < numBins; ++bin)
+        summary.histogram[(size_t) bin] = histogram[(size_t) bin].load (std::memory_order_relaxed);
+
+    summary.numBlocks = numBlocks.load (std::memory_order_relaxed);
+    summary.numMisses = numMisses.load (std::memory_order_relaxed);
+    summary.worstLoad = worstLoad.load (std::memory_order_relaxed);
+    summary.deadlineMicros = deadlineMicros.load (std::memory_order_relaxed);
+    return summary;
+}
+
+std::vector<BlockRecord> PerformanceMonitor::getRecentBlocks() const
+{
+    auto end = written.load (std::memory_order_acquire);
+    auto begin = end > (uint64) recorderSize ? end - (uint64) recorderSize : 0;
+
+    std::vector<BlockRecord> blocks;
+    blocks.reserve ((size_t) (end - begin));
+
+    for (auto index = begin; index < end; ++index)
+        blocks.push_back (recorder[(size_t) (index % recorderSize)]);
+
+    // Anything the audio thread may have started overwriting while we copied is dropped
+    std::atomic_thread_fence (std::memory_order_acquire);
+    auto nowWritten = written.load (std::memory_order_relaxed);
+    auto firstIntact = nowWritten >= (uint64) recorderSize ? nowWritten - (uint64) recorderSize + 1 : 0;
+
+    if (firstIntact > begin)
+        blocks.erase (blocks.begin(), blocks.begin() + (ptrdiff_t) jmin ((uint64) blocks.size(), firstIntact - begin));
+
+    return blocks;
+}
+
+bool PerformanceMonitor::exportCsv (const File& file) const
+{
+    auto summary = getSummary();
+    auto blocks = getRecentBlocks();
+
+    FileOutputStream output (file);
+
+    if (! output.openedOk())
+        return false;
+
+    output.setPosition (0);
+    output.truncate();
+
+    output << "deadline_us,blocks,misses,worst_load,p50_load,p99_load\n"
+           << String (summary.deadlineMicros, 2) << "," << String ((int64) summary.numBlocks) << ","
+           << String ((int64) summary.numMisses) << "," << String (summary.worstLoad, 3) << ","
+           << String (summary.getPercentile (0.5f), 3) << "," << String (summary.getPercentile (0.99f), 3) << "\n\n";
+
+    output << "load_from,load_to,blocks\n";
+
+    for (int bin = 0; bin < numBins; ++bin)
+    {
+        auto from = (float) bin * maxLoad / (float) numBins;
+        auto to = bin == numBins - 1 ? String ("inf") : String ((float) (bin + 1) * maxLoad / (float) numBins, 2);
+        output << String (from, 2) << "," << to << "," << String ((int64) summary.histogram[(size_t) bin]) << "\n";
+    }
+
+    output << "\nblock,time_us,load,samples,oversampling,bands,drive_db,threshold_db,output_db,wet_percent,dry_percent\n";
+
+    for (auto& block : blocks)
+    {
+        auto& p = block.parameters;
+        output << String ((int64) block.blockIndex) << "," << String (block.micros, 2) << "," << String (block.load, 3) << ","
+               << block.numSamples << "," << block.oversampling << "," << block.numBands << ","
+               << String (Decibels::gainToDecibels (p.drive), 2) << "," << String (Decibels::gainToDecibels (p.threshold), 2) << ","
+               << String (Decibels::gainToDecibels (p.outputLvl), 2) << ","
+               << String (p.wet * 100.0f, 1) << "," << String (p.dry * 100.0f, 1) << "\n";
+    }
+
+    output.flush();
+    return output.getStatus().wasOk();
+}
+
+void PerformanceMonitor::reset() noexcept
+{
+    for (auto& bin : histogram)
+        bin.store (0, std::memory_order_relaxed);
+
+    numBlocks.store (0, std::memory_order_relaxed);
+    numMisses.store (0, std::memory_order_relaxed);
+    worstLoad.store (0.0f, std::memory_order_relaxed);
+}
+
+#endif
@@ -0,0 +1,111 @@
+/*
+  ==============================================================================
+
+    PerformanceMonitor.h
+
+    Optional timing of every processBlock call, to tell whether this plugin is
+    the one causing a host's dropouts. Each block's time goes into a histogram
+    (as a share of the block's deadline, samplesPerBlock / sampleRate from
+    prepareToPlay), blocks that take longer than that are counted as deadline
+    misses, and the last few hundred blocks are kept in a flight recorder
+    together with the settings they ran with.
+
+    The audio thread only does a couple of relaxed atomic adds and writes one
+    record per block, never locks and never waits. The editor reads all of it,
+    and it can be exported as CSV, from the message thread.
+
+    Everything here only exists when the plugin is built with
+    HYPERBOLIC_ENABLE_INSTRUMENTATION=1, and otherwise costs nothing at all.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#ifndef HYPERBOLIC_ENABLE_INSTRUMENTATION
+ #define HYPERBOLIC_ENABLE_INSTRUMENTATION 0
+#endif
+
+#if HYPERBOLIC_ENABLE_INSTRUMENTATION
+
+#include <JuceHeader.h>
+#include "Core/DistortionParameters.h"
+using namespace juce;
+
+//==============================================================================
+/** One processBlock call, as the flight recorder keeps it. */
+struct BlockRecord
+{
+    uint64 blockIndex = 0;
+    float micros = 0.0f;
+    float load = 0.0f;                  // time taken / deadline, above 1 is a miss
+    int numSamples = 0;
+    int oversampling = 1;               // factor
+    int numBands = 1;
+    DistortionParameters parameters;    // the targets the block ran with, linear gains
+};
+
+//==============================================================================
+class PerformanceMonitor
+{
+public:
+    static constexpr int numBins = 50;             // each 4% of the deadline wide...
+    static constexpr float maxLoad = 2.0f;         // ...up to twice the deadline, the last bin holds the rest
+    static constexpr int recorderSize = 512;
+
+    PerformanceMonitor() = default;
+
+    /** Sets the deadline. Everything measured so far is kept. */
+    void prepare (double sampleRate, int samplesPerBlock) noexcept;
+
+    /** Audio thread: call at the very start of processBlock and pass the result to endBlock(). */
+    static int64 beginBlock() noexcept          { return Time::getHighResolutionTicks(); }
+
+    /** Audio thread: call at the very end of processBlock. */
+    void endBlock (int64 startTicks, int numSamples, const DistortionParameters& parameters,
+                   int oversampling, int numBands) noexcept;
+
+    //==============================================================================
+    struct Summary
+    {
+        std::array<uint32, numBins> histogram {};
+        uint64 numBlocks = 0, numMisses = 0;
+        float worstLoad = 0.0f;
+        double deadlineMicros = 0.0;
+
+        /** The load (time / deadline) below which the given share of blocks fall, to bin precision. */
+        float getPercentile (float share) const noexcept;
+    };
+
+    /** Message thread: the histogram and counters as they are right now. */
+    Summary getSummary() const noexcept;
+
+    /** Message thread: copies out the most recent blocks, oldest first. */
+    std::vector<BlockRecord> getRecentBlocks() const;
+
+    /** Message thread: writes the summary and the flight recorder to a CSV file. */
+    bool exportCsv (const File& file) const;
+
+    /** Message thread: starts counting from zero again. */
+    void reset() noexcept;
+
+private:
+    std::array<std::atomic<uint32>, numBins> histogram {};
+    std::atomic<uint64> numBlocks { 0 }, numMisses { 0 };
+    std::atomic<float> worstLoad { 0.0f };
+    std::atomic<double> deadlineMicros { 0.0 };
+
+    // Single writer ring. The audio thread fills the slot at written % recorderSize and
+    // then publishes it by bumping written, readers throw away anything it has since
+    // overtaken.
+    std::array<BlockRecord, recorderSize> recorder;
+    std::atomic<uint64> written { 0 };
+
+    // Audio thread only
+    double deadlineTicks = 1.0;
+    double microsPerTick = 1.0;
+
+    JUCE_DECLARE_NON_COPYABLE (PerformanceMonitor)
+};
+
+#endif
@@ -0,0 +1,130 @@
+/*
+  ==============================================================================
+
+    PerformanceView.cpp
+
+  ==============================================================================
+*/
+
+#include "PerformanceView.h"
+
+#if HYPERBOLIC_ENABLE_INSTRUMENTATION
+
+namespace
+{
+    const Colour viewBackground (17, 25, 25);
+    const Colour viewFill (107, 142, 78);
+    const Colour viewMiss (200, 70, 50);
+    const Colour viewPale (213, 245, 223);
+}
+
+//==============================================================================
+PerformanceView::PerformanceView (PerformanceMonitor& monitorToShow)
+    : monitor (monitorToShow)
+{
+    setOpaque (true);
+
+    exportButton.onClick = [this] { exportCsv(); };
+    addAndMakeVisible (exportButton);
+
+    resetButton.onClick = [this]
+    {
+        monitor.reset();
+        timerCallback();
+    };
+    addAndMakeVisible (resetButton);
+
+    // A few times a second is plenty for statistics
+    startTimerHz (4);
+}
+
+PerformanceView::~PerformanceView()
+{
+    stopTimer();
+}
+
+void PerformanceView::timerCallback()
+{
+    auto newSummary = monitor.getSummary();
+
+    if (newSummary.numBlocks != summary.numBlocks || newSummary.deadlineMicros != summary.deadlineMicros)
+    {
+        summary = newSummary;
+        repaint();
+    }
+}
+
+//==============================================================================
+void PerformanceView::paint (Graphics& g)
+{
+    g.fillAll (viewBackground);
+
+    auto area = getLocalBounds().reduced (4);
+    area.removeFromRight (exportButton.getWidth() + 4);
+
+    auto text = area.removeFromBottom (16);
+    auto bars = area.toFloat();
+
+    uint32 tallest = 1;
+
+    for (auto count : summary.histogram)
+        tallest = jmax (tallest, count);
+
+    // Bins past the middle are blocks that missed their deadline
+    auto binWidth = bars.getWidth() / (float) PerformanceMonitor::numBins;
+
+    for (int bin = 0; bin < PerformanceMonitor::numBins; ++bin)
+    {
+        auto count = summary.histogram[(size_t) bin];
+
+        if (count == 0)
+            continue;
+
+        // Square root, so a handful of slow blocks still shows next to thousands of quick ones
+        auto height = std::sqrt ((float) count / (float) tallest) * bars.getHeight();
+        g.setColour (bin >= PerformanceMonitor::numBins / 2 ? viewMiss : viewFill);
+        g.fillRect (bars.getX() + (float) bin * binWidth, bars.getBottom() - height, jmax (1.0f, binWidth - 1.0f), height);
+    }
+
+    g.setColour (viewPale.withAlpha (0.5f));
+    g.drawVerticalLine (roundToInt (bars.getCentreX()), bars.getY(), bars.getBottom());
+
+    g.setColour (viewPale);
+    g.setFont (FontOptions (12.0f));
+    g.drawText ("Blocks " + String ((int64) summary.numBlocks)
+                  + "   Misses " + String ((int64) summary.numMisses)
+                  + "   p50 " + String (roundToInt (summary.getPercentile (0.5f) * 100.0f)) + "%"
+                  + "   p99 " + String (roundToInt (summary.getPercentile (0.99f) * 100.0f)) + "%"
+                  + "   Worst " + String (roundToInt (summary.worstLoad * 100.0f)) + "%"
+                  + "   of " + String (summary.deadlineMicros, 0) + " us",
+                text, Justification::centredLeft);
+}
+
+void PerformanceView::resized()
+{
+    auto buttons = getLocalBounds().reduced (4).removeFromRight (60);
+    exportButton.setBounds (buttons.removeFromTop (buttons.getHeight() / 2).reduced (0, 2));
+    resetButton.setBounds (buttons.reduced (0, 2));
+}
+
+void PerformanceView::exportCsv()
+{
+    chooser = std::make_unique<FileChooser> ("Export Performance Data",
+                                             File::getSpecialLocation (File::userDocumentsDirectory)
+                                                 .getChildFile ("Hyperbolic Distortion Performance.csv"),
+                                             "*.csv");
+
+    auto flags = FileBrowserComponent::saveMode | FileBrowserComponent::canSelectFiles
+                   | FileBrowserComponent::warnAboutOverwriting;
+
+    chooser->launchAsync (flags, [this] (const FileChooser& fc)
+    {
+        auto file = fc.getResult();
+
+        if (file != File() && ! monitor.exportCsv (file))
+            AlertWindow::showMessageBoxAsync (MessageBoxIconType::WarningIcon, "Export Performance Data",
+                                              "Couldn't write " + file.getFullPathName());
+    });
+}
+
+#endif
@@ -0,0 +1,45 @@
+/*
+  ==============================================================================
+
+    PerformanceView.h
+
+    Shows what PerformanceMonitor has measured: the histogram of block times
+    against the deadline, the miss count and a few percentiles, with buttons
+    to export the data as CSV and to start counting again. Only built with
+    HYPERBOLIC_ENABLE_INSTRUMENTATION=1.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "PerformanceMonitor.h"
+
+#if HYPERBOLIC_ENABLE_INSTRUMENTATION
+
+//==============================================================================
+class PerformanceView  : public Component,
+                         private Timer
+{
+public:
+    explicit PerformanceView (PerformanceMonitor& monitorToShow);
+    ~PerformanceView() override;
+
+    void paint (Graphics&) override;
+    void resized() override;
+
+private:
+    void timerCallback() override;
+    void exportCsv();
+
+    PerformanceMonitor& monitor;
+    PerformanceMonitor::Summary summary;
+
+    TextButton exportButton { "Export" };
+    TextButton resetButton { "Reset" };
+    std::unique_ptr<FileChooser> chooser;
+
+    JUCE_DECLARE_NON_COPYABLE (PerformanceView)
+};
+
+#endif
@@ -1,191 +1,433 @@
-/*
-  ==============================================================================
-
-    This file contains the basic framework code for a JUCE plugin editor.
-
-  ==============================================================================
-*/
-
-#include "PluginProcessor.h"
-#include "PluginEditor.h"
-
-using namespace juce;
-
-//==============================================================================
-DistortionEffectProjectAudioProcessorEditor::DistortionEffectProjectAudioProcessorEditor (DistortionEffectProjectAudioProcessor& p)
-    : AudioProcessorEditor (&p), audioProcessor (p)
-{
-    static Typeface::Ptr customChalkDusterFont = Typeface::createSystemTypefaceFor(BinaryData::Chalkduster_ttf, BinaryData::Chalkduster_ttfSize);
-    chalkDuster = FontOptions(customChalkDusterFont);
-    float sliderNameSize = 16.0f;
-    float titleSize = 30.0f;
-    
-    // Make sure that before the constructor has finished, you've set the
-    // editor's size to whatever you need it to be.
-    setSize (500, 400);
-    driveSlider.setSliderStyle(Slider::RotaryHorizontalVerticalDrag);
-    driveSlider.setTextBoxStyle(Slider::TextBoxAbove, false, 60, 15);
-    driveSlider.setRange(0.0, 30.0, 0.1);
-    driveSlider.setTextValueSuffix(" dB");
-//    driveSlider.setValue(0.0);
-    driveSlider.addListener(this);
-    driveSlider.setLookAndFeel(&greenTheme);
-    addAndMakeVisible(driveSlider);
-    
-    driveAttach = std::make_unique<AudioProcessorValueTreeState::SliderAttachment>(audioProcessor.treeState, "drive", driveSlider);
-    
-    driveLabel.setText("Drive", dontSendNotification);
-    driveLabel.setFont(FontOptions(chalkDuster.withHeight(sliderNameSize)));
-    driveLabel.setJustificationType(Justification::centred);
-    addAndMakeVisible(driveLabel);
-    
-    outputLvlSlider.setSliderStyle(Slider::RotaryHorizontalVerticalDrag);
-    outputLvlSlider.setTextBoxStyle(Slider::TextBoxAbove, false, 60, 15);
-    outputLvlSlider.setTextValueSuffix(" dB");
-    outputLvlSlider.setRange(-12.0, 12.0, 0.1);
-//    outputLvlSlider.setValue(0.0);
-    outputLvlSlider.setSkewFactorFromMidPoint(0.0);
-    outputLvlSlider.addListener(this);
-    outputLvlSlider.setLookAndFeel(&greenTheme);
-    addAndMakeVisible(outputLvlSlider);
-    
-    outputLvlAttach = std::make_unique<AudioProcessorValueTreeState::SliderAttachment>(audioProcessor.treeState, "outputLvl", outputLvlSlider);
-    
-    outputLvlLabel.setText("Output Lvl", dontSendNotification);
-    outputLvlLabel.setFont(FontOptions(chalkDuster.withHeight(sliderNameSize)));
-    outputLvlLabel.setJustificationType(Justification::centred);
-    addAndMakeVisible(outputLvlLabel);
-    
-    wetSlider.setSliderStyle(Slider::RotaryHorizontalVerticalDrag);
-    wetSlider.setTextBoxStyle(Slider::TextBoxAbove, false, 60, 15);
-    wetSlider.setRange(0.0, 100.0, 1);
-//    wetSlider.setValue(50);
-    wetSlider.setTextValueSuffix("%");
-    wetSlider.addListener(this);
-    wetSlider.setLookAndFeel(&greenTheme);
-    addAndMakeVisible(wetSlider);
-    
-    wetAttach = std::make_unique<AudioProcessorValueTreeState::SliderAttachment>(audioProcessor.treeState, "wet", wetSlider);
-    
-    wetLabel.setText("Wet Mix", dontSendNotification);
-    wetLabel.setFont(FontOptions(chalkDuster.withHeight(sliderNameSize)));
-    wetLabel.setJustificationType(Justification::centred);
-    addAndMakeVisible(wetLabel);
-    
-    drySlider.setSliderStyle(Slider::RotaryHorizontalVerticalDrag);
-    drySlider.setTextBoxStyle(Slider::TextBoxAbove, false, 60, 15);
-    drySlider.setRange(0.0, 100.0, 1);
-//    drySlider.setValue(50);
-    drySlider.setTextValueSuffix("%");
-    drySlider.addListener(this);
-    drySlider.setLookAndFeel(&greenTheme);
-    addAndMakeVisible(drySlider);
-    
-    dryAttach = std::make_unique<AudioProcessorValueTreeState::SliderAttachment>(audioProcessor.treeState, "dry", drySlider);
-    
-    dryLabel.setText("Dry Mix", dontSendNotification);
-    dryLabel.setFont(FontOptions(chalkDuster.withHeight(sliderNameSize)));
-    dryLabel.setJustificationType(Justification::centred);
-    addAndMakeVisible(dryLabel);
-    
-    thresholdSlider.setSliderStyle(Slider::LinearVertical);
-    thresholdSlider.setTextBoxStyle(Slider::TextBoxAbove, false, 60, 15);
-    thresholdSlider.setRange(-20.0, 3.0, 0.1);
-//    thresholdSlider.setValue(0.0);
-    thresholdSlider.setSkewFactorFromMidPoint(-5.0);
-    thresholdSlider.setTextValueSuffix("dB");
-    thresholdSlider.addListener(this);
-    thresholdSlider.setLookAndFeel(&greenTheme);
-    addAndMakeVisible(thresholdSlider);
-    
-    thresholdAttach = std::make_unique<AudioProcessorValueTreeState::SliderAttachment>(audioProcessor.treeState, "threshold", thresholdSlider);
-    
-    thresholdLabel.setText("Threshold", dontSendNotification);
-    thresholdLabel.setFont(FontOptions(chalkDuster.withHeight(sliderNameSize)));
-    thresholdLabel.setJustificationType(Justification::centred);
-    addAndMakeVisible(thresholdLabel);
-    
-    pluginTitleShadow.setText("Hyperbolic Distortion", dontSendNotification);
-    pluginTitleShadow.setFont(FontOptions(chalkDuster.withHeight(titleSize)));
-    pluginTitleShadow.setColour(Label::textColourId, Colour(40, 79, 35));
-    pluginTitleShadow.setJustificationType(Justification::centred);
-    addAndMakeVisible(pluginTitleShadow);
-    
-    pluginTitle.setText("Hyperbolic Distortion", dontSendNotification);
-    pluginTitle.setFont(FontOptions(chalkDuster.withHeight(titleSize)));
-    pluginTitle.setColour(Label::textColourId, Colour(76, 187, 23));
-    pluginTitle.setJustificationType(Justification::centred);
-    addAndMakeVisible(pluginTitle);
-}
-
-DistortionEffectProjectAudioProcessorEditor::~DistortionEffectProjectAudioProcessorEditor()
-{
-    driveAttach.reset();
-    outputLvlAttach.reset();
-    wetAttach.reset();
-    dryAttach.reset();
-    thresholdAttach.reset();
-}
-
-//==============================================================================
-void DistortionEffectProjectAudioProcessorEditor::paint (juce::Graphics& g)
-{
-    int rectWidth = 30;
-    g.fillAll(Colour(27, 39, 39));
-    Rectangle <float> threshZeroMarker(getWidth()/2 - rectWidth/2, 192, rectWidth, 3);
-    g.setColour(Colour(17, 25, 25));
-    g.drawRect(threshZeroMarker);
-    g.fillRect(threshZeroMarker);
-}
-
-void DistortionEffectProjectAudioProcessorEditor::resized()
-{
-    
-    driveSlider.setBounds(borderX, borderTop, sliderSize, sliderSize);
-    driveLabel.setBounds(driveSlider.getX(),
-                         driveSlider.getY() + driveSlider.getHeight()/2,
-                         sliderSize, driveLabel.getFont().getHeight());
-    
-    outputLvlSlider.setBounds(getWidth() - borderX - sliderSize, borderTop, sliderSize, sliderSize);
-    outputLvlLabel.setBounds(outputLvlSlider.getX(),
-                             outputLvlSlider.getY() + outputLvlSlider.getHeight()/2,
-                             sliderSize, outputLvlLabel.getFont().getHeight());
-    
-    wetSlider.setBounds(borderX, getHeight() - borderBottom - sliderSize, sliderSize, sliderSize);
-    wetLabel.setBounds(wetSlider.getX(),
-                        wetSlider.getY() + wetSlider.getHeight()/2,
-                        sliderSize, wetLabel.getFont().getHeight());
-    
-    drySlider.setBounds(getWidth() - borderX - sliderSize, getHeight() - borderBottom - sliderSize, sliderSize, sliderSize);
-    dryLabel.setBounds(drySlider.getX(),
-                        drySlider.getY() + drySlider.getHeight()/2,
-                        sliderSize, dryLabel.getFont().getHeight());
-    
-    thresholdSlider.setBounds(getWidth()/2 - threshSliderXBound/2, driveSlider.getY() + driveSlider.getHeight()/2, threshSliderXBound, getHeight()/2);
-    thresholdLabel.setBounds(thresholdSlider.getX(),
-                             thresholdSlider.getY() + thresholdSlider.getHeight(),
-                             threshSliderXBound, thresholdLabel.getFont().getHeight());
-
-    pluginTitleShadow.setBounds(2, 2, getWidth(), borderTop - 7);
-    pluginTitle.setBounds(0, 0, getWidth(), borderTop - 5);
-}
-
-void DistortionEffectProjectAudioProcessorEditor::sliderValueChanged(Slider *slider)
-{
-
-// Since I added parameter function, we don't need to update these variables in the process block this way  anymore
-    
-//    if(slider == &driveSlider){
-//        //          dB = 20log(amp)
-//        //  =>     amp = 10^(dB/20)
-//        audioProcessor.drive = pow(10, driveSlider.getValue()/20);
-//    } else if(slider == &outputLvlSlider){
-//        audioProcessor.outputLvl = pow(10, outputLvlSlider.getValue()/20);
-//    }else if(slider == &wetSlider){
-//        audioProcessor.wet = wetSlider.getValue() / 100;
-//    } else if(slider == &drySlider){
-//        audioProcessor.dry = drySlider.getValue() / 100;
-//    } else if(slider == &thresholdSlider){
-//        audioProcessor.threshold = pow(10, thresholdSlider.getValue()/20);
-//    }
-}
+/*
+  ==============================================================================
+
+    This file contains the basic framework code for a JUCE plugin editor.
+
+  ==============================================================================
+*/
+
+#include "PluginProcessor.h"
+#include "PluginEditor.h"
+
+using namespace juce;
+
+//==============================================================================
+DistortionEffectProjectAudioProcessorEditor::DistortionEffectProjectAudioProcessorEditor (DistortionEffectProjectAudioProcessor& p)
+    : AudioProcessorEditor (&p), audioProcessor (p)
+{
+    // Set once here, every slider picks it up from its parent
+    setLookAndFeel(&assets->getTheme());
+    setOpaque(true);
+    
+    // Make sure that before the constructor has finished, you've set the
+    // editor's size to whatever you need it to be.
+    setSize (500, knobAreaHeight + presetBarHeight + meterAreaHeight + performanceAreaHeight);
+    driveSlider.setSliderStyle(Slider::RotaryHorizontalVerticalDrag);
+    driveSlider.setTextBoxStyle(Slider::TextBoxAbove, false, 60, 15);
+    driveSlider.setRange(0.0, 30.0, 0.1);
+    driveSlider.setTextValueSuffix(" dB");
+//    driveSlider.setValue(0.0);
+    driveSlider.addListener(this);
+    addAndMakeVisible(driveSlider);
+    
+    driveAttach = std::make_unique<AudioProcessorValueTreeState::SliderAttachment>(audioProcessor.treeState, "drive", driveSlider);
+    
+    outputLvlSlider.setSliderStyle(Slider::RotaryHorizontalVerticalDrag);
+    outputLvlSlider.setTextBoxStyle(Slider::TextBoxAbove, false, 60, 15);
+    outputLvlSlider.setTextValueSuffix(" dB");
+    outputLvlSlider.setRange(-12.0, 12.0, 0.1);
+//    outputLvlSlider.setValue(0.0);
+    outputLvlSlider.setSkewFactorFromMidPoint(0.0);
+    outputLvlSlider.addListener(this);
+    addAndMakeVisible(outputLvlSlider);
+    
+    outputLvlAttach = std::make_unique<AudioProcessorValueTreeState::SliderAttachment>(audioProcessor.treeState, "outputLvl", outputLvlSlider);
+    
+    wetSlider.setSliderStyle(Slider::RotaryHorizontalVerticalDrag);
+    wetSlider.setTextBoxStyle(Slider::TextBoxAbove, false, 60, 15);
+    wetSlider.setRange(0.0, 100.0, 1);
+//    wetSlider.setValue(50);
+    wetSlider.setTextValueSuffix("%");
+    wetSlider.addListener(this);
+    addAndMakeVisible(wetSlider);
+    
+    wetAttach = std::make_unique<AudioProcessorValueTreeState::SliderAttachment>(audioProcessor.treeState, "wet", wetSlider);
+    
+    drySlider.setSliderStyle(Slider::RotaryHorizontalVerticalDrag);
+    drySlider.setTextBoxStyle(Slider::TextBoxAbove, false, 60, 15);
+    drySlider.setRange(0.0, 100.0, 1);
+//    drySlider.setValue(50);
+    drySlider.setTextValueSuffix("%");
+    drySlider.addListener(this);
+    addAndMakeVisible(drySlider);
+    
+    dryAttach = std::make_unique<AudioProcessorValueTreeState::SliderAttachment>(audioProcessor.treeState, "dry", drySlider);
+    
+    thresholdSlider.setSliderStyle(Slider::LinearVertical);
+    thresholdSlider.setTextBoxStyle(Slider::TextBoxAbove, false, 60, 15);
+    thresholdSlider.setRange(-20.0, 3.0, 0.1);
+//    thresholdSlider.setValue(0.0);
+    thresholdSlider.setSkewFactorFromMidPoint(-5.0);
+    thresholdSlider.setTextValueSuffix("dB");
+    thresholdSlider.addListener(this);
+    addAndMakeVisible(thresholdSlider);
+    
+    thresholdAttach = std::make_unique<AudioProcessorValueTreeState::SliderAttachment>(audioProcessor.treeState, "threshold", thresholdSlider);
+    
+    presetBox.setTextWhenNothingSelected("Presets");
+    presetBox.onChange = [this]
+    {
+        auto index = presetBox.getSelectedId() - 1;
+        
+        if (index >= 0 && index != audioProcessor.getCurrentProgram())
+        {
+            audioProcessor.setCurrentProgram(index);
+            audioProcessor.updateHostDisplay(AudioProcessorListener::ChangeDetails().withProgramChanged(true));
+        }
+    };
+    addAndMakeVisible(presetBox);
+    refreshPresetList();
+    
+    saveButton.onClick = [this] { savePreset(); };
+    addAndMakeVisible(saveButton);
+    
+    // Whatever the knobs are set to right now becomes the B end of the morph
+    storeBButton.onClick = [this] { audioProcessor.storeMorphTarget(); };
+    addAndMakeVisible(storeBButton);
+    
+    morphSlider.setSliderStyle(Slider::LinearHorizontal);
+    morphSlider.setTextBoxStyle(Slider::NoTextBox, false, 0, 0);
+    morphSlider.setRange(0.0, 100.0, 0.1);
+    addAndMakeVisible(morphSlider);
+    
+    morphAttach = std::make_unique<AudioProcessorValueTreeState::SliderAttachment>(audioProcessor.treeState, "morph", morphSlider);
+    
+    cabinetButton.onClick = [this] { showCabinetMenu(); };
+    addAndMakeVisible(cabinetButton);
+    
+    limiterButton.onClick = [this] { showLimiterMenu(); };
+    addAndMakeVisible(limiterButton);
+    
+    addAndMakeVisible(inputMeter);
+    addAndMakeVisible(outputMeter);
+    addAndMakeVisible(reductionMeter);
+    addAndMakeVisible(transferCurve);
+    addAndMakeVisible(waveform);
+    
+    clipLabel.setText("Clips: 0", dontSendNotification);
+    clipLabel.setFont(assets->getFont(sliderNameSize - 2.0f));
+    clipLabel.setColour(Label::textColourId, Colour(213, 245, 223));
+    clipLabel.setJustificationType(Justification::centredLeft);
+    addAndMakeVisible(clipLabel);
+    
+    qualityLabel.setFont(assets->getFont(sliderNameSize - 2.0f));
+    qualityLabel.setColour(Label::textColourId, Colour(213, 245, 223));
+    qualityLabel.setJustificationType(Justification::centredRight);
+    addAndMakeVisible(qualityLabel);
+    
+   #if HYPERBOLIC_ENABLE_INSTRUMENTATION
+    addAndMakeVisible(performanceView);
+   #endif
+    
+    // The processor only measures levels while an editor is looking at them
+    audioProcessor.getMeterSource().setEnabled(true);
+    startTimerHz(30);
+}
+
+DistortionEffectProjectAudioProcessorEditor::~DistortionEffectProjectAudioProcessorEditor()
+{
+    stopTimer();
+    audioProcessor.getMeterSource().setEnabled(false);
+    setLookAndFeel(nullptr);
+    
+    driveAttach.reset();
+    outputLvlAttach.reset();
+    wetAttach.reset();
+    dryAttach.reset();
+    thresholdAttach.reset();
+    morphAttach.reset();
+}
+
+//==============================================================================
+void DistortionEffectProjectAudioProcessorEditor::paint (juce::Graphics& g)
+{
+    // Everything that never changes is one cached image, so when a slider moves
+    // this only has to copy the small patch of it behind that slider.
+    auto scale = g.getInternalContext().getPhysicalPixelScaleFactor();
+    
+    if (background.isNull() || scale != backgroundScale)
+    {
+        background = assets->getBackground(getWidth(), getHeight(), scale, [this] (Graphics& bg) { paintBackground(bg); });
+        backgroundScale = scale;
+    }
+    
+    g.drawImage(background, getLocalBounds().toFloat());
+}
+
+void DistortionEffectProjectAudioProcessorEditor::paintBackground (Graphics& g)
+{
+    int rectWidth = 30;
+    g.fillAll(Colour(27, 39, 39));
+    Rectangle <float> threshZeroMarker(getWidth()/2 - rectWidth/2, 192, rectWidth, 3);
+    g.setColour(Colour(17, 25, 25));
+    g.drawRect(threshZeroMarker);
+    g.fillRect(threshZeroMarker);
+    
+    auto nameHeight = (int) sliderNameSize;
+    auto drawName = [&] (const String& name, const Slider& slider, int y, int width)
+    {
+        g.drawText(name, slider.getX(), y, width, nameHeight, Justification::centred);
+    };
+    
+    g.setFont(assets->getFont(sliderNameSize));
+    g.setColour(findColour(Label::textColourId));
+    drawName("Drive", driveSlider, driveSlider.getY() + driveSlider.getHeight()/2, sliderSize);
+    drawName("Output Lvl", outputLvlSlider, outputLvlSlider.getY() + outputLvlSlider.getHeight()/2, sliderSize);
+    drawName("Wet Mix", wetSlider, wetSlider.getY() + wetSlider.getHeight()/2, sliderSize);
+    drawName("Dry Mix", drySlider, drySlider.getY() + drySlider.getHeight()/2, sliderSize);
+    drawName("Threshold", thresholdSlider, thresholdSlider.getBottom(), threshSliderXBound);
+    
+    // The two ends of the morph slider
+    g.setFont(assets->getFont(sliderNameSize - 2.0f));
+    g.drawText("A", morphSlider.getX() - 14, morphSlider.getY(), 12, morphSlider.getHeight(), Justification::centredRight);
+    g.drawText("B", morphSlider.getRight() + 2, morphSlider.getY(), 12, morphSlider.getHeight(), Justification::centredLeft);
+    
+    g.setFont(assets->getFont(titleSize));
+    g.setColour(Colour(40, 79, 35));
+    g.drawText("Hyperbolic Distortion", 2, 2, getWidth(), borderTop - 7, Justification::centred);
+    g.setColour(Colour(76, 187, 23));
+    g.drawText("Hyperbolic Distortion", 0, 0, getWidth(), borderTop - 5, Justification::centred);
+}
+
+void DistortionEffectProjectAudioProcessorEditor::resized()
+{
+    background = {};
+    
+    driveSlider.setBounds(borderX, borderTop, sliderSize, sliderSize);
+    outputLvlSlider.setBounds(getWidth() - borderX - sliderSize, borderTop, sliderSize, sliderSize);
+    wetSlider.setBounds(borderX, knobAreaHeight - borderBottom - sliderSize, sliderSize, sliderSize);
+    drySlider.setBounds(getWidth() - borderX - sliderSize, knobAreaHeight - borderBottom - sliderSize, sliderSize, sliderSize);
+    thresholdSlider.setBounds(getWidth()/2 - threshSliderXBound/2, driveSlider.getY() + driveSlider.getHeight()/2, threshSliderXBound, knobAreaHeight/2);
+    
+    auto presetBar = Rectangle<int>(0, knobAreaHeight, getWidth(), presetBarHeight).reduced(10, 3);
+    presetBox.setBounds(presetBar.removeFromLeft(170));
+    presetBar.removeFromLeft(4);
+    saveButton.setBounds(presetBar.removeFromLeft(50));
+    presetBar.removeFromLeft(4);
+    cabinetButton.setBounds(presetBar.removeFromLeft(40));
+    presetBar.removeFromLeft(4);
+    limiterButton.setBounds(presetBar.removeFromLeft(40));
+    storeBButton.setBounds(presetBar.removeFromRight(50));
+    presetBar.removeFromRight(18);
+    presetBar.removeFromLeft(18);
+    morphSlider.setBounds(presetBar);
+    
+    auto meterArea = Rectangle<int>(0, knobAreaHeight + presetBarHeight, getWidth(), meterAreaHeight).reduced(10);
+    inputMeter.setBounds(meterArea.removeFromLeft(12));
+    meterArea.removeFromLeft(4);
+    outputMeter.setBounds(meterArea.removeFromLeft(12));
+    meterArea.removeFromLeft(4);
+    reductionMeter.setBounds(meterArea.removeFromLeft(12));
+    meterArea.removeFromLeft(10);
+    transferCurve.setBounds(meterArea.removeFromLeft(meterArea.getHeight()));
+    meterArea.removeFromLeft(10);
+    auto labelRow = meterArea.removeFromBottom(18);
+    qualityLabel.setBounds(labelRow.removeFromRight(labelRow.getWidth() / 2));
+    clipLabel.setBounds(labelRow);
+    waveform.setBounds(meterArea);
+    
+   #if HYPERBOLIC_ENABLE_INSTRUMENTATION
+    performanceView.setBounds(Rectangle<int>(0, knobAreaHeight + presetBarHeight + meterAreaHeight, getWidth(), performanceAreaHeight).reduced(10, 0).withTrimmedBottom(10));
+   #endif
+}
+
+void DistortionEffectProjectAudioProcessorEditor::timerCallback()
+{
+    float inputPeak = 0.0f, inputRms = 0.0f;
+    float outputPeak = 0.0f, outputRms = 0.0f;
+    float reduction = 0.0f;
+    int clips = 0;
+    
+    audioProcessor.getMeterSource().readFrames([&] (const MeterFrame& frame)
+    {
+        inputPeak = jmax(inputPeak, frame.inputPeak);
+        inputRms = jmax(inputRms, frame.inputRms);
+        outputPeak = jmax(outputPeak, frame.outputPeak);
+        outputRms = jmax(outputRms, frame.outputRms);
+        reduction = jmax(reduction, frame.gainReductionDb);
+        clips += frame.clippedSamples;
+        waveform.pushColumn(frame.outputMin, frame.outputMax);
+    });
+    
+    // The meters jump up straight away and fall back at 20 dB per second
+    const float fall = 20.0f / 30.0f;
+    auto ballistics = [fall] (float shown, float gain) { return jmax(Decibels::gainToDecibels(gain, -100.0f), shown - fall); };
+    
+    inputPeakDb = ballistics(inputPeakDb, inputPeak);
+    inputRmsDb = ballistics(inputRmsDb, inputRms);
+    outputPeakDb = ballistics(outputPeakDb, outputPeak);
+    outputRmsDb = ballistics(outputRmsDb, outputRms);
+    reductionDb = jmax(reduction, reductionDb - fall);
+    
+    // Every one of these only repaints if what it shows has visibly changed
+    inputMeter.setLevels(inputPeakDb, inputRmsDb);
+    outputMeter.setLevels(outputPeakDb, outputRmsDb);
+    reductionMeter.setLevels(reductionDb, reductionDb);
+    waveform.refresh();
+    transferCurve.setParameters(audioProcessor.getCurrentParameters());
+    transferCurve.setInputPeak(inputPeak);
+    
+    if (clips > 0)
+    {
+        totalClips += clips;
+        clipLabel.setText("Clips: " + String(totalClips), dontSendNotification);
+    }
+    
+    // Only while Auto Quality has stepped down, or is rendering offline
+    auto tier = audioProcessor.getQualityTier();
+    
+    if (tier != shownQualityTier)
+    {
+        qualityLabel.setText(tier != QualityGovernor::full ? "Quality: " + DistortionEffectProjectAudioProcessor::getQualityTierName(tier) : String(), dontSendNotification);
+        shownQualityTier = tier;
+    }
+    
+    // The host can switch programs too
+    if (audioProcessor.getCurrentProgram() != shownProgram)
+        refreshPresetList();
+}
+
+void DistortionEffectProjectAudioProcessorEditor::refreshPresetList()
+{
+    auto& bank = audioProcessor.getPresetBank();
+    auto numPrograms = bank.getNumPresets();
+    
+    // Only rebuilt when a preset has been added, switching just moves the tick
+    if (numPrograms != shownNumPrograms)
+    {
+        presetBox.clear(dontSendNotification);
+        
+        for (int i = 0; i < numPrograms; ++i)
+        {
+            if (i == bank.getNumFactoryPresets() && i > 0)
+                presetBox.addSeparator();
+            
+            auto name = bank.getName(i);
+            presetBox.addItem(name.isNotEmpty() ? name : "Preset " + String(i + 1), i + 1);
+        }
+        
+        shownNumPrograms = numPrograms;
+    }
+    
+    shownProgram = audioProcessor.getCurrentProgram();
+    presetBox.setSelectedId(shownProgram + 1, dontSendNotification);
+}
+
+void DistortionEffectProjectAudioProcessorEditor::savePreset()
+{
+    auto* window = new AlertWindow("Save Preset", "Name:", MessageBoxIconType::NoIcon, this);
+    window->addTextEditor("name", "User Preset " + String(shownNumPrograms - PresetBank::getNumFactoryPresets() + 1));
+    window->addButton("Save", 1, KeyPress(KeyPress::returnKey));
+    window->addButton("Cancel", 0, KeyPress(KeyPress::escapeKey));
+    
+    Component::SafePointer<DistortionEffectProjectAudioProcessorEditor> editor(this);
+    
+    window->enterModalState(true, ModalCallbackFunction::create([editor, window] (int result)
+    {
+        if (result == 0 || editor == nullptr)
+            return;
+        
+        auto name = window->getTextEditorContents("name");
+        
+        if (editor->audioProcessor.saveUserPreset(name.isNotEmpty() ? name : String("User Preset")) >= 0)
+            editor->refreshPresetList();
+    }), true);
+}
+
+void DistortionEffectProjectAudioProcessorEditor::showCabinetMenu()
+{
+    auto file = audioProcessor.getCabinetFile();
+    auto hasFile = file != File();
+    auto* parameter = audioProcessor.treeState.getParameter("cabinet");
+    auto isOn = parameter->getValue() >= 0.5f;
+    
+    Component::SafePointer<DistortionEffectProjectAudioProcessorEditor> editor(this);
+    
+    PopupMenu menu;
+    menu.addSectionHeader(hasFile ? file.getFileNameWithoutExtension() : String("No Cabinet"));
+    menu.addItem("Load Impulse Response...", [editor]
+    {
+        if (editor != nullptr)
+            editor->chooseCabinetFile();
+    });
+    menu.addItem("On", hasFile, isOn, [parameter, isOn] { parameter->setValueNotifyingHost(isOn ? 0.0f : 1.0f); });
+    menu.addItem("Remove", hasFile, false, [editor]
+    {
+        if (editor != nullptr)
+            editor->audioProcessor.clearCabinet();
+    });
+    
+    menu.showMenuAsync(PopupMenu::Options().withTargetComponent(&cabinetButton));
+}
+
+void DistortionEffectProjectAudioProcessorEditor::chooseCabinetFile()
+{
+    auto current = audioProcessor.getCabinetFile();
+    cabinetChooser = std::make_unique<FileChooser>("Load Cabinet Impulse Response",
+                                                   current != File() ? current.getParentDirectory() : File::getSpecialLocation(File::userDocumentsDirectory),
+                                                   "*.wav;*.aif;*.aiff;*.flac");
+    
+    cabinetChooser->launchAsync(FileBrowserComponent::openMode | FileBrowserComponent::canSelectFiles, [this] (const FileChooser& fc)
+    {
+        auto file = fc.getResult();
+        
+        // Read on the loader thread, the audio carries on with the old IR meanwhile
+        if (file.existsAsFile() && ! audioProcessor.loadCabinet(file))
+            AlertWindow::showMessageBoxAsync(MessageBoxIconType::WarningIcon, "Load Cabinet Impulse Response",
+                                             "Couldn't read " + file.getFullPathName() + " as audio.");
+    });
+}
+
+void DistortionEffectProjectAudioProcessorEditor::showLimiterMenu()
+{
+    auto* onParameter = audioProcessor.treeState.getParameter("limiter");
+    auto* ceilingParameter = audioProcessor.treeState.getParameter("ceiling");
+    auto isOn = onParameter->getValue() >= 0.5f;
+    auto ceiling = ceilingParameter->convertFrom0to1(ceilingParameter->getValue());
+    
+    PopupMenu menu;
+    menu.addSectionHeader("True Peak Limiter");
+    menu.addItem("On", true, isOn, [onParameter, isOn] { onParameter->setValueNotifyingHost(isOn ? 0.0f : 1.0f); });
+    menu.addSeparator();
+    
+    // The usual delivery ceilings, anything else can be automated
+    for (auto option : { 0.0f, -0.1f, -0.3f, -0.5f, -1.0f, -2.0f, -3.0f })
+    {
+        menu.addItem("Ceiling " + String(option, 1) + " dBTP", true, std::abs(ceiling - option) < 0.01f, [ceilingParameter, option]
+        {
+            ceilingParameter->setValueNotifyingHost(ceilingParameter->convertTo0to1(option));
+        });
+    }
+    
+    menu.showMenuAsync(PopupMenu::Options().withTargetComponent(&limiterButton));
+}
+
+void DistortionEffectProjectAudioProcessorEditor::sliderValueChanged(Slider *slider)
+{
+
+// Since I added parameter function, we don't need to update these variables in the process block this way  anymore
+    
+//    if(slider == &driveSlider){
+//        //          dB = 20log(amp)
+//        //  =>     amp = 10^(dB/20)
+//        audioProcessor.drive = pow(10, driveSlider.getValue()/20);
+//    } else if(slider == &outputLvlSlider){
+//        audioProcessor.outputLvl = pow(10, outputLvlSlider.getValue()/20);
+//    }else if(slider == &wetSlider){
+//        audioProcessor.wet = wetSlider.getValue() / 100;
+//    } else if(slider == &drySlider){
+//        audioProcessor.dry = drySlider.getValue() / 100;
+//    } else if(slider == &thresholdSlider){
+//        audioProcessor.threshold = pow(10, thresholdSlider.getValue()/20);
+//    }
+}
@@ -1,88 +1,121 @@
-/*
-  ==============================================================================
-
-    This file contains the basic framework code for a JUCE plugin editor.
-
-  ==============================================================================
-*/
-
-#pragma once
-
-#include <JuceHeader.h>
-#include "PluginProcessor.h"
-using namespace juce;
-
-//==============================================================================
-/**
-*/
-
-class GreenTheme : public LookAndFeel_V4
-{
-    public:
-    GreenTheme()
-    {
-        setColour(Slider::rotarySliderOutlineColourId, Colour(213, 245, 223));
-        setColour(Slider::thumbColourId, Colour(60, 81, 72));
-        setColour(Slider::rotarySliderFillColourId, Colour(107, 142, 78));
-        setColour(Slider::backgroundColourId, Colour(178, 197, 178));
-        setColour(Slider::trackColourId, Colour(107, 142, 78));
-        setColour(Slider::textBoxOutlineColourId, Colours::transparentBlack);
-        
-    }
-    
-};
-
-class DistortionEffectProjectAudioProcessorEditor  : public juce::AudioProcessorEditor,
-                                                        public Slider::Listener
-{
-public:
-    DistortionEffectProjectAudioProcessorEditor (DistortionEffectProjectAudioProcessor&);
-    ~DistortionEffectProjectAudioProcessorEditor() override;
-
-    //==============================================================================
-    void paint (juce::Graphics&) override;
-    void resized() override;
-    void sliderValueChanged (Slider *slider) override;
-    
-    std::unique_ptr<AudioProcessorValueTreeState::SliderAttachment> driveAttach;
-    std::unique_ptr<AudioProcessorValueTreeState::SliderAttachment> outputLvlAttach;
-    std::unique_ptr<AudioProcessorValueTreeState::SliderAttachment> wetAttach;
-    std::unique_ptr<AudioProcessorValueTreeState::SliderAttachment> dryAttach;
-    std::unique_ptr<AudioProcessorValueTreeState::SliderAttachment> thresholdAttach;
-    
-private:
-    // This reference is provided as a quick way for your editor to
-    // access the processor object that created it.
-    DistortionEffectProjectAudioProcessor& audioProcessor;
-    
-    FontOptions chalkDuster;
-    FontOptions trattatello;
-    
-    Slider driveSlider;
-    Label driveLabel;
-    
-    Slider outputLvlSlider;
-    Label outputLvlLabel;
-    
-    Slider wetSlider;
-    Label wetLabel;
-    
-    Slider drySlider;
-    Label dryLabel;
-    
-    Slider thresholdSlider;
-    Label thresholdLabel;
-    
-    Label pluginTitle;
-    Label pluginTitleShadow;
-    
-    GreenTheme greenTheme;
-    
-    const int borderX = 40;
-    const int borderTop = 60;
-    const int borderBottom = 5;
-    const int sliderSize = 170;
-    const int threshSliderXBound = 80.0f;
-    
-    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (DistortionEffectProjectAudioProcessorEditor)
-};
+/*
+  ==============================================================================
+
+    This file contains the basic framework code for a JUCE plugin editor.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "PluginProcessor.h"
+#include "MeterDisplay.h"
+#include "EditorAssets.h"
+#include "PerformanceView.h"
+using namespace juce;
+
+//==============================================================================
+/**
+*/
+
+class DistortionEffectProjectAudioProcessorEditor  : public juce::AudioProcessorEditor,
+                                                        public Slider::Listener,
+                                                        private Timer
+{
+public:
+    DistortionEffectProjectAudioProcessorEditor (DistortionEffectProjectAudioProcessor&);
+    ~DistortionEffectProjectAudioProcessorEditor() override;
+
+    //==============================================================================
+    void paint (juce::Graphics&) override;
+    void resized() override;
+    void sliderValueChanged (Slider *slider) override;
+    void timerCallback() override;
+    
+    std::unique_ptr<AudioProcessorValueTreeState::SliderAttachment> driveAttach;
+    std::unique_ptr<AudioProcessorValueTreeState::SliderAttachment> outputLvlAttach;
+    std::unique_ptr<AudioProcessorValueTreeState::SliderAttachment> wetAttach;
+    std::unique_ptr<AudioProcessorValueTreeState::SliderAttachment> dryAttach;
+    std::unique_ptr<AudioProcessorValueTreeState::SliderAttachment> thresholdAttach;
+    std::unique_ptr<AudioProcessorValueTreeState::SliderAttachment> morphAttach;
+    
+private:
+    // This reference is provided as a quick way for your editor to
+    // access the processor object that created it.
+    DistortionEffectProjectAudioProcessor& audioProcessor;
+    
+    // Shared with every other open editor. The title, the slider names and the
+    // threshold marker never change, so they're part of the cached background.
+    SharedResourcePointer<EditorAssets> assets;
+    Image background;
+    float backgroundScale = 0.0f;
+    
+    void paintBackground (Graphics& g);
+    
+    Slider driveSlider;
+    Slider outputLvlSlider;
+    Slider wetSlider;
+    Slider drySlider;
+    Slider thresholdSlider;
+    
+    // Preset bar between the knobs and the meters
+    ComboBox presetBox;
+    TextButton saveButton { "Save" };
+    TextButton storeBButton { "Set B" };
+    Slider morphSlider;
+    int shownProgram = -1;
+    int shownNumPrograms = 0;
+    
+    void refreshPresetList();
+    void savePreset();
+    
+    // The cabinet IR: load, switch on and off, remove
+    TextButton cabinetButton { "Cab" };
+    std::unique_ptr<FileChooser> cabinetChooser;
+    
+    void showCabinetMenu();
+    void chooseCabinetFile();
+    
+    // The output limiter: on and off, and its ceiling
+    TextButton limiterButton { "Lim" };
+    
+    void showLimiterMenu();
+    
+    // Meters along the bottom, fed from the processor's MeterSource
+    LevelMeter inputMeter;
+    LevelMeter outputMeter;
+    LevelMeter reductionMeter { LevelMeter::Style::reduction };
+    TransferCurveDisplay transferCurve;
+    WaveformDisplay waveform;
+    Label clipLabel;
+    Label qualityLabel;         // the tier the quality governor runs at
+    int shownQualityTier = -2;
+    
+    float inputPeakDb = -100.0f, inputRmsDb = -100.0f;
+    float outputPeakDb = -100.0f, outputRmsDb = -100.0f;
+    float reductionDb = 0.0f;
+    float lastInputPeak = 0.0f;
+    int64 totalClips = 0;
+    
+   #if HYPERBOLIC_ENABLE_INSTRUMENTATION
+    // Block timings under the meters, in builds that measure them
+    PerformanceView performanceView { audioProcessor.getPerformanceMonitor() };
+    const int performanceAreaHeight = 90;
+   #else
+    const int performanceAreaHeight = 0;
+   #endif
+    
+    const int borderX = 40;
+    const int borderTop = 60;
+    const int borderBottom = 5;
+    const int sliderSize = 170;
+    const int threshSliderXBound = 80.0f;
+    const int knobAreaHeight = 400;
+    const int presetBarHeight = 30;
+    const int meterAreaHeight = 110;
+    const float sliderNameSize = 16.0f;
+    const float titleSize = 30.0f;
+    
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (DistortionEffectProjectAudioProcessorEditor)
+};
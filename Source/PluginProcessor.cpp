@@ -1,239 +1,897 @@
-/*
-  ==============================================================================
-
-    This file contains the basic framework code for a JUCE plugin processor.
-
-  ==============================================================================
-*/
-
-#include "PluginProcessor.h"
-#include "PluginEditor.h"
-
-//==============================================================================
-DistortionEffectProjectAudioProcessor::DistortionEffectProjectAudioProcessor()
-#ifndef JucePlugin_PreferredChannelConfigurations
-     : AudioProcessor (BusesProperties()
-                     #if ! JucePlugin_IsMidiEffect
-                      #if ! JucePlugin_IsSynth
-                       .withInput  ("Input",  juce::AudioChannelSet::stereo(), true)
-                      #endif
-                       .withOutput ("Output", juce::AudioChannelSet::stereo(), true)
-                     #endif
-                       ),
-//            drive(1.0),
-//            outputLvl(1.0),
-//            wet(0.5),
-//            dry(0.5),
-//            threshold(1.0),
-            treeState(*this, nullptr, "PARAMETERS", createParameterLayout())
-#endif
-{
-    treeState.state = ValueTree("saveParameters");
-}
-
-DistortionEffectProjectAudioProcessor::~DistortionEffectProjectAudioProcessor()
-{
-}
-
-AudioProcessorValueTreeState::ParameterLayout DistortionEffectProjectAudioProcessor::createParameterLayout()
-{
-    std::vector<std::unique_ptr<RangedAudioParameter>> parameters;
-
-    parameters.push_back(std::make_unique<AudioParameterFloat>("drive", "Drive", 0.0f, 30.0f, 0.0f));
-    parameters.push_back(std::make_unique<AudioParameterFloat>("outputLvl", "Output Level", -12.0f, 12.0f, 0.0f));
-    parameters.push_back(std::make_unique<AudioParameterFloat>("wet", "Wet Mix", 0.0f, 100.0f, 50.0f));
-    parameters.push_back(std::make_unique<AudioParameterFloat>("dry", "Dry Mix", 0.0f, 100.0f, 50.0f));
-    parameters.push_back(std::make_unique<AudioParameterFloat>("threshold", "Threshold", -20.0f, 3.0f, 1.0f));
-
-    return {parameters.begin(), parameters.end()};
-}
-
-//==============================================================================
-const juce::String DistortionEffectProjectAudioProcessor::getName() const
-{
-    return JucePlugin_Name;
-}
-
-bool DistortionEffectProjectAudioProcessor::acceptsMidi() const
-{
-   #if JucePlugin_WantsMidiInput
-    return true;
-   #else
-    return false;
-   #endif
-}
-
-bool DistortionEffectProjectAudioProcessor::producesMidi() const
-{
-   #if JucePlugin_ProducesMidiOutput
-    return true;
-   #else
-    return false;
-   #endif
-}
-
-bool DistortionEffectProjectAudioProcessor::isMidiEffect() const
-{
-   #if JucePlugin_IsMidiEffect
-    return true;
-   #else
-    return false;
-   #endif
-}
-
-double DistortionEffectProjectAudioProcessor::getTailLengthSeconds() const
-{
-    return 0.0;
-}
-
-int DistortionEffectProjectAudioProcessor::getNumPrograms()
-{
-    return 1;   // NB: some hosts don't cope very well if you tell them there are 0 programs,
-                // so this should be at least 1, even if you're not really implementing programs.
-}
-
-int DistortionEffectProjectAudioProcessor::getCurrentProgram()
-{
-    return 0;
-}
-
-void DistortionEffectProjectAudioProcessor::setCurrentProgram (int index)
-{
-}
-
-const juce::String DistortionEffectProjectAudioProcessor::getProgramName (int index)
-{
-    return {};
-}
-
-void DistortionEffectProjectAudioProcessor::changeProgramName (int index, const juce::String& newName)
-{
-}
-
-//==============================================================================
-void DistortionEffectProjectAudioProcessor::prepareToPlay (double sampleRate, int samplesPerBlock)
-{
-    //dsp::ProcessSpec spec;
-}
-
-void DistortionEffectProjectAudioProcessor::releaseResources()
-{
-    // When playback stops, you can use this as an opportunity to free up any
-    // spare memory, etc.
-}
-
-#ifndef JucePlugin_PreferredChannelConfigurations
-bool DistortionEffectProjectAudioProcessor::isBusesLayoutSupported (const BusesLayout& layouts) const
-{
-  #if JucePlugin_IsMidiEffect
-    juce::ignoreUnused (layouts);
-    return true;
-  #else
-    // This is the place where you check if the layout is supported.
-    // In this template code we only support mono or stereo.
-    // Some plugin hosts, such as certain GarageBand versions, will only
-    // load plugins that support stereo bus layouts.
-    if (layouts.getMainOutputChannelSet() != juce::AudioChannelSet::mono()
-     && layouts.getMainOutputChannelSet() != juce::AudioChannelSet::stereo())
-        return false;
-
-    // This checks if the input layout matches the output layout
-   #if ! JucePlugin_IsSynth
-    if (layouts.getMainOutputChannelSet() != layouts.getMainInputChannelSet())
-        return false;
-   #endif
-
-    return true;
-  #endif
-}
-#endif
-
-void DistortionEffectProjectAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages)
-{
-    juce::ScopedNoDenormals noDenormals;
-    auto totalNumInputChannels  = getTotalNumInputChannels();
-    auto totalNumOutputChannels = getTotalNumOutputChannels();
-
-    // In case we have more outputs than inputs, this code clears any output
-    // channels that didn't contain input data, (because these aren't
-    // guaranteed to be empty - they may contain garbage).
-    // This is here to avoid people getting screaming feedback
-    // when they first compile a plugin, but obviously you don't need to keep
-    // this code if your algorithm always overwrites all the output channels.
-    for (auto i = totalNumInputChannels; i < totalNumOutputChannels; ++i)
-        buffer.clear (i, 0, buffer.getNumSamples());
-
-    // This is the place where you'd normally do the guts of your plugin's
-    // audio processing...
-    // Make sure to reset the state if your inner loop is processing
-    // the samples and the outer loop is handling the channels.
-    // Alternatively, you can process the samples with the channels
-    // interleaved by keeping the same state.
-    for (int channel = 0; channel < totalNumInputChannels; ++channel)
-    {
-        auto* channelData = buffer.getWritePointer(channel);
-
-        for(int sample = 0; sample < buffer.getNumSamples(); sample++){
-            // We have to first get the parameter values in case the user has used automation
-            float drive = pow(10, *treeState.getRawParameterValue("drive")/20);
-            float outputLvl = pow(10, *treeState.getRawParameterValue("outputLvl")/20);
-            float wet = *treeState.getRawParameterValue("wet") / 100;
-            float dry = *treeState.getRawParameterValue("dry") / 100;
-            float threshold = pow(10, *treeState.getRawParameterValue("threshold")/20);
-            
-            // Here, I have used the hyperbolic tan function to distort the signal, as it has
-            // horizontal asymptotes at y = -1 & y = 1. The variable drive therefore adjusts
-            // the intensity (or harshness) of the wave
-            
-            float distortedSample = tanh(channelData[sample] * drive);
-            
-            if(distortedSample > threshold){
-                distortedSample = threshold;
-            } else if (distortedSample < -threshold){
-                distortedSample = -threshold;
-            }
-            
-            channelData[sample] = (dry * channelData[sample] + wet * distortedSample);
-            
-            channelData[sample] *=  outputLvl;
-        }
-    }
-}
-
-//==============================================================================
-bool DistortionEffectProjectAudioProcessor::hasEditor() const
-{
-    return true; // (change this to false if you choose to not supply an editor)
-}
-
-juce::AudioProcessorEditor* DistortionEffectProjectAudioProcessor::createEditor()
-{
-    return new DistortionEffectProjectAudioProcessorEditor (*this);
-}
-
-//==============================================================================
-void DistortionEffectProjectAudioProcessor::getStateInformation (juce::MemoryBlock& destData)
-{
-    std::unique_ptr<XmlElement> xml(treeState.state.createXml());
-    copyXmlToBinary(*xml, destData);
-}
-
-void DistortionEffectProjectAudioProcessor::setStateInformation (const void* data, int sizeInBytes)
-{
-    std::unique_ptr<XmlElement> savedParameters(getXmlFromBinary(data, sizeInBytes));
-    if (savedParameters != nullptr)
-    {
-        // If xml has name "saveParameters"
-        if(savedParameters -> hasTagName(treeState.state.getType()))
-        {
-            treeState.state = ValueTree::fromXml(*savedParameters);
-        }
-    }
-}
-
-//==============================================================================
-// This creates new instances of the plugin..
-juce::AudioProcessor* JUCE_CALLTYPE createPluginFilter()
-{
-    return new DistortionEffectProjectAudioProcessor();
-}
+/*
+  ==============================================================================
+
+    This file contains the basic framework code for a JUCE plugin processor.
+
+  ==============================================================================
+*/
+
+#include "PluginProcessor.h"
+#include "PluginEditor.h"
+
+namespace
+{
+    // The parameters a preset sets, in the order PlainParameters lists them
+    const std::pair<const char*, float PlainParameters::*> presetFields[] =
+    {
+        { "drive",      &PlainParameters::drive },
+        { "outputLvl",  &PlainParameters::outputLvl },
+        { "wet",        &PlainParameters::wet },
+        { "dry",        &PlainParameters::dry },
+        { "threshold",  &PlainParameters::threshold }
+    };
+
+    // QualityGovernor's tiers, after the offline one
+    const StringArray qualityTierNames { "Offline", "Full", "Fast Curve", "ADAA 1st Order", "No ADAA" };
+}
+
+//==============================================================================
+/** Shows the host which tier the quality governor runs at. It's a readout rather than a
+    setting: the host can't automate it, it isn't saved with the state, and it changes
+    without notifying the host of an edit, so it never dirties the project.
+*/
+class DistortionEffectProjectAudioProcessor::QualityTierParameter  : public AudioParameterChoice
+{
+public:
+    QualityTierParameter()
+        : AudioParameterChoice ("qualityTier", "Quality Tier", qualityTierNames, 1 + QualityGovernor::full)
+    {
+    }
+
+    bool isAutomatable() const override     { return false; }
+    Category getCategory() const override   { return outputMeter; }
+
+    /** Message thread. Returns true if that changed it, and the host should be told to
+        read the parameters again.
+    */
+    bool show (int index)
+    {
+        if (index == getIndex())
+            return false;
+
+        // Straight to the value, as setValueNotifyingHost would record it as an edit
+        static_cast<AudioProcessorParameter&> (*this).setValue (convertTo0to1 ((float) index));
+        return true;
+    }
+};
+
+//==============================================================================
+DistortionEffectProjectAudioProcessor::DistortionEffectProjectAudioProcessor()
+#ifndef JucePlugin_PreferredChannelConfigurations
+     : AudioProcessor (BusesProperties()
+                     #if ! JucePlugin_IsMidiEffect
+                      #if ! JucePlugin_IsSynth
+                       .withInput  ("Input",  juce::AudioChannelSet::stereo(), true)
+                      #endif
+                       .withOutput ("Output", juce::AudioChannelSet::stereo(), true)
+                     #endif
+                       ),
+//            drive(1.0),
+//            outputLvl(1.0),
+//            wet(0.5),
+//            dry(0.5),
+//            threshold(1.0),
+            treeState(*this, nullptr, "PARAMETERS", createParameterLayout()),
+            parameters(treeState)
+#endif
+{
+    treeState.state = ValueTree("saveParameters");
+
+    accuracyParam = treeState.getRawParameterValue ("accuracy");
+    antialiasingParam = treeState.getRawParameterValue ("antialiasing");
+    oversamplingParam = treeState.getRawParameterValue ("oversampling");
+    oversamplingFilterParam = treeState.getRawParameterValue ("osFilter");
+    morphParam = treeState.getRawParameterValue ("morph");
+    bandsParam = treeState.getRawParameterValue ("bands");
+    cabinetParam = treeState.getRawParameterValue ("cabinet");
+    limiterParam = treeState.getRawParameterValue ("limiter");
+    ceilingParam = treeState.getRawParameterValue ("ceiling");
+    autoQualityParam = treeState.getRawParameterValue ("autoQuality");
+    tierParameter = dynamic_cast<QualityTierParameter*> (treeState.getParameter ("qualityTier"));
+
+    for (int i = 0; i < MultibandStage<float>::maxBands - 1; ++i)
+        crossoverParams[i] = treeState.getRawParameterValue ("xover" + String (i + 1));
+
+    for (int band = 0; band < MultibandStage<float>::maxBands; ++band)
+    {
+        auto prefix = "band" + String (band + 1);
+        bandDriveParams[band] = treeState.getRawParameterValue (prefix + "Drive");
+        bandThresholdParams[band] = treeState.getRawParameterValue (prefix + "Threshold");
+        bandLevelParams[band] = treeState.getRawParameterValue (prefix + "Level");
+    }
+
+    for (size_t i = 0; i < std::size (presetFields); ++i)
+        presetParameters[i] = treeState.getParameter (presetFields[i].first);
+
+    writeMorphTarget ({});
+}
+
+DistortionEffectProjectAudioProcessor::~DistortionEffectProjectAudioProcessor()
+{
+}
+
+AudioProcessorValueTreeState::ParameterLayout DistortionEffectProjectAudioProcessor::createParameterLayout()
+{
+    std::vector<std::unique_ptr<RangedAudioParameter>> parameters;
+
+    parameters.push_back(std::make_unique<AudioParameterFloat>("drive", "Drive", 0.0f, 30.0f, 0.0f));
+    parameters.push_back(std::make_unique<AudioParameterFloat>("outputLvl", "Output Level", -12.0f, 12.0f, 0.0f));
+    parameters.push_back(std::make_unique<AudioParameterFloat>("wet", "Wet Mix", 0.0f, 100.0f, 50.0f));
+    parameters.push_back(std::make_unique<AudioParameterFloat>("dry", "Dry Mix", 0.0f, 100.0f, 50.0f));
+    parameters.push_back(std::make_unique<AudioParameterFloat>("threshold", "Threshold", -20.0f, 3.0f, 1.0f));
+    parameters.push_back(std::make_unique<AudioParameterChoice>("accuracy", "Tanh Accuracy", StringArray { "Exact", "Fast", "Table" }, 1));
+    parameters.push_back(std::make_unique<AudioParameterChoice>("oversampling", "Oversampling", StringArray { "Off", "2x", "4x", "8x" }, 0));
+    parameters.push_back(std::make_unique<AudioParameterChoice>("osFilter", "Oversampling Filter", StringArray { "IIR (min phase)", "FIR (linear phase)" }, 0));
+    parameters.push_back(std::make_unique<AudioParameterFloat>("morph", "A/B Morph", 0.0f, 100.0f, 0.0f));
+
+    // Multiband mode. The crossovers are skewed so the middle of each knob sits at its default,
+    // and the band controls are offsets from the main Drive, Threshold and Output Level.
+    auto frequencyRange = [] (float minimum, float maximum, float centre)
+    {
+        NormalisableRange<float> range (minimum, maximum);
+        range.setSkewForCentre (centre);
+        return range;
+    };
+
+    parameters.push_back(std::make_unique<AudioParameterChoice>("bands", "Bands", StringArray { "Off", "2", "3", "4" }, 0));
+    parameters.push_back(std::make_unique<AudioParameterFloat>("xover1", "Low Crossover", frequencyRange(40.0f, 1000.0f, 200.0f), 200.0f));
+    parameters.push_back(std::make_unique<AudioParameterFloat>("xover2", "Mid Crossover", frequencyRange(200.0f, 5000.0f, 1000.0f), 1000.0f));
+    parameters.push_back(std::make_unique<AudioParameterFloat>("xover3", "High Crossover", frequencyRange(1000.0f, 16000.0f, 5000.0f), 5000.0f));
+
+    for (int band = 1; band <= MultibandStage<float>::maxBands; ++band)
+    {
+        auto id = "band" + String(band);
+        auto name = "Band " + String(band);
+        parameters.push_back(std::make_unique<AudioParameterFloat>(id + "Drive", name + " Drive", -12.0f, 12.0f, 0.0f));
+        parameters.push_back(std::make_unique<AudioParameterFloat>(id + "Threshold", name + " Threshold", -12.0f, 12.0f, 0.0f));
+        parameters.push_back(std::make_unique<AudioParameterFloat>(id + "Level", name + " Level", -12.0f, 12.0f, 0.0f));
+    }
+
+    // Antiderivative anti-aliasing, an alternative (or addition) to oversampling.
+    // It always evaluates the exact curve, so it overrides Tanh Accuracy.
+    parameters.push_back(std::make_unique<AudioParameterChoice>("antialiasing", "Anti-Aliasing", StringArray { "Off", "ADAA", "ADAA 2nd Order" }, 0));
+
+    // Convolves the output with the loaded cabinet IR, if there is one
+    parameters.push_back(std::make_unique<AudioParameterBool>("cabinet", "Cabinet", false));
+
+    // Lets the plugin trade quality for CPU when blocks get close to their deadline, and
+    // render offline with the exact curve. The tier it picked is shown as a read only parameter.
+    parameters.push_back(std::make_unique<AudioParameterChoice>("autoQuality", "Auto Quality", StringArray { "Off", "On" }, 1));
+    parameters.push_back(std::make_unique<QualityTierParameter>());
+
+    // A true peak limiter after everything else, for when Output Level pushes past 0 dBFS.
+    // At the end of the list, so the indices hosts already know don't move.
+    parameters.push_back(std::make_unique<AudioParameterBool>("limiter", "Limiter", false));
+    parameters.push_back(std::make_unique<AudioParameterFloat>("ceiling", "Limiter Ceiling", -12.0f, 0.0f, -1.0f));
+
+    return {parameters.begin(), parameters.end()};
+}
+
+//==============================================================================
+const juce::String DistortionEffectProjectAudioProcessor::getName() const
+{
+    return JucePlugin_Name;
+}
+
+bool DistortionEffectProjectAudioProcessor::acceptsMidi() const
+{
+   #if JucePlugin_WantsMidiInput
+    return true;
+   #else
+    return false;
+   #endif
+}
+
+bool DistortionEffectProjectAudioProcessor::producesMidi() const
+{
+   #if JucePlugin_ProducesMidiOutput
+    return true;
+   #else
+    return false;
+   #endif
+}
+
+bool DistortionEffectProjectAudioProcessor::isMidiEffect() const
+{
+   #if JucePlugin_IsMidiEffect
+    return true;
+   #else
+    return false;
+   #endif
+}
+
+double DistortionEffectProjectAudioProcessor::getTailLengthSeconds() const
+{
+    // The only things that ring on after the input stops are the oversampling
+    // filters, with bands the crossovers, and the cabinet IR
+    auto sampleRate = getSampleRate();
+    auto crossovers = bandsParam->load (std::memory_order_relaxed) >= 0.5f ? 5.0 / MultibandStage<float>::minCrossover : 0.0;
+
+    if (sampleRate <= 0.0)
+        return crossovers;
+
+    return (getLatencySamples() + cabinet.getTailLengthInSamples()) / sampleRate + crossovers;
+}
+
+int DistortionEffectProjectAudioProcessor::getNumPrograms()
+{
+    return presets.getNumPresets();     // the factory presets alone make this at least 1
+}
+
+int DistortionEffectProjectAudioProcessor::getCurrentProgram()
+{
+    return currentProgram.load (std::memory_order_relaxed);
+}
+
+void DistortionEffectProjectAudioProcessor::setCurrentProgram (int index)
+{
+    // Hosts call this on the message thread, but some send MIDI program changes from
+    // the audio thread. Setting parameters from there would notify the host (which
+    // may allocate) and race setStateInformation, so the next block switches to the
+    // program's values itself and leaves the parameters to the message thread.
+    if (! MessageManager::existsAndIsCurrentThread())
+    {
+        pendingProgram.store (index, std::memory_order_release);
+        return;
+    }
+
+    loadProgram (index);
+    dropPendingProgram();
+}
+
+void DistortionEffectProjectAudioProcessor::loadProgram (int index)
+{
+    PlainParameters values;
+
+    if (! presets.getValues (index, values))
+        return;
+
+    currentProgram.store (index, std::memory_order_relaxed);
+    applyPreset (values);
+}
+
+void DistortionEffectProjectAudioProcessor::dropPendingProgram() noexcept
+{
+    pendingProgram.store (-1, std::memory_order_relaxed);
+    programToSync.store (-1, std::memory_order_relaxed);
+    programSyncs.store (programPickups.load (std::memory_order_acquire), std::memory_order_release);
+}
+
+const juce::String DistortionEffectProjectAudioProcessor::getProgramName (int index)
+{
+    return presets.getName (index);
+}
+
+void DistortionEffectProjectAudioProcessor::changeProgramName (int index, const juce::String& newName)
+{
+    if (presets.renameUserPreset (index, newName))
+        updateHostDisplay (ChangeDetails().withProgramChanged (true));
+}
+
+int DistortionEffectProjectAudioProcessor::saveUserPreset (const String& name)
+{
+    auto index = presets.addUserPreset (name, parameters.readPlainValues());
+
+    if (index >= 0)
+    {
+        currentProgram.store (index, std::memory_order_relaxed);
+        updateHostDisplay (ChangeDetails().withProgramChanged (true));
+    }
+
+    return index;
+}
+
+void DistortionEffectProjectAudioProcessor::storeMorphTarget()
+{
+    restoreSequence.beginWrite();
+    writeMorphTarget (parameters.readPlainValues());
+    restoreSequence.endWrite();
+}
+
+void DistortionEffectProjectAudioProcessor::applyPreset (const PlainParameters& values)
+{
+    restoreSequence.beginWrite();
+
+    for (size_t i = 0; i < std::size (presetFields); ++i)
+    {
+        auto* parameter = presetParameters[i];
+        parameter->setValueNotifyingHost (parameter->convertTo0to1 (values.*presetFields[i].second));
+    }
+
+    restoreSequence.endWrite();
+}
+
+PlainParameters DistortionEffectProjectAudioProcessor::readMorphTarget() const noexcept
+{
+    PlainParameters values;
+
+    for (size_t i = 0; i < std::size (presetFields); ++i)
+        values.*presetFields[i].second = morphTarget[i].load (std::memory_order_relaxed);
+
+    return values;
+}
+
+void DistortionEffectProjectAudioProcessor::writeMorphTarget (const PlainParameters& values) noexcept
+{
+    for (size_t i = 0; i < std::size (presetFields); ++i)
+        morphTarget[i].store (values.*presetFields[i].second, std::memory_order_relaxed);
+}
+
+DistortionParameters DistortionEffectProjectAudioProcessor::readTargets() const noexcept
+{
+    return readTargets (parameters.readPlainValues());
+}
+
+DistortionParameters DistortionEffectProjectAudioProcessor::readTargets (const PlainParameters& values) const noexcept
+{
+    auto morph = morphParam->load (std::memory_order_relaxed) / 100.0f;
+
+    if (morph > 0.0f)
+        return ParameterSnapshot::toGains (values.interpolatedTowards (readMorphTarget(), morph));
+
+    return ParameterSnapshot::toGains (values);
+}
+
+PlainParameters DistortionEffectProjectAudioProcessor::readPlainValues() noexcept
+{
+    auto program = pendingProgram.exchange (-1, std::memory_order_acquire);
+
+    if (program >= 0)
+    {
+        // The user file may be busy, in which case only the message thread can read it
+        if (presets.tryGetValues (program, programValues))
+        {
+            currentProgram.store (program, std::memory_order_relaxed);
+            programPickups.fetch_add (1, std::memory_order_release);
+        }
+
+        programToSync.store (program, std::memory_order_release);
+        updateOnMessageThread();
+    }
+
+    if (programPickups.load (std::memory_order_relaxed) != programSyncs.load (std::memory_order_acquire))
+        return programValues;
+
+    return parameters.readPlainValues();
+}
+
+//==============================================================================
+void DistortionEffectProjectAudioProcessor::prepareToPlay (double sampleRate, int samplesPerBlock)
+{
+    // With the A/B morph applied, as every block's targets are
+    parameters.prepare (sampleRate, readTargets());
+    governor.prepare (sampleRate, samplesPerBlock);
+
+    preparedBlockSize = jmax (1, samplesPerBlock);
+    silentSamples = 0;
+    skippingSilence = false;
+    meters.prepare (sampleRate);
+   #if HYPERBOLIC_ENABLE_INSTRUMENTATION
+    performance.prepare (sampleRate, samplesPerBlock);
+   #endif
+    auto numChannels = jmax (getTotalNumInputChannels(), getTotalNumOutputChannels());
+
+    // First, since its lookahead is part of the latency set below. It starts at unity
+    // gain once takeWorkingMemory() has given it its buffers.
+    limiter.prepare (sampleRate, numChannels, preparedBlockSize);
+    limiter.setEnabled (readSettings().limiter);
+    waveshaper.setLatency (readSettings().shaperLatency);
+
+    // The host picks the precision before calling prepareToPlay, so only
+    // the signal path that is actually going to be used gets its memory.
+    if (isUsingDoublePrecision())
+    {
+        doubleOversampling.prepare (sampleRate, numChannels, preparedBlockSize);
+        doubleMultiband.prepare (sampleRate, numChannels, preparedBlockSize);
+        updateOversamplingMode<double> (readSettings());
+        setLatencySamples (doubleOversampling.getLatencyInSamples() + waveshaper.getLatencyInSamples() + limiter.getLatencyInSamples());
+    }
+    else
+    {
+        floatOversampling.prepare (sampleRate, numChannels, preparedBlockSize);
+        floatMultiband.prepare (sampleRate, numChannels, preparedBlockSize);
+        updateOversamplingMode<float> (readSettings());
+        setLatencySamples (floatOversampling.getLatencyInSamples() + waveshaper.getLatencyInSamples() + limiter.getLatencyInSamples());
+    }
+
+    waveshaper.prepare (numChannels, preparedBlockSize * OversamplingOptions::getMaxFactor());
+
+    // Also loads an IR that's still waiting for the background thread, so the
+    // first block already has it
+    cabinet.prepare (sampleRate, numChannels, preparedBlockSize, isUsingDoublePrecision());
+
+    // Every stage knows its sizes now, so all their buffers come out of one allocation
+    arena.beginMeasuring();
+    takeWorkingMemory();
+    arena.allocateMeasured();
+    takeWorkingMemory();
+}
+
+void DistortionEffectProjectAudioProcessor::takeWorkingMemory() noexcept
+{
+    // The path for the other precision gets nullptrs, so nothing is left pointing
+    // into memory from an earlier prepare
+    AudioArena nothing;
+    auto doublePrecision = isUsingDoublePrecision();
+
+    floatOversampling.takeWorkingMemory (doublePrecision ? nothing : arena);
+    floatMultiband.takeWorkingMemory (doublePrecision ? nothing : arena);
+    doubleOversampling.takeWorkingMemory (doublePrecision ? arena : nothing);
+    doubleMultiband.takeWorkingMemory (doublePrecision ? arena : nothing);
+    waveshaper.takeWorkingMemory (arena);
+    cabinet.takeWorkingMemory (arena);
+    limiter.takeWorkingMemory (arena);
+}
+
+template <typename SampleType>
+OversamplingStage<SampleType>& DistortionEffectProjectAudioProcessor::getOversampling() noexcept
+{
+    if constexpr (std::is_same_v<SampleType, float>)
+        return floatOversampling;
+    else
+        return doubleOversampling;
+}
+
+template <typename SampleType>
+MultibandStage<SampleType>& DistortionEffectProjectAudioProcessor::getMultiband() noexcept
+{
+    if constexpr (std::is_same_v<SampleType, float>)
+        return floatMultiband;
+    else
+        return doubleMultiband;
+}
+
+template <typename SampleType>
+bool DistortionEffectProjectAudioProcessor::updateOversamplingMode (const Settings& settings) noexcept
+{
+    return getOversampling<SampleType>().setMode (settings.oversampling, settings.oversamplingFilter);
+}
+
+DistortionEffectProjectAudioProcessor::Settings DistortionEffectProjectAudioProcessor::readSettings() noexcept
+{
+    auto sequence = restoreSequence.beginRead();
+
+    Settings settings;
+    settings.targets = readTargets (readPlainValues());
+    settings.accuracy = jlimit (0, 2, roundToInt (accuracyParam->load (std::memory_order_relaxed)));
+    settings.antialiasing = jlimit (0, 2, roundToInt (antialiasingParam->load (std::memory_order_relaxed)));
+    settings.oversampling = roundToInt (oversamplingParam->load (std::memory_order_relaxed));
+    settings.oversamplingFilter = oversamplingFilterParam->load (std::memory_order_relaxed) < 0.5f ? OversamplingOptions::Filter::iirMinimumPhase
+                                                                                                   : OversamplingOptions::Filter::firLinearPhase;
+    settings.numBands = 1 + jlimit (0, MultibandStage<float>::maxBands - 1, roundToInt (bandsParam->load (std::memory_order_relaxed)));
+
+    for (int i = 0; i < MultibandStage<float>::maxBands - 1; ++i)
+        settings.crossovers[i] = crossoverParams[i]->load (std::memory_order_relaxed);
+
+    for (int band = 0; band < MultibandStage<float>::maxBands; ++band)
+    {
+        settings.bands[band].drive     = Decibels::decibelsToGain (bandDriveParams[band]->load (std::memory_order_relaxed));
+        settings.bands[band].threshold = Decibels::decibelsToGain (bandThresholdParams[band]->load (std::memory_order_relaxed));
+        settings.bands[band].level     = Decibels::decibelsToGain (bandLevelParams[band]->load (std::memory_order_relaxed));
+    }
+
+    settings.cabinet = cabinetParam->load (std::memory_order_relaxed) >= 0.5f;
+    settings.limiter = limiterParam->load (std::memory_order_relaxed) >= 0.5f;
+    settings.ceiling = Decibels::decibelsToGain (ceilingParam->load (std::memory_order_relaxed));
+    settings.autoQuality = autoQualityParam->load (std::memory_order_relaxed) >= 0.5f;
+
+    // setStateInformation was halfway through the parameters, so run one more
+    // block with the previous set rather than with a mix of old and new.
+    if (restoreSequence.isConsistent (sequence))
+        lastSettings = settings;
+    else
+        settings = lastSettings;
+
+    // Second order ADAA at the host rate puts the output a sample late. That goes by the
+    // setting rather than what Auto Quality makes of it, so stepping down keeps the latency.
+    settings.shaperLatency = settings.antialiasing == 2 && settings.oversampling == 0 && settings.numBands == 1 ? 1 : 0;
+
+    applyQuality (settings);
+    return settings;
+}
+
+void DistortionEffectProjectAudioProcessor::applyQuality (Settings& settings) const noexcept
+{
+    if (! settings.autoQuality)
+        return;
+
+    // Nobody is waiting for an offline render: the exact curve, with at least first order
+    // ADAA. Oversampling stays as it's set - a different factor would change the latency
+    // part way into the bounce, after the host has already planned its compensation.
+    if (isNonRealtime())
+    {
+        settings.accuracy = (int) Waveshaper::Mode::exact;
+        settings.antialiasing = jmax (1, settings.antialiasing);
+        return;
+    }
+
+    QualityGovernor::apply (governor.getTier(), settings.accuracy, settings.antialiasing);
+}
+
+void DistortionEffectProjectAudioProcessor::updateOnMessageThread() noexcept
+{
+    // Some hosts render offline on the message thread
+    if (MessageManager::existsAndIsCurrentThread())
+        handleAsyncUpdate();
+    else
+        triggerAsyncUpdate();
+}
+
+void DistortionEffectProjectAudioProcessor::handleAsyncUpdate()
+{
+    // Read before the program, so a block that picks up another one in between keeps
+    // its values until the next update has set that one as well
+    auto pickups = programPickups.load (std::memory_order_acquire);
+    auto program = programToSync.exchange (-1, std::memory_order_acquire);
+
+    if (program >= 0)
+        loadProgram (program);
+
+    programSyncs.store (pickups, std::memory_order_release);
+
+    if (tierParameter != nullptr && tierParameter->show (1 + getQualityTier()))
+        updateHostDisplay (ChangeDetails().withParameterInfoChanged (true));
+}
+
+String DistortionEffectProjectAudioProcessor::getQualityTierName (int tier)
+{
+    return qualityTierNames[jlimit (offlineTier, QualityGovernor::numTiers - 1, tier) + 1];
+}
+
+void DistortionEffectProjectAudioProcessor::releaseResources()
+{
+    // Frees the working buffers and hands every stage a nullptr in their place
+    arena.release();
+    takeWorkingMemory();
+}
+
+#ifndef JucePlugin_PreferredChannelConfigurations
+bool DistortionEffectProjectAudioProcessor::isBusesLayoutSupported (const BusesLayout& layouts) const
+{
+  #if JucePlugin_IsMidiEffect
+    juce::ignoreUnused (layouts);
+    return true;
+  #else
+    // Every channel goes through the same curve, so any layout works (5.1, 7.1.4,
+    // ambisonics...) as long as the waveshaper can take all of it in one go.
+    auto mainOutput = layouts.getMainOutputChannelSet();
+
+    if (mainOutput.isDisabled() || mainOutput.size() > Waveshaper::maxChannels)
+        return false;
+
+    // This checks if the input layout matches the output layout
+   #if ! JucePlugin_IsSynth
+    if (layouts.getMainOutputChannelSet() != layouts.getMainInputChannelSet())
+        return false;
+   #endif
+
+    return true;
+  #endif
+}
+#endif
+
+void DistortionEffectProjectAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages)
+{
+    processSamples (buffer);
+}
+
+void DistortionEffectProjectAudioProcessor::processBlock (juce::AudioBuffer<double>& buffer, juce::MidiBuffer& midiMessages)
+{
+    processSamples (buffer);
+}
+
+void DistortionEffectProjectAudioProcessor::processBlockBypassed (juce::AudioBuffer<float>& buffer, juce::MidiBuffer&)
+{
+    processBypassedSamples (buffer);
+}
+
+void DistortionEffectProjectAudioProcessor::processBlockBypassed (juce::AudioBuffer<double>& buffer, juce::MidiBuffer&)
+{
+    processBypassedSamples (buffer);
+}
+
+bool DistortionEffectProjectAudioProcessor::supportsDoublePrecisionProcessing() const
+{
+    return true;
+}
+
+template <typename SampleType>
+void DistortionEffectProjectAudioProcessor::processSamples (AudioBuffer<SampleType>& buffer) noexcept
+{
+    // Between releaseResources and the next prepareToPlay the stages have no buffers
+    if (! arena.isAllocated())
+        return;
+
+    auto governorStart = QualityGovernor::beginBlock();
+   #if HYPERBOLIC_ENABLE_INSTRUMENTATION
+    auto blockStart = PerformanceMonitor::beginBlock();
+   #endif
+
+    juce::ScopedNoDenormals noDenormals;
+    auto totalNumInputChannels  = getTotalNumInputChannels();
+    auto totalNumOutputChannels = getTotalNumOutputChannels();
+
+    // In case we have more outputs than inputs, this code clears any output
+    // channels that didn't contain input data, (because these aren't
+    // guaranteed to be empty - they may contain garbage).
+    // This is here to avoid people getting screaming feedback
+    // when they first compile a plugin, but obviously you don't need to keep
+    // this code if your algorithm always overwrites all the output channels.
+    for (auto i = totalNumInputChannels; i < totalNumOutputChannels; ++i)
+        buffer.clear (i, 0, buffer.getNumSamples());
+
+    // Switching the oversampling factor or filter, the limiter, or second order ADAA at the
+    // host rate changes the plugin's latency
+    auto settings = readSettings();
+    auto& oversampling = getOversampling<SampleType>();
+    auto limiterSwitched = limiter.setEnabled (settings.limiter);
+    auto shaperSwitched = waveshaper.setLatency (settings.shaperLatency);
+
+    if (updateOversamplingMode<SampleType> (settings) || limiterSwitched || shaperSwitched)
+        setLatencySamples (oversampling.getLatencyInSamples() + waveshaper.getLatencyInSamples() + limiter.getLatencyInSamples());
+
+    // Offline, tables are built on this thread rather than whenever the background
+    // thread gets round to them, so a render doesn't depend on its timing
+    waveshaper.setNonRealtime (isNonRealtime());
+
+    if (settings.antialiasing > 0)
+        waveshaper.setMode (settings.antialiasing == 1 ? Waveshaper::Mode::adaaFirstOrder : Waveshaper::Mode::adaaSecondOrder);
+    else
+        waveshaper.setMode ((Waveshaper::Mode) settings.accuracy);
+
+    auto& multiband = getMultiband<SampleType>();
+    multiband.setNumBands (settings.numBands);
+    multiband.setAccuracy (settings.accuracy == (int) Waveshaper::Mode::exact ? WaveshaperKernel::Accuracy::exact
+                                                                              : WaveshaperKernel::Accuracy::fast);
+
+    cabinet.setEnabled (settings.cabinet);
+    limiter.setCeiling (settings.ceiling);
+
+    auto block = dsp::AudioBlock<SampleType> (buffer).getSubsetChannelBlock (0, (size_t) totalNumInputChannels);
+    auto metering = meters.shouldMeasure();
+
+    // Hosts occasionally send more samples than they promised in prepareToPlay,
+    // so anything larger than that is processed in several pieces.
+    for (int offset = 0; offset < buffer.getNumSamples(); offset += preparedBlockSize)
+    {
+        auto numSamples = jmin (preparedBlockSize, buffer.getNumSamples() - offset);
+
+        // The parameters are read (and converted from dB) once per block. They are only
+        // ramped sample by sample while one of them is actually moving - the kernel
+        // checks start against end and runs with constants otherwise.
+        DistortionParameters start, end;
+        parameters.update (numSamples, settings.targets, start, end);
+
+        auto chunk = block.getSubBlock ((size_t) offset, (size_t) numSamples);
+
+        if (metering)
+            meters.measureInput (chunk, end);
+
+        if (multiband.isActive())
+            multiband.beginBlock (settings.bands, settings.crossovers, numSamples);
+
+        if (! canSkipBlock (chunk, oversampling, multiband))
+        {
+            waveshaper.beginBlock (start, end);
+            oversampling.process (chunk, start, end, waveshaper, multiband.isActive() ? &multiband : nullptr);
+            waveshaper.endBlock();
+
+            // At the host rate, after the clip, like a cabinet after an amp
+            cabinet.process (chunk);
+
+            // Last, so nothing can push the peaks up again after it
+            limiter.process (chunk);
+        }
+
+        if (metering)
+            meters.measureOutput (chunk);
+    }
+
+    // The governor wants the settings as they were set, to know which tiers would save anything
+    if (settings.autoQuality && ! isNonRealtime())
+        governor.endBlock (governorStart, buffer.getNumSamples(), lastSettings.accuracy, lastSettings.antialiasing);
+    else
+        governor.reset();
+
+    auto tier = ! settings.autoQuality ? (int) QualityGovernor::full
+                                       : isNonRealtime() ? offlineTier : governor.getPublishedTier();
+
+    if (shownTier.exchange (tier, std::memory_order_relaxed) != tier)
+        updateOnMessageThread();
+
+   #if HYPERBOLIC_ENABLE_INSTRUMENTATION
+    performance.endBlock (blockStart, buffer.getNumSamples(), settings.targets,
+                          oversampling.getFactor(), multiband.getNumBands());
+   #endif
+}
+
+template <typename SampleType>
+bool DistortionEffectProjectAudioProcessor::canSkipBlock (const dsp::AudioBlock<SampleType>& block,
+                                                          OversamplingStage<SampleType>& oversampling,
+                                                          MultibandStage<SampleType>& multiband) noexcept
+{
+    if (! isSilent (block))
+    {
+        silentSamples = 0;
+        skippingSilence = false;
+        return false;
+    }
+
+    // Silence in gives exactly silence out once the oversampling filters (and the
+    // crossovers, ADAA history, cabinet IR and limiter delay) have rung out, and the
+    // buffer already holds those zeros - so there's nothing to do.
+    if (silentSamples >= oversampling.getTailLengthInSamples() + multiband.getTailLengthInSamples()
+                           + waveshaper.getTailLengthInSamples() + cabinet.getTailLengthInSamples()
+                           + limiter.getTailLengthInSamples())
+    {
+        if (! skippingSilence)
+        {
+            oversampling.reset();
+            multiband.reset();
+            waveshaper.reset();
+            cabinet.reset();
+            limiter.reset();
+            skippingSilence = true;
+        }
+
+        return true;
+    }
+
+    silentSamples += (int) block.getNumSamples();
+    return false;
+}
+
+template <typename SampleType>
+void DistortionEffectProjectAudioProcessor::processBypassedSamples (AudioBuffer<SampleType>& buffer) noexcept
+{
+    auto totalNumInputChannels = getTotalNumInputChannels();
+
+    for (auto i = totalNumInputChannels; i < getTotalNumOutputChannels(); ++i)
+        buffer.clear (i, 0, buffer.getNumSamples());
+
+    auto settings = readSettings();
+    auto& oversampling = getOversampling<SampleType>();
+    auto limiterSwitched = limiter.setEnabled (settings.limiter);
+    auto shaperSwitched = waveshaper.setLatency (settings.shaperLatency);
+
+    if (updateOversamplingMode<SampleType> (settings) || limiterSwitched || shaperSwitched)
+        setLatencySamples (oversampling.getLatencyInSamples() + waveshaper.getLatencyInSamples() + limiter.getLatencyInSamples());
+
+    // With oversampling, second order ADAA or the limiter on, the bypassed signal still has to
+    // arrive as late as the processed one would, otherwise the host's delay compensation is off.
+    auto block = dsp::AudioBlock<SampleType> (buffer).getSubsetChannelBlock (0, (size_t) totalNumInputChannels);
+
+    if (oversampling.getLatencyInSamples() > 0)
+        oversampling.processBypassed (block);
+
+    if (waveshaper.getLatencyInSamples() > 0)
+    {
+        SampleType* channels[Waveshaper::maxChannels];
+        auto numChannels = jmin ((int) block.getNumChannels(), Waveshaper::maxChannels);
+
+        for (int channel = 0; channel < numChannels; ++channel)
+            channels[channel] = block.getChannelPointer ((size_t) channel);
+
+        waveshaper.delayUnshaped (channels, numChannels, (int) block.getNumSamples());
+    }
+
+    limiter.setCeiling (settings.ceiling);
+    limiter.processBypassed (block);
+
+    // The crossovers, the ADAA and the cabinet pick up again from silence rather than from where they
+    // stopped. The limiter's detector kept running, so it doesn't need to.
+    getMultiband<SampleType>().reset();
+    waveshaper.reset();
+    cabinet.reset();
+
+    silentSamples = 0;
+    skippingSilence = false;
+}
+
+template <typename SampleType>
+bool DistortionEffectProjectAudioProcessor::isSilent (const dsp::AudioBlock<SampleType>& block) noexcept
+{
+    for (size_t channel = 0; channel < block.getNumChannels(); ++channel)
+    {
+        auto range = FloatVectorOperations::findMinAndMax (block.getChannelPointer (channel), (int) block.getNumSamples());
+
+        if (range.getStart() != (SampleType) 0 || range.getEnd() != (SampleType) 0)
+            return false;
+    }
+
+    return true;
+}
+
+//==============================================================================
+bool DistortionEffectProjectAudioProcessor::hasEditor() const
+{
+    return true; // (change this to false if you choose to not supply an editor)
+}
+
+juce::AudioProcessorEditor* DistortionEffectProjectAudioProcessor::createEditor()
+{
+    return new DistortionEffectProjectAudioProcessorEditor (*this);
+}
+
+//==============================================================================
+void DistortionEffectProjectAudioProcessor::getStateInformation (juce::MemoryBlock& destData)
+{
+    // A few bytes per parameter instead of an XML document, see PluginState.h
+    NamedValueSet extras;
+    extras.set ("program", getCurrentProgram());
+
+    auto target = readMorphTarget();
+
+    for (auto& field : presetFields)
+        extras.set ("morphB_" + String (field.first), target.*field.second);
+
+    if (cabinet.hasImpulseResponse())
+        extras.set ("cabinetFile", cabinet.getImpulseResponseFile().getFullPathName());
+
+    PluginState::write (*this, extras, destData);
+}
+
+void DistortionEffectProjectAudioProcessor::setStateInformation (const void* data, int sizeInBytes)
+{
+    // Parsed (and migrated) before anything is touched, so a bad blob changes nothing
+    NamedValueSet values;
+
+    if (! PluginState::read (data, sizeInBytes, values))
+        return;
+
+    // A program change from another thread that hasn't been picked up is older than this state
+    pendingProgram.store (-1, std::memory_order_relaxed);
+
+    // The parameters are set one by one. The audio thread sees none of the new
+    // values until all of them are in place, and the value tree state picks them
+    // up through its parameter listeners as usual.
+    restoreSequence.beginWrite();
+    PluginState::apply (*this, values);
+
+    PlainParameters target;
+
+    for (auto& field : presetFields)
+        if (auto* value = values.getVarPointer ("morphB_" + String (field.first)))
+            target.*field.second = (float) *value;
+
+    writeMorphTarget (target);
+    restoreSequence.endWrite();
+
+    // And so is one that has, once the parameters hold the state
+    dropPendingProgram();
+
+    if (auto* program = values.getVarPointer ("program"))
+        currentProgram.store (jlimit (0, getNumPrograms() - 1, (int) *program), std::memory_order_relaxed);
+
+    // A path that no longer exists leaves the cabinet empty rather than failing the whole restore
+    auto* cabinetFile = values.getVarPointer ("cabinetFile");
+
+    if (cabinetFile != nullptr && File::isAbsolutePath (cabinetFile->toString()) && File (cabinetFile->toString()).existsAsFile())
+        cabinet.loadImpulseResponse (File (cabinetFile->toString()));
+    else
+        cabinet.clearImpulseResponse();
+}
+
+//==============================================================================
+bool DistortionEffectProjectAudioProcessor::loadCabinet (const File& impulseResponse)
+{
+    if (! cabinet.loadImpulseResponse (impulseResponse))
+        return false;
+
+    if (auto* parameter = treeState.getParameter ("cabinet"))
+        parameter->setValueNotifyingHost (1.0f);
+
+    return true;
+}
+
+void DistortionEffectProjectAudioProcessor::clearCabinet()
+{
+    cabinet.clearImpulseResponse();
+}
+
+//==============================================================================
+// This creates new instances of the plugin..
+juce::AudioProcessor* JUCE_CALLTYPE createPluginFilter()
+{
+    return new DistortionEffectProjectAudioProcessor();
+}
@@ -1,71 +1,266 @@
-/*
-  ==============================================================================
-
-    This file contains the basic framework code for a JUCE plugin processor.
-
-  ==============================================================================
-*/
-
-#pragma once
-
-#include <JuceHeader.h>
-using namespace juce;
-
-//==============================================================================
-/**
-*/
-
-class DistortionEffectProjectAudioProcessor  : public AudioProcessor
-                                                
-{
-public:
-    //==============================================================================
-    DistortionEffectProjectAudioProcessor();
-    ~DistortionEffectProjectAudioProcessor() override;
-
-    //==============================================================================
-    void prepareToPlay (double sampleRate, int samplesPerBlock) override;
-    void releaseResources() override;
-
-   #ifndef JucePlugin_PreferredChannelConfigurations
-    bool isBusesLayoutSupported (const BusesLayout& layouts) const override;
-   #endif
-
-    void processBlock (juce::AudioBuffer<float>&, juce::MidiBuffer&) override;
-
-    //==============================================================================
-    juce::AudioProcessorEditor* createEditor() override;
-    bool hasEditor() const override;
-
-    //==============================================================================
-    const juce::String getName() const override;
-
-    bool acceptsMidi() const override;
-    bool producesMidi() const override;
-    bool isMidiEffect() const override;
-    double getTailLengthSeconds() const override;
-
-    //==============================================================================
-    int getNumPrograms() override;
-    int getCurrentProgram() override;
-    void setCurrentProgram (int index) override;
-    const juce::String getProgramName (int index) override;
-    void changeProgramName (int index, const juce::String& newName) override;
-
-    //==============================================================================
-    void getStateInformation (juce::MemoryBlock& destData) override;
-    void setStateInformation (const void* data, int sizeInBytes) override;
-    
-    static AudioProcessorValueTreeState::ParameterLayout createParameterLayout();
-    
-//    double drive;
-//    double outputLvl;
-//    double wet;
-//    double dry;
-//    double threshold;
-    AudioProcessorValueTreeState treeState;
-
-private:
-    //==============================================================================
-    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (DistortionEffectProjectAudioProcessor)
-};
+/*
+  ==============================================================================
+
+    This file contains the basic framework code for a JUCE plugin processor.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "ParameterSnapshot.h"
+#include "OversamplingStage.h"
+#include "MultibandStage.h"
+#include "CabinetStage.h"
+#include "LimiterStage.h"
+#include "QualityGovernor.h"
+#include "AudioArena.h"
+#include "MeterSource.h"
+#include "PerformanceMonitor.h"
+#include "PluginState.h"
+#include "PresetBank.h"
+using namespace juce;
+
+//==============================================================================
+/**
+*/
+
+class DistortionEffectProjectAudioProcessor  : public AudioProcessor,
+                                               private AsyncUpdater
+{
+public:
+    //==============================================================================
+    DistortionEffectProjectAudioProcessor();
+    ~DistortionEffectProjectAudioProcessor() override;
+
+    //==============================================================================
+    void prepareToPlay (double sampleRate, int samplesPerBlock) override;
+    void releaseResources() override;
+
+   #ifndef JucePlugin_PreferredChannelConfigurations
+    bool isBusesLayoutSupported (const BusesLayout& layouts) const override;
+   #endif
+
+    void processBlock (juce::AudioBuffer<float>&, juce::MidiBuffer&) override;
+    void processBlock (juce::AudioBuffer<double>&, juce::MidiBuffer&) override;
+    void processBlockBypassed (juce::AudioBuffer<float>&, juce::MidiBuffer&) override;
+    void processBlockBypassed (juce::AudioBuffer<double>&, juce::MidiBuffer&) override;
+    bool supportsDoublePrecisionProcessing() const override;
+
+    //==============================================================================
+    juce::AudioProcessorEditor* createEditor() override;
+    bool hasEditor() const override;
+
+    //==============================================================================
+    const juce::String getName() const override;
+
+    bool acceptsMidi() const override;
+    bool producesMidi() const override;
+    bool isMidiEffect() const override;
+    double getTailLengthSeconds() const override;
+
+    //==============================================================================
+    int getNumPrograms() override;
+    int getCurrentProgram() override;
+    void setCurrentProgram (int index) override;
+    const juce::String getProgramName (int index) override;
+    void changeProgramName (int index, const juce::String& newName) override;
+
+    //==============================================================================
+    void getStateInformation (juce::MemoryBlock& destData) override;
+    void setStateInformation (const void* data, int sizeInBytes) override;
+    
+    static AudioProcessorValueTreeState::ParameterLayout createParameterLayout();
+    
+//    double drive;
+//    double outputLvl;
+//    double wet;
+//    double dry;
+//    double threshold;
+    AudioProcessorValueTreeState treeState;
+
+    /** Levels for the editor. Only measured while something has enabled it. */
+    MeterSource& getMeterSource() noexcept      { return meters; }
+
+   #if HYPERBOLIC_ENABLE_INSTRUMENTATION
+    /** Block timings, deadline misses and the flight recorder. */
+    PerformanceMonitor& getPerformanceMonitor() noexcept        { return performance; }
+   #endif
+
+    /** The parameters as linear gains, straight from the value tree state with the
+        A/B morph applied (no smoothing).
+    */
+    DistortionParameters getCurrentParameters() const noexcept      { return readTargets(); }
+
+    /** The programs the host sees, for the editor's preset menu. */
+    PresetBank& getPresetBank() noexcept        { return presets; }
+
+    /** Message thread: saves the current settings as a user preset and makes it the
+        current program. Returns its program index, or -1 if it couldn't be saved.
+    */
+    int saveUserPreset (const String& name);
+
+    /** Message thread: makes the current settings the B side of the A/B morph. */
+    void storeMorphTarget();
+
+    /** Message thread: loads a cabinet impulse response in the background, see CabinetStage,
+        and switches the "cabinet" parameter on - or returns false if the file can't be read.
+        The parameter switches it in and out, the file is saved with the state.
+    */
+    bool loadCabinet (const File& impulseResponse);
+    void clearCabinet();
+    File getCabinetFile() const        { return cabinet.getImpulseResponseFile(); }
+
+    /** The quality tier the last block ran at: a QualityGovernor::Tier, or offlineTier
+        while rendering offline. Safe to call from any thread.
+    */
+    int getQualityTier() const noexcept     { return shownTier.load (std::memory_order_relaxed); }
+    static String getQualityTierName (int tier);
+
+    static constexpr int offlineTier = -1;
+
+private:
+    //==============================================================================
+    ParameterSnapshot parameters;
+    std::atomic<float>* accuracyParam = nullptr;
+    std::atomic<float>* oversamplingParam = nullptr;
+    std::atomic<float>* oversamplingFilterParam = nullptr;
+    std::atomic<float>* antialiasingParam = nullptr;
+
+    // The working buffers of every stage below, allocated in prepareToPlay and freed in releaseResources
+    AudioArena arena;
+
+    OversamplingStage<float> floatOversampling;
+    OversamplingStage<double> doubleOversampling;
+    MultibandStage<float> floatMultiband;
+    MultibandStage<double> doubleMultiband;
+
+    std::atomic<float>* bandsParam = nullptr;
+    std::atomic<float>* crossoverParams[MultibandStage<float>::maxBands - 1] = {};
+    std::atomic<float>* bandDriveParams[MultibandStage<float>::maxBands] = {};
+    std::atomic<float>* bandThresholdParams[MultibandStage<float>::maxBands] = {};
+    std::atomic<float>* bandLevelParams[MultibandStage<float>::maxBands] = {};
+    Waveshaper waveshaper;
+
+    CabinetStage cabinet;
+    std::atomic<float>* cabinetParam = nullptr;
+
+    // The true peak limiter at the end, see LimiterStage. Its lookahead counts towards the latency.
+    LimiterStage limiter;
+    std::atomic<float>* limiterParam = nullptr;
+    std::atomic<float>* ceilingParam = nullptr;
+
+    // Steps the curve and the ADAA down when blocks get close to their deadline, see QualityGovernor
+    QualityGovernor governor;
+    std::atomic<float>* autoQualityParam = nullptr;
+    std::atomic<int> shownTier { QualityGovernor::full };
+    class QualityTierParameter;
+    QualityTierParameter* tierParameter = nullptr;      // shows shownTier to the host
+
+    MeterSource meters;
+   #if HYPERBOLIC_ENABLE_INSTRUMENTATION
+    PerformanceMonitor performance;
+   #endif
+    int preparedBlockSize = 512;
+    int silentSamples = 0;          // how long the input has been digital silence
+    bool skippingSilence = false;
+
+    // Everything the audio thread takes from the parameters, read in one go
+    struct Settings
+    {
+        DistortionParameters targets;
+        int accuracy = 1;
+        int antialiasing = 0;       // 0 = off, otherwise the ADAA order
+        int oversampling = 0;
+        OversamplingOptions::Filter oversamplingFilter = OversamplingOptions::Filter::iirMinimumPhase;
+        int numBands = 1;
+        BandSettings bands[MultibandStage<float>::maxBands];
+        float crossovers[MultibandStage<float>::maxBands - 1] = {};
+        bool cabinet = false;
+        bool limiter = false;
+        float ceiling = 1.0f;       // as a gain
+        bool autoQuality = true;
+        int shaperLatency = 0;      // see Waveshaper::setLatency
+    };
+
+    PluginState::Sequence restoreSequence;
+    Settings lastSettings;
+
+    /** Audio thread. Never returns a half restored state, and has the quality tier applied. */
+    Settings readSettings() noexcept;
+
+    /** Offline renders get the exact curve and ADAA, live ones what the governor allows. */
+    void applyQuality (Settings& settings) const noexcept;
+
+    // Programs. Switching only sets the five parameters (inside restoreSequence, so
+    // the audio thread picks them up together), and the usual parameter smoothing
+    // takes it from there - nothing is reloaded or reset.
+    PresetBank presets;
+    std::atomic<int> currentProgram { 0 };
+    RangedAudioParameter* presetParameters[5] = {};
+
+    // Program changes from another thread (see setCurrentProgram) go straight into the
+    // next block's targets, and the parameters catch up on the message thread. Until they
+    // have, programPickups and programSyncs differ and the block runs with programValues.
+    std::atomic<int> pendingProgram { -1 };     // from another thread, for the next block
+    std::atomic<int> programToSync { -1 };      // picked up by a block, for handleAsyncUpdate
+    std::atomic<uint32> programPickups { 0 }, programSyncs { 0 };
+    PlainParameters programValues;              // audio thread
+
+    /** Message thread: sets the five parameters to a program's values. */
+    void loadProgram (int index);
+
+    /** Message thread: forgets any program change from another thread, the parameters win. */
+    void dropPendingProgram() noexcept;
+
+    /** Audio thread: the five parameters, or the program that was just switched to. */
+    PlainParameters readPlainValues() noexcept;
+
+    /** Has handleAsyncUpdate run, at once if this is the message thread already. */
+    void updateOnMessageThread() noexcept;
+
+    /** Brings the parameters in line with a program the audio thread switched to, and
+        shows the host the current quality tier.
+    */
+    void handleAsyncUpdate() override;
+
+    // The A/B morph: the knobs are A, morphTarget is B, in dB and percent
+    std::atomic<float>* morphParam = nullptr;
+    std::atomic<float> morphTarget[5];
+
+    void applyPreset (const PlainParameters& values);
+    PlainParameters readMorphTarget() const noexcept;
+    void writeMorphTarget (const PlainParameters& values) noexcept;
+    DistortionParameters readTargets() const noexcept;
+    DistortionParameters readTargets (const PlainParameters& values) const noexcept;
+
+    // Both processBlock overloads share this, so there is one copy of the signal path
+    template <typename SampleType>
+    void processSamples (AudioBuffer<SampleType>& buffer) noexcept;
+
+    template <typename SampleType>
+    void processBypassedSamples (AudioBuffer<SampleType>& buffer) noexcept;
+
+    template <typename SampleType>
+    bool canSkipBlock (const dsp::AudioBlock<SampleType>& block, OversamplingStage<SampleType>& oversampling,
+                       MultibandStage<SampleType>& multiband) noexcept;
+
+    template <typename SampleType>
+    static bool isSilent (const dsp::AudioBlock<SampleType>& block) noexcept;
+
+    /** Hands every stage its buffers from the arena, see AudioArena. */
+    void takeWorkingMemory() noexcept;
+
+    template <typename SampleType>
+    OversamplingStage<SampleType>& getOversampling() noexcept;
+
+    template <typename SampleType>
+    MultibandStage<SampleType>& getMultiband() noexcept;
+
+    template <typename SampleType>
+    bool updateOversamplingMode (const Settings& settings) noexcept;
+
+    //==============================================================================
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (DistortionEffectProjectAudioProcessor)
+};
@@ -0,0 +1,210 @@
+/*
+  ==============================================================================
+
+    PluginState.cpp
+
+  ==============================================================================
+*/
+
+#include "PluginState.h"
+
+namespace PluginState
+{
+
+namespace
+{
+    // "HypD" once written little endian
+    constexpr int magic = 'H' | ('y' << 8) | ('p' << 16) | ('D' << 24);
+    constexpr int headerSize = 8;
+
+    bool readBinary (const void* data, int sizeInBytes, NamedValueSet& values, int& version)
+    {
+        MemoryInputStream input (data, (size_t) sizeInBytes, false);
+
+        if (sizeInBytes < headerSize || input.readInt() != magic)
+            return false;
+
+        version = input.readShort();
+        auto count = (int) (uint16) input.readShort();
+
+        for (int i = 0; i < count; ++i)
+        {
+            auto idLength = (int) (uint8) input.readByte();
+
+            if (input.getNumBytesRemaining() < idLength + (int) sizeof (float))
+                return true;    // truncated, keep what was read so far
+
+            HeapBlock<char> id ((size_t) idLength + 1, true);
+            input.read (id.get(), idLength);
+            auto value = input.readFloat();
+
+            values.set (Identifier (String::fromUTF8 (id.get(), idLength)), value);
+        }
+
+        if (input.getNumBytesRemaining() < (int) sizeof (short))
+            return true;
+
+        auto textCount = (int) (uint16) input.readShort();
+
+        for (int i = 0; i < textCount; ++i)
+        {
+            auto idLength = (int) (uint8) input.readByte();
+
+            if (input.getNumBytesRemaining() < idLength + (int) sizeof (int))
+                break;
+
+            HeapBlock<char> id ((size_t) idLength + 1, true);
+            input.read (id.get(), idLength);
+            auto textLength = input.readInt();
+
+            if (textLength < 0 || input.getNumBytesRemaining() < textLength)
+                break;
+
+            HeapBlock<char> text ((size_t) textLength + 1, true);
+            input.read (text.get(), textLength);
+
+            values.set (Identifier (String::fromUTF8 (id.get(), idLength)), String::fromUTF8 (text.get(), textLength));
+        }
+
+        return true;
+    }
+
+    /** Read only parameters are readouts (the quality tier), not something to restore. */
+    bool isStored (const RangedAudioParameter& parameter)
+    {
+        return parameter.isAutomatable();
+    }
+
+    /** The format before version 1: the value tree state as XML, one PARAM child per parameter. */
+    bool readXml (const void* data, int sizeInBytes, NamedValueSet& values)
+    {
+        auto xml = AudioProcessor::getXmlFromBinary (data, sizeInBytes);
+
+        if (xml == nullptr || ! xml->hasTagName ("saveParameters"))
+            return false;
+
+        for (auto* param : xml->getChildWithTagNameIterator ("PARAM"))
+            if (param->hasAttribute ("id") && param->hasAttribute ("value"))
+                values.set (Identifier (param->getStringAttribute ("id")), (float) param->getDoubleAttribute ("value"));
+
+        return true;
+    }
+}
+
+//==============================================================================
+void write (const AudioProcessor& processor, const NamedValueSet& extraValues, MemoryBlock& destData)
+{
+    MemoryOutputStream output (destData, false);
+    Array<RangedAudioParameter*> parameters;
+
+    for (auto* parameter : processor.getParameters())
+    {
+        auto* ranged = dynamic_cast<RangedAudioParameter*> (parameter);
+        jassert (ranged != nullptr);
+
+        if (isStored (*ranged))
+            parameters.add (ranged);
+    }
+
+    int numTexts = 0;
+
+    for (auto& extra : extraValues)
+        if (extra.value.isString())
+            ++numTexts;
+
+    output.writeInt (magic);
+    output.writeShort ((short) currentVersion);
+    output.writeShort ((short) (parameters.size() + extraValues.size() - numTexts));
+
+    auto writeId = [&output] (const String& id)
+    {
+        auto utf8 = id.toUTF8();
+        auto idLength = jmin ((int) utf8.sizeInBytes() - 1, 255);
+
+        output.writeByte ((char) idLength);
+        output.write (utf8.getAddress(), (size_t) idLength);
+    };
+
+    auto writeRecord = [&] (const String& id, float value)
+    {
+        writeId (id);
+        output.writeFloat (value);
+    };
+
+    for (auto* parameter : parameters)
+        writeRecord (parameter->getParameterID(), parameter->convertFrom0to1 (parameter->getValue()));
+
+    for (auto& extra : extraValues)
+        if (! extra.value.isString())
+            writeRecord (extra.name.toString(), (float) extra.value);
+
+    if (numTexts == 0)
+        return;
+
+    output.writeShort ((short) numTexts);
+
+    for (auto& extra : extraValues)
+    {
+        if (extra.value.isString())
+        {
+            auto utf8 = extra.value.toString().toUTF8();
+            auto textLength = (int) utf8.sizeInBytes() - 1;
+
+            writeId (extra.name.toString());
+            output.writeInt (textLength);
+            output.write (utf8.getAddress(), (size_t) textLength);
+        }
+    }
+}
+
+bool read (const void* data, int sizeInBytes, NamedValueSet& values)
+{
+    if (data == nullptr || sizeInBytes <= 0)
+        return false;
+
+    int version = 0;
+
+    if (! readBinary (data, sizeInBytes, values, version))
+    {
+        if (! readXml (data, sizeInBytes, values))
+            return false;
+
+        version = 0;
+    }
+
+    // Blobs from a newer version are read as they are: the ids this version
+    // doesn't know are ignored and everything else still means the same.
+    if (version < currentVersion)
+        migrate (version, values);
+
+    return true;
+}
+
+void apply (AudioProcessor& processor, const NamedValueSet& values)
+{
+    for (auto* parameter : processor.getParameters())
+    {
+        auto* ranged = dynamic_cast<RangedAudioParameter*> (parameter);
+
+        if (ranged != nullptr && isStored (*ranged))
+        {
+            auto* value = values.getVarPointer (ranged->getParameterID());
+            ranged->setValueNotifyingHost (value != nullptr ? ranged->convertTo0to1 ((float) *value)
+                                                            : ranged->getDefaultValue());
+        }
+    }
+}
+
+void migrate (int fromVersion, NamedValueSet& values)
+{
+    ignoreUnused (values);
+
+    // One case per version, falling through so an old blob goes through every step
+    switch (fromVersion)
+    {
+        case 0:     // XML, same parameters and units as version 1
+        default:    break;
+    }
+}
+
+} // namespace PluginState
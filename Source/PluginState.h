@@ -0,0 +1,84 @@
+/*
+  ==============================================================================
+
+    PluginState.h
+
+    The plugin's saved state: a small binary blob with a version number and
+    one (parameter id, value) record per parameter, and the XML written by
+    earlier versions still loads. Values are stored in their real units (dB,
+    percent, choice index) so they keep their meaning even if a range changes.
+
+        "HypD"      magic, 4 bytes
+        version     int16
+        count       int16
+        count x     { id length uint8, id bytes, value float32 }
+
+    optionally followed by text values, such as file paths:
+
+        count       int16
+        count x     { id length uint8, id bytes, text length int32, UTF-8 bytes }
+
+    Everything is little endian. Ids a version doesn't know about are skipped,
+    and parameters a blob doesn't mention are reset to their defaults. Versions
+    that predate the text values stop reading after the numbers.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+using namespace juce;
+
+namespace PluginState
+{
+    /** Bump this when a parameter's meaning changes, and add a step to migrate(). */
+    constexpr int currentVersion = 1;
+
+    /** Writes every parameter of the processor but the read only ones into destData in
+        the binary format, followed by extraValues - state that isn't a parameter, stored
+        the same way, or as text if the value is a string.
+    */
+    void write (const AudioProcessor& processor, const NamedValueSet& extraValues, MemoryBlock& destData);
+
+    /** Reads a binary or legacy XML blob into id -> value pairs, already migrated to
+        the current version. Returns false if the data is neither.
+    */
+    bool read (const void* data, int sizeInBytes, NamedValueSet& values);
+
+    /** Sets every parameter of the processor but the read only ones from values, or to
+        its default if it's missing. Anything in values that isn't a parameter is left
+        for the caller.
+    */
+    void apply (AudioProcessor& processor, const NamedValueSet& values);
+
+    /** Brings values saved by an older version up to date. Version 0 is the old XML. */
+    void migrate (int fromVersion, NamedValueSet& values);
+
+    //==============================================================================
+    /** Lets the audio thread see a restored state all at once.
+
+        Restoring sets the parameters one after the other. The message thread
+        wraps that in beginWrite() / endWrite(), and the audio thread checks
+        with beginRead() / isConsistent() that no restore was running while it
+        read the parameters - if one was, it keeps using the previous set for
+        another block instead of running with a mix of old and new values.
+    */
+    class Sequence
+    {
+    public:
+        void beginWrite() noexcept                  { counter.fetch_add (1, std::memory_order_acq_rel); }
+        void endWrite() noexcept                    { counter.fetch_add (1, std::memory_order_release); }
+
+        uint32 beginRead() const noexcept           { return counter.load (std::memory_order_acquire); }
+
+        bool isConsistent (uint32 readStart) const noexcept
+        {
+            std::atomic_thread_fence (std::memory_order_acquire);
+            return (readStart & 1) == 0 && counter.load (std::memory_order_relaxed) == readStart;
+        }
+
+    private:
+        std::atomic<uint32> counter { 0 };
+    };
+}
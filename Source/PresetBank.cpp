@@ -0,0 +1,257 @@
+/*
+  ==============================================================================
+
+    PresetBank.cpp
+
+  ==============================================================================
+*/
+
+#include "PresetBank.h"
+
+namespace
+{
+    struct FactoryPreset
+    {
+        const char* name;
+        PlainParameters values;     // drive dB, output dB, wet %, dry %, threshold dB
+    };
+
+    // Compiled into the plugin's read only data, so like the user file these are
+    // only paged in once something looks at them.
+    constexpr FactoryPreset factoryPresets[] =
+    {
+        { "Init",               {  0.0f,  0.0f,  50.0f,  50.0f,   1.0f } },
+        { "Gentle Warmth",      {  4.0f, -1.0f,  35.0f,  65.0f,   1.0f } },
+        { "Tape Glue",          {  8.0f, -3.0f,  50.0f,  50.0f,   0.0f } },
+        { "Soft Clip",          {  6.0f,  0.0f, 100.0f,   0.0f,  -3.0f } },
+        { "Crunch",             { 14.0f, -5.0f,  70.0f,  30.0f,  -2.0f } },
+        { "Parallel Grit",      { 20.0f, -6.0f,  30.0f, 100.0f,  -4.0f } },
+        { "Full Drive",         { 18.0f, -6.0f, 100.0f,   0.0f,   0.0f } },
+        { "Hard Clip",          { 24.0f, -4.0f, 100.0f,   0.0f, -10.0f } },
+        { "Fuzz Wall",          { 30.0f, -8.0f, 100.0f,   0.0f,  -6.0f } },
+        { "Lo-Fi Squash",       { 28.0f, -2.0f,  80.0f,  20.0f, -18.0f } }
+    };
+
+    constexpr int numFactoryPresets = (int) (sizeof (factoryPresets) / sizeof (factoryPresets[0]));
+
+    // "HypP" once written little endian
+    constexpr int magic = 'H' | ('y' << 8) | ('p' << 16) | ('P' << 24);
+    constexpr int version = 1;
+
+    float readFloat (const char* bytes) noexcept
+    {
+        auto bits = ByteOrder::littleEndianInt (bytes);
+        float value;
+        std::memcpy (&value, &bits, sizeof (value));
+        return value;
+    }
+}
+
+//==============================================================================
+PresetBank::PresetBank (const File& userPresetFile)
+    : userFile (userPresetFile)
+{
+}
+
+File PresetBank::getDefaultUserPresetFile()
+{
+    return File::getSpecialLocation (File::userApplicationDataDirectory)
+               .getChildFile ("Hyperbolic Distortion")
+               .getChildFile ("UserPresets.bin");
+}
+
+int PresetBank::getNumFactoryPresets() noexcept
+{
+    return numFactoryPresets;
+}
+
+int PresetBank::getNumPresets() const
+{
+    const ScopedLock sl (lock);
+    mapUserPresets();
+    return numFactoryPresets + numUserPresets;
+}
+
+String PresetBank::getName (int index) const
+{
+    if (isFactoryPreset (index))
+        return factoryPresets[index].name;
+
+    const ScopedLock sl (lock);
+    mapUserPresets();
+
+    if (auto* record = getRecord (index - numFactoryPresets))
+        return String::fromUTF8 (record, (int) strnlen (record, (size_t) nameSize));
+
+    return {};
+}
+
+bool PresetBank::getValues (int index, PlainParameters& values) const
+{
+    if (isFactoryPreset (index))
+    {
+        values = factoryPresets[index].values;
+        return true;
+    }
+
+    const ScopedLock sl (lock);
+    mapUserPresets();
+    return readRecord (index, values);
+}
+
+bool PresetBank::tryGetValues (int index, PlainParameters& values) const noexcept
+{
+    if (isFactoryPreset (index))
+    {
+        values = factoryPresets[index].values;
+        return true;
+    }
+
+    const ScopedTryLock sl (lock);
+    return sl.isLocked() && mapped && readRecord (index, values);
+}
+
+int PresetBank::addUserPreset (const String& name, const PlainParameters& values)
+{
+    const ScopedLock sl (lock);
+    mapUserPresets();
+
+    // A file this version can't read is left alone rather than overwritten
+    auto isNewFile = userFile.getSize() == 0;
+
+    if (! isNewFile && userMap == nullptr)
+        return -1;
+
+    if (isNewFile && ! userFile.getParentDirectory().createDirectory())
+        return -1;
+
+    // A mapped file can't grow, so it's let go of while the record is appended
+    userMap.reset();
+    mapped = false;
+
+    bool written = false;
+
+    {
+        FileOutputStream output (userFile);
+
+        if (output.openedOk())
+        {
+            if (isNewFile)
+            {
+                output.writeInt (magic);
+                output.writeInt (version);
+                output.writeInt (recordSize);
+                output.writeInt (0);
+            }
+
+            // Always at a record boundary, even if an earlier write was cut short
+            output.setPosition (headerSize + (int64) numUserPresets * recordSize);
+            writeName (output, name);
+
+            for (auto value : { values.drive, values.outputLvl, values.wet, values.dry, values.threshold })
+                output.writeFloat (value);
+
+            output.flush();
+            written = output.getStatus().wasOk();
+        }
+    }
+
+    mapUserPresets();
+    return written ? numFactoryPresets + numUserPresets - 1 : -1;
+}
+
+bool PresetBank::renameUserPreset (int index, const String& newName)
+{
+    const ScopedLock sl (lock);
+    mapUserPresets();
+
+    auto userIndex = index - numFactoryPresets;
+
+    if (userIndex < 0 || userIndex >= numUserPresets)
+        return false;
+
+    userMap.reset();
+    mapped = false;
+
+    bool written = false;
+
+    {
+        FileOutputStream output (userFile);
+
+        if (output.openedOk() && output.setPosition (headerSize + (int64) userIndex * recordSize))
+        {
+            writeName (output, newName);
+            output.flush();
+            written = output.getStatus().wasOk();
+        }
+    }
+
+    mapUserPresets();
+    return written;
+}
+
+//==============================================================================
+void PresetBank::mapUserPresets() const
+{
+    if (mapped)
+        return;
+
+    mapped = true;
+    numUserPresets = 0;
+
+    if (! userFile.existsAsFile())
+        return;
+
+    userMap = std::make_unique<MemoryMappedFile> (userFile, MemoryMappedFile::readOnly, false);
+
+    auto* data = static_cast<const char*> (userMap->getData());
+    auto size = (int64) userMap->getSize();
+
+    if (data == nullptr || size < headerSize
+         || (int) ByteOrder::littleEndianInt (data) != magic
+         || (int) ByteOrder::littleEndianInt (data + 8) != recordSize)
+    {
+        userMap.reset();
+        return;
+    }
+
+    numUserPresets = (int) ((size - headerSize) / recordSize);
+}
+
+bool PresetBank::readRecord (int index, PlainParameters& values) const noexcept
+{
+    auto* record = getRecord (index - numFactoryPresets);
+
+    if (record == nullptr)
+        return false;
+
+    record += nameSize;
+    values.drive     = readFloat (record);
+    values.outputLvl = readFloat (record + 4);
+    values.wet       = readFloat (record + 8);
+    values.dry       = readFloat (record + 12);
+    values.threshold = readFloat (record + 16);
+    return true;
+}
+
+const char* PresetBank::getRecord (int userIndex) const noexcept
+{
+    if (userMap == nullptr || userIndex < 0 || userIndex >= numUserPresets)
+        return nullptr;
+
+    return static_cast<const char*> (userMap->getData()) + headerSize + (size_t) userIndex * recordSize;
+}
+
+void PresetBank::writeName (OutputStream& output, const String& name)
+{
+    // Cut at a character boundary so the name is still valid UTF-8, and always
+    // leave room for at least one terminating zero
+    auto trimmed = name.trim();
+
+    while (trimmed.getNumBytesAsUTF8() >= (size_t) nameSize)
+        trimmed = trimmed.dropLastCharacters (1);
+
+    char bytes[nameSize] = {};
+    trimmed.copyToUTF8 (bytes, (size_t) nameSize);
+    output.write (bytes, (size_t) nameSize);
+}
@@ -0,0 +1,86 @@
+/*
+  ==============================================================================
+
+    PresetBank.h
+
+    The plugin's programs: the factory presets, which are compiled in, followed
+    by the user's own presets, which live in a file in the user's application
+    data folder.
+
+    The user file is a 16 byte header followed by fixed size records, and it is
+    memory mapped rather than read in. Opening a bank with hundreds of presets
+    costs nothing up front, only the records that are actually looked at get
+    paged in, and preset n is always at the same offset, so finding it never
+    means parsing the ones before it.
+
+        "HypP"      magic, 4 bytes
+        version     int32
+        record size int32
+        reserved    int32
+        n x         { name, 44 bytes of UTF-8 padded with zeros,
+                      drive, outputLvl, wet, dry, threshold as float32 }
+
+    Everything is little endian, and the values are in dB and percent.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "Core/DistortionParameters.h"
+using namespace juce;
+
+//==============================================================================
+class PresetBank
+{
+public:
+    explicit PresetBank (const File& userPresetFile = getDefaultUserPresetFile());
+
+    /** Where the user presets are kept unless the bank is told otherwise. */
+    static File getDefaultUserPresetFile();
+
+    /** Factory presets first, then the user presets. The first call maps the user file. */
+    int getNumPresets() const;
+    static int getNumFactoryPresets() noexcept;
+
+    bool isFactoryPreset (int index) const noexcept     { return index >= 0 && index < getNumFactoryPresets(); }
+
+    String getName (int index) const;
+
+    /** Copies a preset's values, or returns false if there's no such preset. */
+    bool getValues (int index, PlainParameters& values) const;
+
+    /** The same without ever waiting or touching the disk, for the audio thread:
+        factory presets always work, but while the user file is busy (or before
+        anything has mapped it) user presets are reported as unavailable.
+    */
+    bool tryGetValues (int index, PlainParameters& values) const noexcept;
+
+    /** Appends a user preset and returns its index, or -1 if the file couldn't be written. */
+    int addUserPreset (const String& name, const PlainParameters& values);
+
+    /** Renames a user preset in place. Factory presets can't be renamed. */
+    bool renameUserPreset (int index, const String& newName);
+
+    static constexpr int headerSize = 16;
+    static constexpr int nameSize = 44;
+    static constexpr int recordSize = nameSize + 5 * (int) sizeof (float);
+
+private:
+    /** These need the lock held. */
+    void mapUserPresets() const;
+    const char* getRecord (int userIndex) const noexcept;
+    bool readRecord (int index, PlainParameters& values) const noexcept;
+
+    static void writeName (OutputStream& output, const String& name);
+
+    File userFile;
+
+    CriticalSection lock;
+    mutable std::unique_ptr<MemoryMappedFile> userMap;
+    mutable int numUserPresets = 0;
+    mutable bool mapped = false;
+
+    JUCE_DECLARE_NON_COPYABLE (PresetBank)
+};
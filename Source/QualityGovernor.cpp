@@ -0,0 +1,112 @@
+/*
+  ==============================================================================
+
+    QualityGovernor.cpp
+
+  ==============================================================================
+*/
+
+#include "QualityGovernor.h"
+
+//==============================================================================
+void QualityGovernor::prepare (double newSampleRate, int samplesPerBlock) noexcept
+{
+    ignoreUnused (samplesPerBlock);     // the deadline scales with each block's own length
+
+    sampleRate = jmax (1.0, newSampleRate);
+    ticksPerSample = (double) Time::getHighResolutionTicksPerSecond() / sampleRate;
+    reset();
+}
+
+void QualityGovernor::reset() noexcept
+{
+    averageLoad = 0.0f;
+    samplesSinceChange = samplesSincePrepare = 0;
+    stepUpWait = stepUpSeconds;
+    lastStepWasUp = false;
+    setTier (full);
+}
+
+void QualityGovernor::endBlock (int64 startTicks, int numSamples, int accuracy, int antialiasing) noexcept
+{
+    if (numSamples <= 0)
+        return;
+
+    auto ticks = (double) (Time::getHighResolutionTicks() - startTicks);
+    auto load = (float) (ticks / (ticksPerSample * numSamples));
+
+    samplesSinceChange += numSamples;
+    samplesSincePrepare += numSamples;
+
+    if (samplesSincePrepare < (int64) (warmUpSeconds * sampleRate))
+        return;
+
+    // An average over about averagingSeconds whatever the block size
+    auto alpha = (float) (1.0 - std::exp (-numSamples / (averagingSeconds * sampleRate)));
+    averageLoad += alpha * (load - averageLoad);
+
+    auto secondsSinceChange = (double) samplesSinceChange / sampleRate;
+
+    if (averageLoad > stepDownLoad && secondsSinceChange >= holdSeconds)
+    {
+        auto lower = findTier (1, accuracy, antialiasing);
+
+        if (lower != tier)
+        {
+            // Stepped up too early, so wait longer next time
+            if (lastStepWasUp && secondsSinceChange < stepUpWait)
+                stepUpWait = jmin (stepUpWait * 2.0, maxStepUpSeconds);
+
+            lastStepWasUp = false;
+            setTier (lower);
+        }
+    }
+    else if (tier != full && averageLoad < stepUpLoad && secondsSinceChange >= stepUpWait)
+    {
+        lastStepWasUp = true;
+        setTier (findTier (-1, accuracy, antialiasing));
+    }
+    else if (tier == full && secondsSinceChange >= maxStepUpSeconds)
+    {
+        stepUpWait = stepUpSeconds;     // been fine for a long while
+    }
+}
+
+void QualityGovernor::apply (int tierToApply, int& accuracy, int& antialiasing) noexcept
+{
+    if (tierToApply >= fastCurve && accuracy == 0)
+        accuracy = 1;
+
+    if (tierToApply >= firstOrderAdaa)
+        antialiasing = jmin (antialiasing, 1);
+
+    if (tierToApply >= noAdaa)
+        antialiasing = 0;
+}
+
+//==============================================================================
+int QualityGovernor::findTier (int direction, int accuracy, int antialiasing) const noexcept
+{
+    auto changes = [&] (int candidate)
+    {
+        int a = accuracy, b = antialiasing, c = accuracy, d = antialiasing;
+        apply (candidate, a, b);
+        apply (tier, c, d);
+        return a != c || b != d;
+    };
+
+    // Down: the next tier that saves something. Up: the nearest one that sounds different,
+    // or full if none does (the settings have changed since stepping down).
+    for (auto candidate = tier + direction; candidate >= full && candidate < numTiers; candidate += direction)
+        if (changes (candidate))
+            return candidate;
+
+    return direction > 0 ? tier : (int) full;
+}
+
+void QualityGovernor::setTier (int newTier) noexcept
+{
+    tier = newTier;
+    samplesSinceChange = 0;
+    publishedTier.store (newTier, std::memory_order_relaxed);
+}
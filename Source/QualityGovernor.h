@@ -0,0 +1,96 @@
+/*
+  ==============================================================================
+
+    QualityGovernor.h
+
+    Trades quality for CPU when blocks come close to their deadline. Every
+    block's processing time is compared with how long the block lasts (the
+    budget prepareToPlay promised), and when the average gets too high the
+    governor steps down one tier at a time:
+
+        full                the settings as they are
+        fastCurve           Exact accuracy runs with the fast tanh instead
+        firstOrderAdaa      2nd order ADAA runs as 1st order
+        noAdaa              ADAA off as well
+
+    Tiers that wouldn't change anything with the current settings are skipped.
+    Stepping back up needs the load to stay well below the step down point for
+    a few seconds, and each time a step up doesn't hold the wait doubles, so
+    it settles instead of going back and forth. The waveshaper crossfades every
+    change of curve, so switching tiers isn't audible as a click.
+
+    Oversampling is never touched: changing the factor changes the latency,
+    and the host can't compensate for that mid-stream without a jump.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+using namespace juce;
+
+//==============================================================================
+class QualityGovernor
+{
+public:
+    enum Tier
+    {
+        full,
+        fastCurve,
+        firstOrderAdaa,
+        noAdaa,
+        numTiers
+    };
+
+    static constexpr float stepDownLoad = 0.5f;         // average time / deadline
+    static constexpr float stepUpLoad = 0.2f;
+    static constexpr double averagingSeconds = 0.1;
+    static constexpr double holdSeconds = 0.25;         // between steps down
+    static constexpr double stepUpSeconds = 3.0;        // doubled every time a step up doesn't hold...
+    static constexpr double maxStepUpSeconds = 60.0;    // ...up to this
+    static constexpr double warmUpSeconds = 0.5;        // the first blocks after prepare are always slow
+
+    QualityGovernor() = default;
+
+    /** Sets the deadline and goes back to full quality. */
+    void prepare (double sampleRate, int samplesPerBlock) noexcept;
+
+    /** Back to full quality, e.g. when the governor is switched off. */
+    void reset() noexcept;
+
+    /** Audio thread: call at the start of processBlock and pass the result to endBlock(). */
+    static int64 beginBlock() noexcept          { return Time::getHighResolutionTicks(); }
+
+    /** Audio thread: call at the end of processBlock. accuracy and antialiasing are the
+        settings before apply(), so the governor knows which tiers would make a difference.
+    */
+    void endBlock (int64 startTicks, int numSamples, int accuracy, int antialiasing) noexcept;
+
+    /** Audio thread: the tier the next block should run at. */
+    int getTier() const noexcept                { return tier; }
+
+    /** Any thread: the tier the last block ran at. */
+    int getPublishedTier() const noexcept       { return publishedTier.load (std::memory_order_relaxed); }
+
+    /** Lowers the "accuracy" parameter's index (exact, fast, table) and the ADAA order
+        to what tierToApply allows.
+    */
+    static void apply (int tierToApply, int& accuracy, int& antialiasing) noexcept;
+
+private:
+    int findTier (int direction, int accuracy, int antialiasing) const noexcept;
+    void setTier (int newTier) noexcept;
+
+    double ticksPerSample = 1.0;
+    double sampleRate = 44100.0;
+    float averageLoad = 0.0f;
+    int tier = full;
+    int64 samplesSinceChange = 0, samplesSincePrepare = 0;
+    double stepUpWait = stepUpSeconds;
+    bool lastStepWasUp = false;
+
+    std::atomic<int> publishedTier { full };
+
+    JUCE_DECLARE_NON_COPYABLE (QualityGovernor)
+};
@@ -0,0 +1,94 @@
+/*
+  ==============================================================================
+
+    SharedCache.h
+
+    A process-wide cache for immutable things that every plugin instance would
+    otherwise compute and store for itself: with a hundred instances in a
+    session, one copy instead of a hundred.
+
+    Entries are handed out as shared_ptr<const Value>. The cache itself only
+    keeps weak references, so an entry lives exactly as long as some instance
+    is holding it and is freed by whoever lets go of it last - which must never
+    be the audio thread. Thread safe; get() takes a lock, so it's for prepare
+    time and background threads only.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <map>
+#include <memory>
+using namespace juce;
+
+//==============================================================================
+template <typename Key, typename Value>
+class SharedCache
+{
+public:
+    SharedCache() = default;
+
+    /** The one cache for this key and value type in the whole process. */
+    static SharedCache& getInstance()
+    {
+        static SharedCache instance;
+        return instance;
+    }
+
+    /** Returns the entry for key, calling create() to make it if nobody holds one.
+        create() runs under the lock, so other threads asking for the same key wait
+        for it rather than computing it a second time.
+    */
+    template <typename Factory>
+    std::shared_ptr<const Value> get (const Key& key, Factory&& create)
+    {
+        const ScopedLock sl (lock);
+
+        auto& entry = entries[key];
+
+        if (auto existing = entry.lock())
+        {
+            ++numHits;
+            return existing;
+        }
+
+        std::shared_ptr<const Value> created (std::make_shared<Value> (create()));
+        entry = created;
+        ++numMisses;
+
+        removeExpired();
+        return created;
+    }
+
+    /** How many entries are alive right now, i.e. held by at least one instance. */
+    int getNumEntries() const
+    {
+        const ScopedLock sl (lock);
+        int count = 0;
+
+        for (auto& entry : entries)
+            if (! entry.second.expired())
+                ++count;
+
+        return count;
+    }
+
+    /** How often get() found an entry or had to create one, since the process started. */
+    int64 getNumHits() const noexcept       { return numHits.load(); }
+    int64 getNumMisses() const noexcept     { return numMisses.load(); }
+
+private:
+    void removeExpired()
+    {
+        for (auto it = entries.begin(); it != entries.end();)
+            it = it->second.expired() ? entries.erase (it) : std::next (it);
+    }
+
+    CriticalSection lock;
+    std::map<Key, std::weak_ptr<const Value>> entries;
+    std::atomic<int64> numHits { 0 }, numMisses { 0 };
+
+    JUCE_DECLARE_NON_COPYABLE (SharedCache)
+};
@@ -0,0 +1,291 @@
+/*
+  ==============================================================================
+
+    Waveshaper.cpp
+
+  ==============================================================================
+*/
+
+#include "Waveshaper.h"
+
+//==============================================================================
+Waveshaper::Waveshaper()
+{
+    // All plugin instances share one low priority thread for building tables
+    builderThread->addTimeSliceClient (this);
+}
+
+Waveshaper::~Waveshaper()
+{
+    // This waits for any table that is currently being built
+    builderThread->removeTimeSliceClient (this);
+}
+
+void Waveshaper::prepare (int numChannels, int maxSamplesPerCall)
+{
+    jassert (numChannels <= maxChannels);
+
+    crossfadeChannels = jlimit (1, maxChannels, numChannels);
+    crossfadeBufferSize = jmax (1, maxSamplesPerCall);
+
+    crossfading = false;
+    hasRun = false;
+    std::fill (std::begin (lastInputs), std::end (lastInputs), 0.0);
+    reset();
+}
+
+void Waveshaper::takeWorkingMemory (AudioArena& arena) noexcept
+{
+    crossfadeBuffer = arena.allocate<double> ((size_t) (crossfadeChannels * crossfadeBufferSize));
+}
+
+//==============================================================================
+void Waveshaper::beginBlock (const DistortionParameters& start, const DistortionParameters& end) noexcept
+{
+    blockSlot = publishedSlot.load (std::memory_order_acquire);
+    auto* newestTable = blockSlot >= 0 ? tables[blockSlot].get() : nullptr;
+
+    Source next;
+
+    if (mode == Mode::exact || isAntiderivative (mode))
+    {
+        next.method = mode;
+    }
+    else if (mode == Mode::table && start.drive == end.drive && start.threshold == end.threshold)
+    {
+        if (nonRealtime)
+        {
+            next.method = Mode::table;
+            next.table = getOfflineTable (start.drive, start.threshold);
+        }
+        else if (newestTable != nullptr && newestTable->matches (start.drive, start.threshold))
+        {
+            next.method = Mode::table;
+            next.table = newestTable;
+        }
+        else
+        {
+            requestTable (start.drive, start.threshold);
+        }
+    }
+
+    // The ADAA history is stale if it's been a while since it last ran
+    if (next.method != currentSource.method && isAntiderivative (next.method))
+        core.reset (toCurve (next.method));
+
+    crossfading = hasRun && next != currentSource;
+    previousSource = currentSource;
+    currentSource = next;
+    hasRun = true;
+}
+
+template <typename SampleType>
+void Waveshaper::process (SampleType* const* channels, int numChannels, int numSamples,
+                          const DistortionParameters& start, const DistortionParameters& end) noexcept
+{
+    jassert (numChannels <= maxChannels);
+
+    if (numSamples <= 0)
+        return;
+
+    // The newest input, for the methods that have to run a sample late (see setLatency)
+    double newestInputs[maxChannels];
+
+    if (latency > 0)
+        for (int channel = 0; channel < numChannels; ++channel)
+            newestInputs[channel] = (double) channels[channel][numSamples - 1];
+
+    if (! crossfading || crossfadeBuffer == nullptr || numSamples > crossfadeBufferSize || numChannels > crossfadeChannels)
+        run (currentSource, channels, numChannels, numSamples, start, end);
+    else
+        runCrossfaded (channels, numChannels, numSamples, start, end);
+
+    if (latency > 0)
+        std::copy (newestInputs, newestInputs + numChannels, lastInputs);
+}
+
+template <typename SampleType>
+void Waveshaper::delayUnshaped (SampleType* const* channels, int numChannels, int numSamples) noexcept
+{
+    if (latency == 0 || numSamples <= 0)
+        return;
+
+    numChannels = jmin (numChannels, maxChannels);
+
+    for (int channel = 0; channel < numChannels; ++channel)
+    {
+        auto newest = (double) channels[channel][numSamples - 1];
+        delayBySample (channels[channel], numSamples, lastInputs[channel]);
+        lastInputs[channel] = newest;
+    }
+}
+
+template <typename SampleType>
+void Waveshaper::runCrossfaded (SampleType* const* channels, int numChannels, int numSamples,
+                                const DistortionParameters& start, const DistortionParameters& end) noexcept
+{
+    // Run the old method on a copy, the new one in place, then fade from one to the other
+    SampleType* old[maxChannels];
+
+    for (int channel = 0; channel < numChannels; ++channel)
+    {
+        old[channel] = reinterpret_cast<SampleType*> (crossfadeBuffer + channel * crossfadeBufferSize);
+        FloatVectorOperations::copy (old[channel], channels[channel], numSamples);
+    }
+
+    run (previousSource, old, numChannels, numSamples, start, end);
+    run (currentSource, channels, numChannels, numSamples, start, end);
+
+    auto step = (SampleType) 1 / (SampleType) numSamples;
+
+    for (int channel = 0; channel < numChannels; ++channel)
+    {
+        auto* data = channels[channel];
+        auto* faded = old[channel];
+
+        for (int i = 0; i < numSamples; ++i)
+            data[i] = faded[i] + (SampleType) (i + 1) * step * (data[i] - faded[i]);
+    }
+}
+
+bool Waveshaper::setLatency (int newLatency) noexcept
+{
+    newLatency = jlimit (0, 1, newLatency);
+
+    if (newLatency == latency)
+        return false;
+
+    latency = newLatency;
+    std::fill (std::begin (lastInputs), std::end (lastInputs), 0.0);
+    return true;
+}
+
+double Waveshaper::getDelayInSamples() const noexcept
+{
+    switch (currentSource.method)
+    {
+        case Mode::adaaFirstOrder:      return latency + 0.5;
+        case Mode::adaaSecondOrder:     return 1.0;     // the latency, if there is one
+        case Mode::exact:
+        case Mode::fast:
+        case Mode::table:
+        default:                        return latency;
+    }
+}
+
+int Waveshaper::getTailLengthInSamples() const noexcept
+{
+    return jmax (latency, core.getTailLengthInSamples (toCurve (currentSource.method)));
+}
+
+void Waveshaper::reset() noexcept
+{
+    core.reset();
+}
+
+void Waveshaper::endBlock() noexcept
+{
+    // From here on the audio thread only looks at the newest table (if any),
+    // which frees the other slot for the builder.
+    crossfading = false;
+    slotInUse.store (blockSlot, std::memory_order_release);
+}
+
+template <typename SampleType>
+void Waveshaper::run (const Source& source, SampleType* const* channels, int numChannels, int numSamples,
+                      const DistortionParameters& start, const DistortionParameters& end) noexcept
+{
+    // Second order ADAA is a sample late by itself, everything else has to be held back
+    if (latency > 0 && source.method != Mode::adaaSecondOrder)
+        for (int channel = 0; channel < numChannels; ++channel)
+            delayBySample (channels[channel], numSamples, lastInputs[channel]);
+
+    if (source.method != Mode::table)
+    {
+        core.shape (toCurve (source.method), channels, numChannels, numSamples, start, end);
+        return;
+    }
+
+    for (int channel = 0; channel < numChannels; ++channel)
+        source.table->process (channels[channel], numSamples, start, end);
+}
+
+DistortionCore::Curve Waveshaper::toCurve (Mode method) noexcept
+{
+    switch (method)
+    {
+        case Mode::exact:               return DistortionCore::Curve::exact;
+        case Mode::adaaFirstOrder:      return DistortionCore::Curve::adaaFirstOrder;
+        case Mode::adaaSecondOrder:     return DistortionCore::Curve::adaaSecondOrder;
+        case Mode::fast:
+        case Mode::table:
+        default:                        return DistortionCore::Curve::fast;
+    }
+}
+
+//==============================================================================
+void Waveshaper::requestTable (float drive, float threshold) noexcept
+{
+    if (drive == lastRequestedDrive && threshold == lastRequestedThreshold)
+        return;
+
+    lastRequestedDrive = drive;
+    lastRequestedThreshold = threshold;
+
+    requestedDrive.store (drive, std::memory_order_relaxed);
+    requestedThreshold.store (threshold, std::memory_order_relaxed);
+    requestCounter.fetch_add (1, std::memory_order_release);
+}
+
+const TransferTable* Waveshaper::getOfflineTable (float drive, float threshold) noexcept
+{
+    if (offlineTable == nullptr || ! offlineTable->matches (drive, threshold))
+    {
+        previousOfflineTable = std::move (offlineTable);
+        offlineTable = getSharedTable (drive, threshold);
+    }
+
+    return offlineTable.get();
+}
+
+std::shared_ptr<const TransferTable> Waveshaper::getSharedTable (float drive, float threshold)
+{
+    // Another instance may already have built this one
+    return TableCache::getInstance().get ({ drive, threshold }, [drive, threshold]
+    {
+        TransferTable table;
+        table.build (drive, threshold);
+        return table;
+    });
+}
+
+int Waveshaper::useTimeSlice()
+{
+    auto request = requestCounter.load (std::memory_order_acquire);
+
+    if (request == builtCounter)
+        return 20;
+
+    // Wait until the audio thread has let go of the slot we'd write into
+    auto published = publishedSlot.load (std::memory_order_acquire);
+
+    if (published != slotInUse.load (std::memory_order_acquire))
+        return 5;
+
+    auto slot = published == 0 ? 1 : 0;
+    auto drive = requestedDrive.load (std::memory_order_relaxed);
+    auto threshold = requestedThreshold.load (std::memory_order_relaxed);
+
+    tables[slot] = getSharedTable (drive, threshold);
+
+    builtCounter = request;
+    publishedSlot.store (slot, std::memory_order_release);
+
+    return 5;
+}
+
+//==============================================================================
+template void Waveshaper::process (float* const*,  int, int, const DistortionParameters&, const DistortionParameters&) noexcept;
+template void Waveshaper::process (double* const*, int, int, const DistortionParameters&, const DistortionParameters&) noexcept;
+template void Waveshaper::delayUnshaped (float* const*,  int, int) noexcept;
+template void Waveshaper::delayUnshaped (double* const*, int, int) noexcept;
@@ -0,0 +1,184 @@
+/*
+  ==============================================================================
+
+    Waveshaper.h
+
+    Chooses how the distortion curve is evaluated for each block: the exact or
+    fast tanh kernel, a precomputed TransferTable, or the anti-aliased
+    AntiderivativeShaper. Tables are rebuilt on a background thread whenever
+    drive or threshold settle on new values and are handed to the audio
+    thread through a lock-free double buffer. Offline renders build them on
+    the audio thread instead, so they come out the same every time. Whenever
+    the evaluation method changes the old and new output are crossfaded over
+    one block, so switching is never audible as a click.
+
+    Everything except the tables is evaluated by the JUCE-free DistortionCore,
+    the tables stay here since they need a thread to be built on.
+
+    The tables themselves come from a SharedCache, so instances running with
+    the same drive and threshold share one table instead of each building and
+    storing their own.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "Core/DistortionCore.h"
+#include "Core/DistortionParameters.h"
+#include "SharedCache.h"
+#include "AudioArena.h"
+#include "Core/TransferTable.h"
+#include "Core/WaveshaperKernel.h"
+using namespace juce;
+
+//==============================================================================
+class Waveshaper  : private TimeSliceClient
+{
+public:
+    enum class Mode
+    {
+        exact,              // std::tanh
+        fast,               // Pade approximant
+        table,              // interpolated table, falling back to fast while drive or threshold move
+        adaaFirstOrder,     // std::tanh with antiderivative anti-aliasing, see AntiderivativeShaper
+        adaaSecondOrder
+    };
+
+    /** The most channels a single process() call can be given. */
+    static constexpr int maxChannels = 16;
+
+    Waveshaper();
+    ~Waveshaper() override;
+
+    /** maxSamplesPerCall is the longest span process() will be given (including oversampling). */
+    void prepare (int numChannels, int maxSamplesPerCall);
+
+    /** Takes the crossfade buffer for what prepare() was given, see AudioArena. */
+    void takeWorkingMemory (AudioArena& arena) noexcept;
+    void setMode (Mode newMode) noexcept        { mode = newMode; }
+
+    /** Audio thread, once per block. Offline, beginBlock() builds a missing table (or takes it
+        from the cache) then and there instead of asking the builder thread, so a render
+        doesn't depend on when that thread gets round to it.
+    */
+    void setNonRealtime (bool isNonRealtime) noexcept       { nonRealtime = isNonRealtime; }
+
+    /** Call once per block before processing any channels, with the values the
+        block will run with. This is where a new table gets picked up and where
+        a rebuild is requested if the current one is out of date.
+    */
+    void beginBlock (const DistortionParameters& start, const DistortionParameters& end) noexcept;
+
+    /** Distorts all the channels of a block in place. Instantiated for float and double. */
+    template <typename SampleType>
+    void process (SampleType* const* channels, int numChannels, int numSamples,
+                  const DistortionParameters& start, const DistortionParameters& end) noexcept;
+
+    /** Call once the block has been processed. */
+    void endBlock() noexcept;
+
+    /** Audio thread, once per block. Second order ADAA puts the whole output a sample late
+        (see AntiderivativeShaper), which the plugin reports as latency while the curve runs
+        at the host rate. While it does, pass 1 here: every other method, and delayUnshaped(),
+        is then held back by a sample as well, so Auto Quality stepping down from second
+        order doesn't move the output. Returns true if that changed the latency.
+    */
+    bool setLatency (int newLatency) noexcept;
+    int getLatencyInSamples() const noexcept        { return latency; }
+
+    /** How far the method picked by beginBlock() puts its output behind the input, in samples
+        at the rate it runs at: the latency, plus half a sample for first order ADAA. Inside
+        the oversampling that's a fraction of a host sample the dry signal has to match.
+    */
+    double getDelayInSamples() const noexcept;
+
+    /** Delays the channels by getLatencyInSamples() without shaping them, for host bypass
+        and for blocks that skip the curve altogether.
+    */
+    template <typename SampleType>
+    void delayUnshaped (SampleType* const* channels, int numChannels, int numSamples) noexcept;
+
+    /** The ADAA modes remember the last samples, the others have no tail beyond the latency. */
+    int getTailLengthInSamples() const noexcept;
+
+    /** Forgets the ADAA history, e.g. once the input has gone silent. The sample held
+        back for setLatency() stays, so bypass can go through delayUnshaped() and back.
+    */
+    void reset() noexcept;
+
+private:
+    //==============================================================================
+    struct Source
+    {
+        Mode method = Mode::fast;
+        const TransferTable* table = nullptr;
+
+        bool operator== (const Source& other) const noexcept    { return method == other.method && table == other.table; }
+        bool operator!= (const Source& other) const noexcept    { return ! operator== (other); }
+    };
+
+    template <typename SampleType>
+    void run (const Source& source, SampleType* const* channels, int numChannels, int numSamples,
+              const DistortionParameters& start, const DistortionParameters& end) noexcept;
+
+    template <typename SampleType>
+    void runCrossfaded (SampleType* const* channels, int numChannels, int numSamples,
+                        const DistortionParameters& start, const DistortionParameters& end) noexcept;
+
+    /** Moves the samples one along, with previous in front. */
+    template <typename SampleType>
+    static void delayBySample (SampleType* data, int numSamples, double previous) noexcept
+    {
+        std::copy_backward (data, data + numSamples - 1, data + numSamples);
+        data[0] = (SampleType) previous;
+    }
+
+    void requestTable (float drive, float threshold) noexcept;
+    const TransferTable* getOfflineTable (float drive, float threshold) noexcept;
+    int useTimeSlice() override;
+
+    static bool isAntiderivative (Mode method) noexcept     { return method == Mode::adaaFirstOrder || method == Mode::adaaSecondOrder; }
+    static DistortionCore::Curve toCurve (Mode method) noexcept;
+
+    //==============================================================================
+    // Double buffer shared with the builder thread. The builder only ever writes
+    // to the slot that isn't published, and only once the audio thread has
+    // confirmed (through slotInUse) that it has moved on to the published one,
+    // so a table is only ever released here, never on the audio thread.
+    using TableCache = SharedCache<std::pair<float, float>, TransferTable>;
+    static std::shared_ptr<const TransferTable> getSharedTable (float drive, float threshold);
+
+    std::shared_ptr<const TransferTable> tables[2];
+    std::atomic<int> publishedSlot { -1 }, slotInUse { -1 };
+    std::atomic<float> requestedDrive { 1.0f }, requestedThreshold { 1.0f };
+    std::atomic<uint32> requestCounter { 0 };
+    uint32 builtCounter = 0;
+
+    struct BuilderThread  : public TimeSliceThread
+    {
+        BuilderThread() : TimeSliceThread ("Transfer table builder")    { startThread (Thread::Priority::low); }
+        ~BuilderThread() override                                       { stopThread (2000); }
+    };
+
+    SharedResourcePointer<BuilderThread> builderThread;
+
+    //==============================================================================
+    // Audio thread state
+    Mode mode = Mode::fast;
+    Source currentSource, previousSource;
+    DistortionCore core;                    // the curve itself, and the ADAA history
+    int blockSlot = -1;
+    bool crossfading = false, hasRun = false, nonRealtime = false;
+    float lastRequestedDrive = -1.0f, lastRequestedThreshold = -1.0f;
+    // Offline only, so the audio thread may build and free these; the previous one is
+    // kept for as long as the crossfade away from it might still read it
+    std::shared_ptr<const TransferTable> offlineTable, previousOfflineTable;
+    double* crossfadeBuffer = nullptr;      // big enough for either sample type, from the arena
+    int crossfadeChannels = 0, crossfadeBufferSize = 0;
+    int latency = 0;
+    double lastInputs[maxChannels] = {};    // the last sample each channel was given, see setLatency
+
+    JUCE_DECLARE_NON_COPYABLE (Waveshaper)
+};